@@ -0,0 +1,54 @@
+QT       += core
+QT       += concurrent
+QT       -= gui
+
+CONFIG += c++17
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD/../Header-files_include
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    $$PWD/../Source-code_scr/aidecisionlog.cpp \
+    $$PWD/../Source-code_scr/boardstate.cpp \
+    $$PWD/../Source-code_scr/gamelogic.cpp \
+    $$PWD/../Source-code_scr/gamerecord.cpp \
+    $$PWD/../Source-code_scr/historyindex.cpp \
+    $$PWD/../Source-code_scr/leaderboard.cpp \
+    $$PWD/../Source-code_scr/mctsengine.cpp \
+    $$PWD/../Source-code_scr/metrics.cpp \
+    $$PWD/../Source-code_scr/ponderer.cpp \
+    $$PWD/../Source-code_scr/searchengine.cpp \
+    $$PWD/../Source-code_scr/tablebase.cpp \
+    $$PWD/../Source-code_scr/tracing.cpp \
+    $$PWD/../Source-code_scr/ultimateboard.cpp \
+    $$PWD/../Source-code_scr/ultimateengine.cpp \
+    $$PWD/../Source-code_scr/userauth.cpp \
+    benchmark_tool.cpp
+
+HEADERS += \
+    $$PWD/../Header-files_include/aidecisionlog.h \
+    $$PWD/../Header-files_include/boardstate.h \
+    $$PWD/../Header-files_include/gamelogic.h \
+    $$PWD/../Header-files_include/gamerecord.h \
+    $$PWD/../Header-files_include/gametypes.h \
+    $$PWD/../Header-files_include/historyindex.h \
+    $$PWD/../Header-files_include/leaderboard.h \
+    $$PWD/../Header-files_include/mctsengine.h \
+    $$PWD/../Header-files_include/metrics.h \
+    $$PWD/../Header-files_include/ponderer.h \
+    $$PWD/../Header-files_include/searchengine.h \
+    $$PWD/../Header-files_include/tablebase.h \
+    $$PWD/../Header-files_include/tracing.h \
+    $$PWD/../Header-files_include/ultimateboard.h \
+    $$PWD/../Header-files_include/ultimateengine.h \
+    $$PWD/../Header-files_include/userauth.h
+
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,421 @@
+// benchmark_tool.cpp - Runs the core benchmark workloads and compares them against a baseline
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include "boardstate.h"
+#include "gamelogic.h"
+#include "mctsengine.h"
+#include "searchengine.h"
+#include "userauth.h"
+
+namespace {
+// One batch of a workload; returns the number of operations it timed
+typedef std::function<int(QElapsedTimer& timer, qint64* elapsedNs)> Batch;
+
+struct Workload {
+    QString name;
+    QString description;
+    Batch batch;
+};
+
+struct Statistics {
+    double medianNs = 0;
+    double madNs = 0;     // Median absolute deviation from the median
+    QVector<double> samples;
+};
+
+double median(QVector<double> values) {
+    std::sort(values.begin(), values.end());
+    int count = values.size();
+    if (count == 0) {
+        return 0;
+    }
+    return (count % 2) ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+Statistics summarize(const QVector<double>& samples) {
+    // Median and MAD shrug off the odd run disturbed by the rest of the machine
+    Statistics stats;
+    stats.samples = samples;
+    stats.medianNs = median(samples);
+    QVector<double> deviations;
+    for (double sample : samples) {
+        deviations.append(std::fabs(sample - stats.medianNs));
+    }
+    stats.madNs = median(deviations);
+    return stats;
+}
+
+QString formatNs(double ns) {
+    if (ns >= 1e9) {
+        return QString::number(ns / 1e9, 'f', 3) + " s";
+    }
+    if (ns >= 1e6) {
+        return QString::number(ns / 1e6, 'f', 3) + " ms";
+    }
+    if (ns >= 1e3) {
+        return QString::number(ns / 1e3, 'f', 3) + " us";
+    }
+    return QString::number(ns, 'f', 1) + " ns";
+}
+
+// Random two-player games, the same ones on every run
+QVector<QVector<int>> scriptedGames(int count, int size) {
+    QRandomGenerator random(1234);
+    QVector<QVector<int>> games;
+    for (int game = 0; game < count; ++game) {
+        QVector<int> cells(size * size);
+        for (int i = 0; i < cells.size(); ++i) {
+            cells[i] = i;
+        }
+        std::shuffle(cells.begin(), cells.end(), random);
+        games.append(cells);
+    }
+    return games;
+}
+
+void removeUsersFile() {
+    QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QFile::remove(dataPath + "/users.json");
+    QDir(dataPath + "/history").removeRecursively();
+}
+
+// Gives a fresh users.json one user holding 499 games; returns a 500th to save
+QJsonObject seedUsersFile(UserAuth* auth, GameLogic* logic) {
+    auth->signUp("benchmark", "Benchmark1!");
+    auth->signIn("benchmark", "Benchmark1!");
+    logic->newGame(false);
+    logic->makeMove(0, 0);
+    QJsonArray games;
+    for (int i = 0; i < 499; ++i) {
+        games.append(logic->getGameAsJson());
+    }
+    auth->saveGamesToHistory(games);
+    return logic->getGameAsJson();
+}
+
+QVector<Workload> workloads() {
+    QVector<Workload> list;
+
+    list.append({"search.alphabeta.3x3", "Solve the empty 3x3 board from cold tables",
+                 [](QElapsedTimer& timer, qint64* elapsedNs) {
+        SearchEngine engine;
+        SearchLimits limits;
+        timer.start();
+        engine.search(BoardState(3, 3), limits);
+        *elapsedNs = timer.nsecsElapsed();
+        return 1;
+    }});
+
+    list.append({"search.alphabeta.4x4.depth6", "Six-ply search of the empty 4x4 board",
+                 [](QElapsedTimer& timer, qint64* elapsedNs) {
+        SearchEngine engine;
+        SearchLimits limits;
+        limits.maxDepth = 6;
+        timer.start();
+        engine.search(BoardState(4, 4), limits);
+        *elapsedNs = timer.nsecsElapsed();
+        return 1;
+    }});
+
+    list.append({"search.mcts.7x7", "2000 playouts on the empty 7x7 board, one thread",
+                 [](QElapsedTimer& timer, qint64* elapsedNs) {
+        MctsEngine engine;
+        MctsLimits limits;
+        limits.iterations = 2000;
+        timer.start();
+        engine.search(BoardState(7, 5), limits);
+        *elapsedNs = timer.nsecsElapsed();
+        return 1;
+    }});
+
+    list.append({"gamelogic.makeMove", "Two-player moves on 5x5 boards, per move",
+                 [](QElapsedTimer& timer, qint64* elapsedNs) {
+        static const QVector<QVector<int>> games = scriptedGames(50, 5);
+        GameLogic logic;
+        logic.setBoardSize(5, 4);
+        int movesMade = 0;
+        *elapsedNs = 0;
+        for (const QVector<int>& cells : games) {
+            logic.newGame(false);
+            timer.start();
+            for (int cell : cells) {
+                if (logic.isGameOver()) {
+                    break;
+                }
+                logic.makeMove(cell / 5, cell % 5);
+                ++movesMade;
+            }
+            *elapsedNs += timer.nsecsElapsed();
+        }
+        return movesMade;
+    }});
+
+    list.append({"json.roundtrip", "Game record to JSON text and back into GameLogic, per game",
+                 [](QElapsedTimer& timer, qint64* elapsedNs) {
+        static const QVector<QVector<int>> games = scriptedGames(50, 5);
+        GameLogic logic;
+        logic.setBoardSize(5, 4);
+        QVector<QJsonObject> records;
+        for (const QVector<int>& cells : games) {
+            logic.newGame(false);
+            for (int cell : cells) {
+                if (logic.isGameOver()) {
+                    break;
+                }
+                logic.makeMove(cell / 5, cell % 5);
+            }
+            records.append(logic.getGameAsJson());
+        }
+
+        timer.start();
+        for (const QJsonObject& record : std::as_const(records)) {
+            QByteArray text = QJsonDocument(record).toJson(QJsonDocument::Compact);
+            logic.loadFromJson(QJsonDocument::fromJson(text).object());
+        }
+        *elapsedNs = timer.nsecsElapsed();
+        return records.size();
+    }});
+
+    list.append({"persistence.save", "Save a game to a history of 500",
+                 [](QElapsedTimer& timer, qint64* elapsedNs) {
+        removeUsersFile();
+        UserAuth auth;
+        GameLogic logic;
+        QJsonObject game = seedUsersFile(&auth, &logic);
+
+        // Appends one line to the history and rewrites the accounts, as every finished game does
+        timer.start();
+        auth.saveGameToHistory(game);
+        *elapsedNs = timer.nsecsElapsed();
+        return 1;
+    }});
+
+    list.append({"persistence.load", "Read users.json and a history of 500 games",
+                 [](QElapsedTimer& timer, qint64* elapsedNs) {
+        {
+            removeUsersFile();
+            UserAuth auth;
+            GameLogic logic;
+            auth.saveGameToHistory(seedUsersFile(&auth, &logic));
+        }
+        timer.start();
+        UserAuth auth;
+        auth.waitForLoad();
+        *elapsedNs = timer.nsecsElapsed();
+        return 1;
+    }});
+
+    return list;
+}
+
+// Per-metric thresholds in the baseline win over the command line
+QJsonObject compare(const QMap<QString, Statistics>& current, const QJsonObject& baseline,
+                    double defaultThreshold, QTextStream& out, bool* regressed) {
+    QJsonObject baseMetrics = baseline["metrics"].toObject();
+    QJsonObject report;
+    *regressed = false;
+
+    out << QString("%1 %2 %3 %4  %5\n").arg("metric", -30).arg("baseline", 12).arg("current", 12)
+                                       .arg("change", 8).arg("status");
+    for (auto it = current.constBegin(); it != current.constEnd(); ++it) {
+        const Statistics& stats = it.value();
+        QJsonObject entry;
+        entry["medianNs"] = stats.medianNs;
+        entry["madNs"] = stats.madNs;
+
+        QString status;
+        QString baseText = "-";
+        QString changeText = "-";
+        if (!baseMetrics.contains(it.key())) {
+            status = "new";
+        } else {
+            QJsonObject base = baseMetrics[it.key()].toObject();
+            double baseMedian = base["medianNs"].toDouble();
+            double baseMad = base["madNs"].toDouble();
+            double threshold = base.contains("threshold") ? base["threshold"].toDouble() : defaultThreshold;
+            double change = baseMedian > 0 ? (stats.medianNs - baseMedian) / baseMedian : 0;
+            baseText = formatNs(baseMedian);
+            changeText = QString("%1%2%").arg(change >= 0 ? "+" : "").arg(change * 100, 0, 'f', 1);
+
+            // Slower by more than the threshold and by more than the runs' own scatter
+            double noise = 3 * qMax(baseMad, stats.madNs);
+            if (change > threshold && stats.medianNs - baseMedian > noise) {
+                status = QString("REGRESSED (limit +%1%)").arg(threshold * 100, 0, 'f', 0);
+                *regressed = true;
+            } else if (change < -threshold && baseMedian - stats.medianNs > noise) {
+                status = "faster";
+            } else {
+                status = "ok";
+            }
+            entry["baselineMedianNs"] = baseMedian;
+            entry["change"] = change;
+        }
+        entry["status"] = status;
+        report[it.key()] = entry;
+
+        out << QString("%1 %2 %3 %4  %5\n").arg(it.key(), -30).arg(baseText, 12)
+                                           .arg(formatNs(stats.medianNs), 12).arg(changeText, 8).arg(status);
+    }
+
+    for (auto it = baseMetrics.constBegin(); it != baseMetrics.constEnd(); ++it) {
+        if (!current.contains(it.key())) {
+            out << QString("%1 %2 %3 %4  %5\n").arg(it.key(), -30)
+                                               .arg(formatNs(it.value().toObject()["medianNs"].toDouble()), 12)
+                                               .arg("-", 12).arg("-", 8).arg("not run");
+        }
+    }
+    return report;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("Benchmark_Tool");
+    // users.json for the persistence workloads goes to a scratch location
+    QStandardPaths::setTestModeEnabled(true);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs the engine, game logic, JSON and persistence workloads, "
+                                     "summarizes each by its median and median absolute deviation, "
+                                     "and exits with 1 if any is slower than the baseline allows.");
+    parser.addHelpOption();
+    QCommandLineOption runsOption("runs", "Timed runs of each workload, after one warm-up.", "count", "9");
+    QCommandLineOption baselineOption("baseline", "Baseline file to compare against.", "file",
+                                      "Benchmark_Tool/baseline.json");
+    QCommandLineOption thresholdOption("threshold", "Allowed slowdown in percent, unless the baseline sets one.",
+                                       "percent", "10");
+    QCommandLineOption updateOption("update-baseline", "Write this run's results as the new baseline.");
+    QCommandLineOption filterOption("filter", "Only run workloads whose name contains this.", "text");
+    QCommandLineOption outputOption("output", "Also write the comparison as JSON.", "file");
+    QCommandLineOption listOption("list", "List the workloads and exit.");
+    parser.addOption(runsOption);
+    parser.addOption(baselineOption);
+    parser.addOption(thresholdOption);
+    parser.addOption(updateOption);
+    parser.addOption(filterOption);
+    parser.addOption(outputOption);
+    parser.addOption(listOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QVector<Workload> all = workloads();
+    if (parser.isSet(listOption)) {
+        for (const Workload& workload : all) {
+            out << QString("%1 %2\n").arg(workload.name, -30).arg(workload.description);
+        }
+        return 0;
+    }
+
+    int runs = parser.value(runsOption).toInt();
+    double threshold = parser.value(thresholdOption).toDouble() / 100.0;
+    if (runs < 3 || threshold <= 0) {
+        err << "Use at least 3 runs and a positive threshold\n";
+        return 2;
+    }
+
+    QMap<QString, Statistics> results;
+    for (const Workload& workload : all) {
+        if (parser.isSet(filterOption) && !workload.name.contains(parser.value(filterOption))) {
+            continue;
+        }
+        out << "Running " << workload.name << "\n";
+        out.flush();
+
+        QVector<double> samples;
+        for (int run = 0; run <= runs; ++run) {
+            QElapsedTimer timer;
+            qint64 elapsedNs = 0;
+            int operations = workload.batch(timer, &elapsedNs);
+            if (run > 0 && operations > 0) {
+                samples.append(double(elapsedNs) / operations);
+            }
+        }
+        results[workload.name] = summarize(samples);
+    }
+
+    QString baselinePath = parser.value(baselineOption);
+    if (parser.isSet(updateOption)) {
+        // Keep any per-metric thresholds someone set by hand
+        QFile existing(baselinePath);
+        QJsonObject oldMetrics;
+        if (existing.open(QIODevice::ReadOnly)) {
+            oldMetrics = QJsonDocument::fromJson(existing.readAll()).object()["metrics"].toObject();
+        }
+
+        QJsonObject metrics;
+        for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+            QJsonObject entry;
+            entry["medianNs"] = it.value().medianNs;
+            entry["madNs"] = it.value().madNs;
+            QJsonObject old = oldMetrics[it.key()].toObject();
+            if (old.contains("threshold")) {
+                entry["threshold"] = old["threshold"];
+            }
+            metrics[it.key()] = entry;
+        }
+        QJsonObject baseline;
+        baseline["runs"] = runs;
+        baseline["metrics"] = metrics;
+
+        QDir().mkpath(QFileInfo(baselinePath).absolutePath());
+        QSaveFile file(baselinePath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            err << "Cannot write " << baselinePath << "\n";
+            return 2;
+        }
+        file.write(QJsonDocument(baseline).toJson());
+        if (!file.commit()) {
+            err << "Cannot write " << baselinePath << "\n";
+            return 2;
+        }
+        out << "Baseline written to " << baselinePath << "\n";
+        return 0;
+    }
+
+    QFile file(baselinePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        err << "No baseline at " << baselinePath << ", record one with --update-baseline\n";
+        return 2;
+    }
+    QJsonParseError parseError;
+    QJsonObject baseline = QJsonDocument::fromJson(file.readAll(), &parseError).object();
+    if (parseError.error != QJsonParseError::NoError) {
+        err << "Baseline " << baselinePath << " is not valid JSON: " << parseError.errorString() << "\n";
+        return 2;
+    }
+
+    bool regressed = false;
+    QJsonObject report = compare(results, baseline, threshold, out, &regressed);
+    if (parser.isSet(outputOption)) {
+        QFile output(parser.value(outputOption));
+        if (output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            output.write(QJsonDocument(QJsonObject{{"metrics", report}}).toJson());
+        } else {
+            err << "Cannot write " << output.fileName() << "\n";
+        }
+    }
+
+    if (regressed) {
+        err << "Slower than the baseline allows\n";
+        return 1;
+    }
+    return 0;
+}
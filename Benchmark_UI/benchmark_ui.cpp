@@ -0,0 +1,333 @@
+// benchmark_ui.cpp - Times the main window's hot paths on an offscreen display
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include "mainwindow.h"
+#include "userauth.h"
+#include "gamelogic.h"
+#include "boardwidget.h"
+
+namespace {
+// Every allocation in the process, pool threads included
+std::atomic<qint64> allocationCount(0);
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocationCount;
+    if (void* block = std::malloc(size ? size : 1)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+// Drives MainWindow through its private members, like the integration tests do
+class UiBenchmark : public QObject {
+public:
+    UiBenchmark(int iterations, int historyGames);
+
+    QJsonObject run();
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    struct Operation {
+        QVector<qint64> nanoseconds;
+        qint64 allocations = 0;
+        qint64 polishEvents = 0;
+    };
+
+    int iterations;
+    int historyGames;
+    qint64 polishCount;
+    QMap<QString, Operation> operations;
+
+    void time(const QString& name, const std::function<void()>& body);
+    QJsonArray playedGames(int count) const;
+    void benchmarkPages(MainWindow& window);
+    void benchmarkBoard(MainWindow& window);
+    void benchmarkHistory(MainWindow& window);
+    void benchmarkReplay(MainWindow& window);
+    static QJsonObject summarize(const Operation& operation);
+};
+
+UiBenchmark::UiBenchmark(int iterationCount, int gameCount) : iterations(iterationCount),
+historyGames(gameCount), polishCount(0) {
+}
+
+bool UiBenchmark::eventFilter(QObject* watched, QEvent* event)
+{
+    // A polish is a stylesheet pass over the widget, the cost styled pages pay on every change
+    if (event->type() == QEvent::Polish || event->type() == QEvent::PolishRequest
+        || event->type() == QEvent::StyleChange) {
+        ++polishCount;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void UiBenchmark::time(const QString& name, const std::function<void()>& body)
+{
+    Operation& operation = operations[name];
+    qint64 allocationsBefore = allocationCount.load();
+    qint64 polishBefore = polishCount;
+    QElapsedTimer timer;
+    timer.start();
+    body();
+    operation.nanoseconds.append(timer.nsecsElapsed());
+    operation.allocations += allocationCount.load() - allocationsBefore;
+    operation.polishEvents += polishCount - polishBefore;
+}
+
+QJsonArray UiBenchmark::playedGames(int count) const
+{
+    // Random two-player games on the classic board, played to the end
+    QRandomGenerator random(2024);
+    GameLogic logic;
+    QJsonArray games;
+    for (int game = 0; game < count; ++game) {
+        logic.newGame(false);
+        while (!logic.isGameOver()) {
+            int cell = random.bounded(9);
+            logic.makeMove(cell / 3, cell % 3);
+        }
+        games.append(logic.getGameAsJson());
+    }
+    return games;
+}
+
+void UiBenchmark::benchmarkPages(MainWindow& window)
+{
+    // The first visit builds the page, later ones only switch to it
+    time("page.build.menu", [&]() { window.showMenuPage(); });
+    time("page.build.gameMode", [&]() { window.showGameModePage(); });
+    for (int i = 0; i < iterations; ++i) {
+        time("page.switch.menu", [&]() {
+            window.showMenuPage();
+            QCoreApplication::processEvents();
+        });
+        time("page.switch.gameMode", [&]() {
+            window.showGameModePage();
+            QCoreApplication::processEvents();
+        });
+    }
+}
+
+void UiBenchmark::benchmarkBoard(MainWindow& window)
+{
+    time("page.build.game", [&]() { window.startTwoPlayerGame(); });
+    QCoreApplication::processEvents();
+
+    BoardChange reset;
+    reset.reset = true;
+    reset.playerChanged = true;
+    for (int i = 0; i < iterations; ++i) {
+        time("updateBoard.reset", [&]() { window.updateBoard(reset); });
+    }
+
+    BoardChange single;
+    single.cells.append(4);
+    single.playerChanged = true;
+    for (int i = 0; i < iterations; ++i) {
+        time("updateBoard.cell", [&]() { window.updateBoard(single); });
+    }
+
+    // A whole move as the player sees it: click, queued board change, repaint
+    QRandomGenerator random(7);
+    for (int i = 0; i < iterations; ++i) {
+        if (window.gameLogic->isGameOver()) {
+            window.startTwoPlayerGame();
+            QCoreApplication::processEvents();
+        }
+        int cell = random.bounded(9);
+        if (window.gameLogic->getCell(cell / 3, cell % 3) != Player::None) {
+            continue;
+        }
+        time("game.move", [&]() {
+            window.handleCellClicked(cell / 3, cell % 3);
+            QCoreApplication::processEvents();
+        });
+    }
+}
+
+void UiBenchmark::benchmarkHistory(MainWindow& window)
+{
+    time("page.build.history", [&]() { window.showHistoryPage(); });
+    for (int i = 0; i < iterations; ++i) {
+        time("loadGameHistory", [&]() {
+            window.loadGameHistory();
+            QCoreApplication::processEvents();
+        });
+    }
+    for (int i = 0; i < iterations; ++i) {
+        time("applyHistoryFilter", [&]() {
+            window.historyFilterEdit->setText(i % 2 ? "win" : "tie");
+        });
+    }
+    window.historyFilterEdit->clear();
+}
+
+void UiBenchmark::benchmarkReplay(MainWindow& window)
+{
+    window.gamesList->setCurrentIndex(window.historyModel->index(0));
+    window.loadSelectedGame();
+    int moves = window.replayLogic->getMoves().size();
+
+    // Scrub back and forth across the whole game
+    for (int i = 0; i < iterations; ++i) {
+        int value = i % (2 * moves + 1);
+        value = value > moves ? 2 * moves - value : value;
+        time("updateReplay", [&]() { window.updateReplay(value); });
+        time("updateReplayBoard", [&]() { window.updateReplayBoard(); });
+    }
+}
+
+QJsonObject UiBenchmark::summarize(const Operation& operation)
+{
+    QVector<qint64> sorted = operation.nanoseconds;
+    std::sort(sorted.begin(), sorted.end());
+    qint64 total = 0;
+    for (qint64 ns : std::as_const(sorted)) {
+        total += ns;
+    }
+
+    int count = sorted.size();
+    QJsonObject json;
+    json["count"] = count;
+    json["meanUs"] = total / 1000.0 / count;
+    json["medianUs"] = sorted[count / 2] / 1000.0;
+    json["p95Us"] = sorted[qMin(count - 1, count * 95 / 100)] / 1000.0;
+    json["maxUs"] = sorted.last() / 1000.0;
+    json["allocationsPerOp"] = double(operation.allocations) / count;
+    json["polishEventsPerOp"] = double(operation.polishEvents) / count;
+    return json;
+}
+
+QJsonObject UiBenchmark::run()
+{
+    qApp->installEventFilter(this);
+
+    // Sign in through the login page, as a player would
+    UserAuth auth;
+    QString username = "benchmark";
+    QString password = "Benchmark1!";
+    if (!auth.signIn(username, password)) {
+        auth.signUp(username, password);
+    }
+    auth.signOut();
+
+    MainWindow window(&auth);
+    window.resize(800, 600);
+    window.show();
+    QCoreApplication::processEvents();
+
+    window.loginUsername->setText(username);
+    window.loginPassword->setText(password);
+    time("signIn", [&]() { window.handleLogin(); });
+    if (!auth.isLoggedIn()) {
+        return QJsonObject();
+    }
+    if (auth.getGameHistory().size() < historyGames) {
+        auth.saveGamesToHistory(playedGames(historyGames - auth.getGameHistory().size()));
+    }
+
+    benchmarkPages(window);
+    benchmarkBoard(window);
+    benchmarkHistory(window);
+    benchmarkReplay(window);
+    qApp->removeEventFilter(this);
+
+    QJsonObject results;
+    for (auto it = operations.constBegin(); it != operations.constEnd(); ++it) {
+        results[it.key()] = summarize(it.value());
+    }
+
+    QJsonObject json;
+    json["platform"] = QGuiApplication::platformName();
+    json["qtVersion"] = QString(qVersion());
+    json["iterations"] = iterations;
+    json["historyGames"] = auth.getGameHistory().size();
+    json["results"] = results;
+    return json;
+}
+
+int main(int argc, char *argv[])
+{
+    // No display needed; an explicit QT_QPA_PLATFORM still wins
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("Benchmark_UI");
+    // Users and history go to a scratch location, never the player's own files
+    QStandardPaths::setTestModeEnabled(true);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Signs in, plays, loads history and scrubs a replay in the main "
+                                     "window, timing each step and counting stylesheet polishes and "
+                                     "allocations. Results are written as JSON.");
+    parser.addHelpOption();
+    QCommandLineOption iterationsOption("iterations", "Samples taken of each operation.", "count", "200");
+    QCommandLineOption gamesOption("games", "Games in the signed-in player's history.", "count", "1000");
+    QCommandLineOption outputOption("output", "File the results are written to.", "file", "benchmark_ui.json");
+    parser.addOption(iterationsOption);
+    parser.addOption(gamesOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    int games = qMax(1, parser.value(gamesOption).toInt());
+    UiBenchmark benchmark(iterations, games);
+    QJsonObject json = benchmark.run();
+    if (json.isEmpty()) {
+        err << "Could not sign in the benchmark user\n";
+        return 1;
+    }
+
+    QJsonObject results = json["results"].toObject();
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        QJsonObject result = it.value().toObject();
+        out << QString("%1 median %2 us, p95 %3 us, %4 allocations, %5 polishes\n")
+                   .arg(it.key(), -22)
+                   .arg(result["medianUs"].toDouble(), 0, 'f', 1)
+                   .arg(result["p95Us"].toDouble(), 0, 'f', 1)
+                   .arg(result["allocationsPerOp"].toDouble(), 0, 'f', 0)
+                   .arg(result["polishEventsPerOp"].toDouble(), 0, 'f', 1);
+    }
+
+    QFile file(parser.value(outputOption));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        err << "Cannot write " << file.fileName() << "\n";
+        return 1;
+    }
+    file.write(QJsonDocument(json).toJson());
+    out << "Results written to " << file.fileName() << "\n";
+    return 0;
+}
@@ -1,4 +1,4 @@
-QT += core gui
+QT += core gui concurrent
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 CONFIG += c++17
@@ -9,14 +9,60 @@ INCLUDEPATH += $$PWD/Header-files_include
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
-HEADERS += Header-files_include/gamelogic.h \
+HEADERS += Header-files_include/aidecisionlog.h \
+           Header-files_include/boardstate.h \
+           Header-files_include/boardwidget.h \
+           Header-files_include/gameanalyzer.h \
+           Header-files_include/gameimporter.h \
+           Header-files_include/gamelogic.h \
+           Header-files_include/gamerecord.h \
+           Header-files_include/gametypes.h \
+           Header-files_include/historyindex.h \
+           Header-files_include/historylistmodel.h \
+           Header-files_include/historystreamer.h \
+           Header-files_include/latencytracker.h \
+           Header-files_include/leaderboard.h \
            Header-files_include/mainwindow.h \
+           Header-files_include/matchmaker.h \
+           Header-files_include/metrics.h \
+           Header-files_include/mctsengine.h \
+           Header-files_include/mpmcqueue.h \
+           Header-files_include/ponderer.h \
+           Header-files_include/searchengine.h \
+           Header-files_include/startuptimings.h \
+           Header-files_include/tablebase.h \
+           Header-files_include/thumbnailcache.h \
+           Header-files_include/tracing.h \
+           Header-files_include/ultimateboard.h \
+           Header-files_include/ultimateengine.h \
            Header-files_include/userauth.h
 
-SOURCES += Source-code_scr/gamelogic.cpp \
+SOURCES += Source-code_scr/aidecisionlog.cpp \
+           Source-code_scr/boardstate.cpp \
+           Source-code_scr/boardwidget.cpp \
+           Source-code_scr/gameanalyzer.cpp \
+           Source-code_scr/gameimporter.cpp \
+           Source-code_scr/gamelogic.cpp \
+           Source-code_scr/gamerecord.cpp \
+           Source-code_scr/historyindex.cpp \
+           Source-code_scr/historylistmodel.cpp \
+           Source-code_scr/historystreamer.cpp \
+           Source-code_scr/latencytracker.cpp \
+           Source-code_scr/leaderboard.cpp \
            Source-code_scr/main.cpp \
            Source-code_scr/mainwindow.cpp \
+           Source-code_scr/matchmaker.cpp \
+           Source-code_scr/metrics.cpp \
+           Source-code_scr/mctsengine.cpp \
+           Source-code_scr/ponderer.cpp \
+           Source-code_scr/searchengine.cpp \
+           Source-code_scr/startuptimings.cpp \
+           Source-code_scr/tablebase.cpp \
            Source-code_scr/test_gamelogic.cpp \
+           Source-code_scr/thumbnailcache.cpp \
+           Source-code_scr/tracing.cpp \
+           Source-code_scr/ultimateboard.cpp \
+           Source-code_scr/ultimateengine.cpp \
            Source-code_scr/userauth.cpp
 
 FORMS += ui/mainwindow.ui
@@ -0,0 +1,66 @@
+// aidecisionlog.h - Per-move AI statistics and a rolling log of them
+#ifndef AIDECISIONLOG_H
+#define AIDECISIONLOG_H
+
+#include <QString>
+#include <QVector>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QMetaType>
+#include "gametypes.h"
+
+struct AICandidate {
+    int cell = -1;
+    double score = 0.0;      // Search score, or win rate for Monte Carlo
+    bool upperBound = false; // Alpha-beta only proved the score is no higher
+    qint64 visits = 0;       // Monte Carlo only
+};
+
+// Everything the AI did for one move
+struct AIDecisionStats {
+    QDateTime timestamp;
+    int moveNumber = 0;           // Moves on the board before the AI played
+    QString backend;              // "alphabeta", "mcts", "tablebase", "ultimate" or "random"
+    AIDifficulty difficulty = AIDifficulty::Medium;
+    bool randomMove = false;      // shouldUseOptimalMove() chose the random branch
+    int cell = -1;
+    int boardSize = 3;
+    qint64 nodes = 0;             // Nodes searched, or playouts for Monte Carlo
+    int depth = 0;                // Deepest completed iteration
+    qint64 cacheHits = 0;         // Transposition table hits, or reused trees
+    bool timedOut = false;
+    bool pondered = false;        // Searched during the human's turn
+    qint64 searchMs = 0;          // Time spent inside the engine, or taking over the pondered result
+    qint64 ponderMs = 0;          // The pondered search's own time, 0 when not pondered
+    qint64 wallMs = 0;            // Whole decision, including setup
+    QVector<int> principalVariation;
+    QVector<AICandidate> candidates;
+
+    QJsonObject toJson() const;
+};
+
+Q_DECLARE_METATYPE(AIDecisionStats)
+
+// Appends one JSON line per decision. When the file would grow past the size
+// limit it is renamed to path.1 (older files shift to path.2 and so on) and
+// a new one is started, so the log never takes more than maxFiles + 1 files.
+class AIDecisionLog {
+public:
+    AIDecisionLog();
+
+    void setPath(const QString& path); // Empty disables logging
+    QString path() const;
+    void setMaxBytes(qint64 bytes);
+    void setMaxFiles(int count);
+
+    bool append(const AIDecisionStats& stats);
+
+private:
+    QString filePath;
+    qint64 maxBytes;
+    int maxFiles;
+
+    void rotate();
+};
+
+#endif // AIDECISIONLOG_H
@@ -0,0 +1,54 @@
+// boardstate.h - Compact bitboard for N x N, k-in-a-row positions
+#ifndef BOARDSTATE_H
+#define BOARDSTATE_H
+
+#include <QtGlobal>
+#include <QVector>
+#include "gametypes.h"
+
+// One 64-bit mask per player, cell index = row * size + col. X always moves
+// first, so the side to move follows from the number of stones. play() and
+// undo() are O(1) and keep a Zobrist hash up to date for search tables.
+class BoardState {
+public:
+    static const int MaxSize = 8;
+
+    explicit BoardState(int size = 3, int winLength = 3);
+
+    int size() const { return n; }
+    int winLength() const { return k; }
+    int cellCount() const { return n * n; }
+    int moveCount() const { return plies; }
+
+    Player at(int cell) const;
+    Player at(int row, int col) const { return at(row * n + col); }
+    Player toMove() const { return (plies % 2 == 0) ? Player::X : Player::O; }
+    quint64 stones(Player player) const { return player == Player::X ? xBits : oBits; }
+    quint64 emptyCells() const { return fullMask & ~(xBits | oBits); }
+    bool isFull() const { return (xBits | oBits) == fullMask; }
+    quint64 hash() const { return zobrist; }
+
+    void play(int cell);  // Places a stone for the side to move
+    void undo(int cell);  // Takes back the stone on cell, which must be the last one played
+
+    bool wins(int cell) const;        // Does the stone on cell complete a line?
+    bool winsFor(int cell, Player player) const; // Would a stone for player on cell complete one?
+    Player findWinner() const;        // Full scan, for positions not built move by move
+
+    // Masks of every k-long window on the board, shared by all boards of the same shape
+    static const QVector<quint64>& windows(int size, int winLength);
+
+private:
+    int n;
+    int k;
+    int plies;
+    quint64 xBits;
+    quint64 oBits;
+    quint64 fullMask;
+    quint64 zobrist;
+
+    int runLength(int row, int col, int dRow, int dCol, quint64 bits) const;
+    bool completesLine(int cell, quint64 bits) const;
+};
+
+#endif // BOARDSTATE_H
@@ -0,0 +1,78 @@
+// boardwidget.h - Custom-painted game board for the live and replay pages
+#ifndef BOARDWIDGET_H
+#define BOARDWIDGET_H
+
+#include <QWidget>
+#include <QVector>
+#include <QPixmap>
+#include <QColor>
+#include "gametypes.h"
+
+class QPainter;
+
+// Paints an N x N board from three cached tiles (X, O and empty) instead of
+// one styled button per cell. Setters compare against what is on screen and
+// only schedule a repaint of the cells that changed, and clicks are mapped to
+// cells here. Ultimate games add the 3x3 board outlines, the board the mover
+// was sent to and the boards already won.
+class BoardWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit BoardWidget(int boardPixels, QWidget* parent = nullptr);
+
+    void setBoardSize(int size); // Clears the board when the size changes
+    int boardSize() const;
+    void setCell(int row, int col, Player player);
+    Player cell(int row, int col) const;
+    void setInteractive(bool interactive); // Replay boards ignore clicks and hover
+
+    void setHint(int row, int col, const QColor& color); // Invalid color removes it
+
+    void setSubBoards(bool enabled);       // Draw the 3x3 grid of boards (ultimate)
+    void setForcedBoard(int board);        // -1 when the mover may pick any board
+    void setSubBoardWinner(int board, Player winner);
+
+    QRect cellRect(int row, int col) const;
+    int cellAt(const QPoint& pos) const;   // row * size + col, -1 between or outside cells
+    QSize sizeHint() const override;
+
+signals:
+    void cellClicked(int row, int col);
+    void framePainted(); // After each paint, for input-to-paint latency
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void leaveEvent(QEvent* event) override;
+
+private:
+    int pixels;
+    int size;
+    bool interactive;
+    bool subBoards;
+    int forcedBoard;
+    int hoveredCell;
+    QVector<Player> cells;
+    QVector<QColor> hints;
+    QVector<Player> subBoardWinners;
+
+    // Tiles rendered once per cell size
+    int tileSide;
+    QPixmap xTile;
+    QPixmap oTile;
+    QPixmap emptyTile;
+    QPixmap hoverTile;
+
+    int cellSide() const;
+    int gap() const;
+    void renderTiles();
+    QPixmap renderTile(const QColor& top, const QColor& bottom, const QColor& border, Player mark) const;
+    void updateCell(int index);
+    void paintSubBoards(QPainter& painter, const QRect& dirty);
+    QRect subBoardRect(int board) const;
+};
+
+#endif // BOARDWIDGET_H
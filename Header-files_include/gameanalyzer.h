@@ -0,0 +1,97 @@
+// gameanalyzer.h - Post-game analysis of a whole history on a thread pool
+#ifndef GAMEANALYZER_H
+#define GAMEANALYZER_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include "gametypes.h"
+
+// One move, scored by the side that played it
+struct MoveAnalysis {
+    int cell = -1;              // row * size + col on the grid the user sees
+    Player player = Player::None;
+    int before = 0;             // Best score on offer before the move
+    int after = 0;              // Score of the move played
+    int bestCell = -1;
+    bool accurate = false;      // Kept the best result the position offered
+    bool blunder = false;       // Turned a position that was not lost into a lost one
+    bool missedWin = false;     // Let a won position go
+};
+
+// Summary of one game, small enough to keep for every game in a history.
+// Arrays are indexed X then O.
+struct GameAnalysis {
+    bool valid = false;         // False for records that cannot be replayed
+    int moves[2] = {0, 0};
+    int accurate[2] = {0, 0};
+    int blunders[2] = {0, 0};
+    int missedWins[2] = {0, 0};
+
+    int accuracy(Player player) const; // Percent of that side's moves, -1 when it never moved
+};
+
+// Every position before a move is searched once with every reply scored,
+// which gives the value before the move and the value of the move played.
+// Boards the search depth covers, 3x3 included, are solved exactly; on
+// larger boards a "result" is only what the search sees within its depth.
+// Games are analyzed in batches on a private pool, each batch reusing one
+// engine so positions shared between games come from its table. Summaries
+// are kept by game and written to a cache file, so no game is analyzed twice.
+class GameAnalyzer : public QObject {
+    Q_OBJECT
+
+public:
+    static const int DefaultSearchDepth = 4;
+
+    explicit GameAnalyzer(QObject* parent = nullptr);
+    ~GameAnalyzer();
+
+    void setSearchDepth(int plies);           // Boards larger than 3x3 and ultimate; clears the cache
+    int searchDepth() const;
+    void setCacheFile(const QString& path);   // Loads what an earlier run saved, empty keeps it in memory
+    void setThreadCount(int count);
+
+    static QString gameKey(const QJsonObject& record);
+    static GameAnalysis analyzeGame(const QJsonObject& record, int searchDepth,
+                                    QVector<MoveAnalysis>* details = nullptr);
+
+    // Queues every game not analyzed yet. Results arrive on this object's thread.
+    void analyze(const QVector<QJsonObject>& records);
+    void cancel();                            // Queued games are dropped, the ones being searched stop
+    void waitForFinished();                   // Results delivered too; on this object's thread only
+    bool isRunning() const;
+
+    bool contains(const QString& key) const;
+    GameAnalysis analysis(const QString& key) const;
+    int cachedGames() const;
+    qint64 analyzedGames() const;             // Searched rather than found in the cache
+    bool saveCache();                         // Done when a run ends; only if something changed
+
+signals:
+    void progress(int done, int total);
+    void finished(bool cancelled);
+
+private:
+    int depth;
+    QString cachePath;
+    QThreadPool pool;
+    QHash<QString, GameAnalysis> results;    // This object's thread only
+    QSet<QString> pending;
+    QSharedPointer<std::atomic<bool>> stopFlag; // One per run, so a cancelled run cannot be restarted by the next
+    int runDone;
+    int runTotal;
+    bool unsaved;
+    std::atomic<qint64> analyzedCount;
+
+    void loadCache();
+    void deliver(const QSharedPointer<std::atomic<bool>>& run, const QString& key, const GameAnalysis& result);
+    void finishRun(bool cancelled);
+};
+
+#endif // GAMEANALYZER_H
@@ -0,0 +1,53 @@
+// gameimporter.h - Parallel bulk validation and import of game records
+#ifndef GAMEIMPORTER_H
+#define GAMEIMPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QJsonArray>
+#include <QJsonObject>
+#include "gamerecord.h"
+
+class UserAuth;
+
+struct ImportIssue {
+    int index;     // Position of the record in the input, -1 for import-wide problems
+    QString error;
+};
+
+struct ImportReport {
+    int total = 0;
+    int accepted = 0;  // Valid records, including repaired ones
+    int repaired = 0;  // Records whose stored result was rewritten
+    int rejected = 0;
+    int committed = 0; // Records written to the user's history
+    QVector<ImportIssue> issues;
+};
+
+class GameImporter : public QObject {
+    Q_OBJECT
+
+public:
+    explicit GameImporter(QObject* parent = nullptr);
+
+    void setBatchSize(int size);
+    void setRepairResults(bool repair); // Rewrite a wrong "result" instead of rejecting the record
+
+    // Validates every record on the global thread pool. Accepted records are
+    // returned in input order with their "result" re-derived from the moves.
+    ImportReport validate(const QJsonArray& records, QVector<QJsonObject>* accepted) const;
+
+    // Validates, then appends accepted records to the signed-in user's history
+    // one batch at a time so the history file is appended to once per batch.
+    ImportReport importToHistory(const QJsonArray& records, UserAuth* auth);
+
+signals:
+    void progress(int committed, int total);
+
+private:
+    int batchSize;
+    bool repairResults;
+};
+
+#endif // GAMEIMPORTER_H
@@ -7,32 +7,42 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDateTime>
+#include <QFuture>
+#include <QHash>
+#include <atomic>
+#include <memory>
+#include "gametypes.h"
+#include "searchengine.h"
+#include "mctsengine.h"
+#include "aidecisionlog.h"
+#include "ultimateboard.h"
+#include "ultimateengine.h"
+#include "ponderer.h"
 
-enum class Player {
-    None,
-    X,
-    O
-};
-enum class AIDifficulty {
-    Easy,     // Makes optimal move 30% of the time
-    Medium,   // Makes optimal move 50% of the time
-    Hard,     // Makes optimal move 80% of the time
-    Unbeatable // Makes optimal move 100% of the time
+// Everything that changed since the previous boardChanged() signal
+struct BoardChange {
+    bool reset = false;              // A new or loaded game, possibly of another size; redraw it all
+    QVector<int> cells;              // row * size + col of each cell whose owner changed, empty on reset
+    bool playerChanged = false;
+    bool resultChanged = false;      // Winner or game over
+    bool forcedBoardChanged = false; // Ultimate only
 };
 
-struct Move {
-    int row;
-    int col;
-    Player player;
-};
+Q_DECLARE_METATYPE(BoardChange)
 
 class GameLogic : public QObject {
     Q_OBJECT
 
 public:
     explicit GameLogic(QObject *parent = nullptr);
+    ~GameLogic();
     void newGame(bool vsAI);
+    void newGame(bool vsAI, GameVariant variant);
     bool makeMove(int row, int col);
+    bool undo();  // Against the AI, takes back its reply and the move before it; not once the game is over
+    bool redo();  // Plays undone moves again, the AI's reply included
+    bool canUndo() const;
+    bool canRedo() const;
     Player getCell(int row, int col) const;
     Player getCurrentPlayer() const;
     Player getWinner() const;
@@ -43,32 +53,109 @@ public:
     void replayMove(int index);
     void resetReplay();
     QVector<Move> getMoves() const;
-    void loadFromJson(const QJsonObject& gameData);
+    bool loadFromJson(const QJsonObject& gameData);
     void setDifficulty(AIDifficulty difficulty);
     AIDifficulty getDifficulty() const;
+    void setAITimeBudget(int ms);         // At least 1 ms, so the AI never searches without a deadline
+    int getAITimeBudget() const;
+    SearchResult getLastSearch() const;
+    MctsResult getLastMctsSearch() const;
+    AIDecisionStats getLastDecision() const;
+    void setDecisionLogPath(const QString& path); // Empty disables the log
+    QString getDecisionLogPath() const;
+    void setTablebaseDirectory(const QString& directory); // Endgame tablebases are looked up here
+    QString getTablebaseDirectory() const;
+    bool hasTablebase() const; // One is loaded for the current board
+    void setAIBackend(AIBackend backend);
+    AIBackend getAIBackend() const;
+    void setBoardSize(int size, int winLength); // Applied by the next newGame()
+    int getBoardSize() const;
+    int getWinLength() const;
+    void setVariant(GameVariant variant); // Applied by the next newGame()
+    GameVariant getVariant() const;
+    int getForcedBoard() const;           // Ultimate only; UltimateBoard::AnyBoard when free
+    Player getSubBoardWinner(int board) const;
+    BoardState toBoardState() const;      // Classic games only
+    QVector<RootScore> getMoveHints(int timeBudgetMs); // Every legal cell scored for the side to move, none as a bound
+    void requestMoveHints(int timeBudgetMs);           // The same on a worker, answered by moveHintsReady()
+    void setPonderingEnabled(bool enabled); // Search the human's likely replies during their turn
+    bool isPonderingEnabled() const;
+    void setPonderingPaused(bool paused);   // While the app is in the background
+    bool isPonderRunning() const;
 private:
     QVector<QVector<Player>> board;
+    int boardSize;
+    int winLength;
+    int pendingBoardSize;
+    int pendingWinLength;
+    GameVariant variant;
+    GameVariant pendingVariant;
+    UltimateBoard ultimate;
+    std::unique_ptr<UltimateEngine> ultimateEngine; // Built for the first ultimate search, its table is large
     Player currentPlayer;
     Player winner;
     bool gameOver;
     bool vsAI;
     QVector<Move> moves;
-    int replayIndex;
+    QVector<Move> undone;      // Taken back by undo(), the next to redo last
+    BoardState position;       // Classic games only, kept in step with moves
+    int replayIndex;           // Moves on the board; below moves.size() while replaying
     QDateTime startTime;
     AIDifficulty aiDifficulty;
+    SearchEngine searchEngine;
+    int aiTimeBudgetMs;
+    SearchResult lastSearch;
+    MctsEngine mctsEngine;
+    MctsResult lastMctsSearch;
+    AIBackend aiBackend;
+    AIDecisionStats lastDecision;
+    AIDecisionLog decisionLog;
+    Tablebase tablebase;
+    QString tablebaseDirectory;
+    Ponderer ponderer; // After tablebase, so the worker stops before the mapping goes
+    bool ponderingEnabled;
+    bool ponderingPaused;
+
+    // Hints are searched on a worker with engines of their own and kept by position
+    SearchEngine hintEngine;
+    std::unique_ptr<UltimateEngine> hintUltimateEngine; // Built for the first ultimate hint, its table is large
+    QFuture<void> hintWorker;
+    std::atomic<bool> hintStop;
+    int hintRequest;                                    // Results of older requests are dropped
+    QHash<quint64, QVector<RootScore>> hintCache;       // Current game only
+
+    // State as of the last boardChanged(), diffed against when the queued signal fires
+    bool changeQueued;
+    bool resetPending;
+    QVector<Player> notifiedCells;
+    Player notifiedPlayer;
+    Player notifiedWinner;
+    bool notifiedGameOver;
+    int notifiedForcedBoard;
     bool shouldUseOptimalMove();
 
     void switchPlayer();
+    bool applyMove(int row, int col); // makeMove() without the AI's reply
+    void unmakeMove();                // O(1): the last move off the board, its result undone
+    void stepForward();               // Plays moves[replayIndex], result included, and moves on
+    void stepBack();                  // Takes back moves[replayIndex - 1], keeping it in moves
     bool checkWin(int row, int col);
     bool checkGameOver();
     void makeAIMove();
-    int minimax(QVector<QVector<Player>>& board, int depth, bool isMaximizing, int alpha, int beta);
+    MctsLimits mctsLimits() const;
+    UltimateEngine& ultimateSearch();
+    void openTablebase();
+    void startPondering();
+    void stopHints();
+    void queueBoardChange();
+    void emitBoardChange();
     QVector<QPair<int, int>> getAvailableMoves(const QVector<QVector<Player>>& board) const;
-    bool isWin(const QVector<QVector<Player>>& board, Player player) const;
 
 signals:
-    void boardChanged();
+    void boardChanged(const BoardChange& change); // At most once per event loop turn
     void gameEnded(Player winner);
+    void aiDecision(const AIDecisionStats& stats); // After the AI's move is on the board
+    void moveHintsReady(const QVector<RootScore>& hints); // For the position of the latest request
 };
 
 #endif // GAMELOGIC_H
@@ -0,0 +1,29 @@
+// gamerecord.h - Validation of saved game records
+#ifndef GAMERECORD_H
+#define GAMERECORD_H
+
+#include <QString>
+#include <QJsonObject>
+#include "gamelogic.h"
+
+struct RecordCheck {
+    bool valid = false;
+    QString error;               // Empty when valid
+    Player winner = Player::None;
+    bool finished = false;       // Someone won or the board is full
+    QString derivedResult;       // Result string implied by the moves
+    bool resultMismatch = false; // Moves are fine but the stored "result" disagrees
+};
+
+// Replays a record on a BoardState or UltimateBoard instead of a GameLogic
+// instance, so it is cheap and safe to call from any thread.
+class GameRecordValidator {
+public:
+    static RecordCheck check(const QJsonObject& record);
+    static QString resultString(Player winner, bool finished);
+    static bool parseDifficulty(const QString& text, AIDifficulty* difficulty);
+    static QString variantString(GameVariant variant);
+    static bool parseVariant(const QString& text, GameVariant* variant);
+};
+
+#endif // GAMERECORD_H
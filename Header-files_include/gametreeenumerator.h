@@ -0,0 +1,53 @@
+// gametreeenumerator.h - Exhaustive game enumeration that checks the engine against a reference
+#ifndef GAMETREEENUMERATOR_H
+#define GAMETREEENUMERATOR_H
+
+#include <QString>
+#include <QStringList>
+
+struct EnumerationReport {
+    qint64 games = 0;        // Move sequences played to their end, or to the depth limit
+    qint64 xWins = 0;
+    qint64 oWins = 0;
+    qint64 draws = 0;
+    qint64 cutOff = 0;       // Stopped by the depth limit before the game ended
+    qint64 nodes = 0;        // Every prefix of every game, the empty board included
+    qint64 aiPositions = 0;  // Distinct positions the search was checked on
+    qint64 mismatches = 0;
+    QStringList issues;      // The first few mismatches, with the moves leading to them
+    qint64 enumerationMs = 0;
+    qint64 aiMs = 0;
+
+    bool passed() const { return mismatches == 0; }
+};
+
+// Walks every legal move sequence from the empty board in parallel, the
+// first two moves fanning the tree out over the pool. A plain cell array
+// with a full-scan win check serves as the reference. At every node the
+// bitboard's wins() and findWinner() must agree with it, and every game is
+// replayed through GameLogic::makeMove, whose board, turn, winner and game
+// over state must match after each move. Distinct non-terminal positions
+// with few enough empty cells are then solved by the search engine, whose
+// score and chosen move must match the reference's own minimax.
+class GameTreeEnumerator {
+public:
+    static const int MaxIssues = 20;
+
+    GameTreeEnumerator();
+
+    void setBoard(int size, int winLength);
+    void setMaxDepth(int plies);     // 0 plays every game to its end
+    void setAIMaxEmpty(int empty);   // -1 skips the search check
+    void setThreads(int count);      // 0 uses the global thread pool
+
+    EnumerationReport run();
+
+private:
+    int boardSize;
+    int boardWinLength;
+    int depthLimit;
+    int aiEmptyLimit;
+    int threadCount;
+};
+
+#endif // GAMETREEENUMERATOR_H
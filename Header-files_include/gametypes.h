@@ -0,0 +1,33 @@
+// gametypes.h - Basic types shared by the game logic and the AI
+#ifndef GAMETYPES_H
+#define GAMETYPES_H
+
+enum class Player {
+    None,
+    X,
+    O
+};
+enum class AIDifficulty {
+    Easy,     // Makes optimal move 30% of the time
+    Medium,   // Makes optimal move 50% of the time
+    Hard,     // Makes optimal move 80% of the time
+    Unbeatable // Makes optimal move 100% of the time
+};
+
+enum class AIBackend {
+    AlphaBeta, // Iterative-deepening search with a heuristic, the default
+    MonteCarlo // Tree search with playouts, difficulty sets the playout budget
+};
+
+enum class GameVariant {
+    Classic,  // One N x N board
+    Ultimate  // Nine 3x3 boards; each move picks the board the opponent plays in next
+};
+
+struct Move {
+    int row;
+    int col;
+    Player player;
+};
+
+#endif // GAMETYPES_H
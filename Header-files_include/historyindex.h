@@ -0,0 +1,60 @@
+// historyindex.h - Secondary indexes for filtering a player's game history
+#ifndef HISTORYINDEX_H
+#define HISTORYINDEX_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonObject>
+
+struct HistoryFilter {
+    QDateTime from;        // Inclusive, invalid for no lower bound
+    QDateTime to;          // Exclusive, invalid for no upper bound
+    QString result;        // "X wins", "O wins", "Tie" or "Incomplete", empty for any
+    int vsAI = -1;         // 1 for AI games, 0 for two-player games, -1 for both
+    QString difficulty;    // "Easy" to "Unbeatable", empty for any
+
+    bool isEmpty() const;
+
+    // What was typed into the filter bar: dates (2024, 2024-05, 2024-05-01, or
+    // a from..to range of those), win/loss/tie/incomplete, ai/pvp and the
+    // difficulty names. Words not understood yet, such as half a date, are skipped.
+    static HistoryFilter parse(const QString& text);
+};
+
+// Games are numbered by their position in the history. Dates are kept sorted
+// and result, mode and difficulty as one bitmap per value, so a query is a
+// binary search plus a few word-wide ANDs instead of a pass over the JSON.
+// Appending keeps the indexes current without rebuilding them.
+class HistoryIndex {
+public:
+    HistoryIndex();
+
+    void clear();
+    void rebuild(const QJsonArray& history);
+    void append(const QJsonObject& game);
+    int size() const;
+
+    QVector<int> query(const HistoryFilter& filter) const; // Matching games in history order
+
+private:
+    typedef QVector<quint64> Bitmap;
+
+    struct DateEntry {
+        qint64 secs;       // Games without a readable date sort first and never match a date filter
+        int game;
+    };
+
+    int count;
+    QVector<DateEntry> byDate;
+    QHash<QString, Bitmap> byResult;
+    QHash<QString, Bitmap> byDifficulty;
+    Bitmap vsAI;
+
+    static void setBit(Bitmap& bitmap, int bit);
+    static void intersect(Bitmap& result, const Bitmap* bitmap, bool invert);
+};
+
+#endif // HISTORYINDEX_H
@@ -0,0 +1,37 @@
+// historylistmodel.h - Rows of the history page, limited to the games a filter matched
+#ifndef HISTORYLISTMODEL_H
+#define HISTORYLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QJsonArray>
+#include <QVector>
+#include <QHash>
+#include "thumbnailcache.h"
+
+// Row text, thumbnail key and record are produced when a row is drawn, so
+// showing another set of games is one model reset however long the list.
+class HistoryListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    static const int GameIndexRole = Qt::UserRole;      // Position in the full history
+    static const int ThumbnailKeyRole = ThumbnailDelegate::KeyRole;
+    static const int RecordRole = ThumbnailDelegate::RecordRole;
+
+    explicit HistoryListModel(QObject* parent = nullptr);
+
+    void setHistory(const QJsonArray& history); // Shows every game
+    void setGames(const QVector<int>& games);   // History positions, in display order
+    void showAll();
+    int totalGames() const;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    QJsonArray history;
+    QVector<int> rows;
+    mutable QHash<int, QString> thumbnailKeys; // Hashing a record is worth doing once
+};
+
+#endif // HISTORYLISTMODEL_H
@@ -0,0 +1,34 @@
+// historystreamer.h - Streaming NDJSON export and import of game history
+#ifndef HISTORYSTREAMER_H
+#define HISTORYSTREAMER_H
+
+#include <QObject>
+#include <QString>
+#include "gameimporter.h"
+
+class UserAuth;
+
+// One game per line. Export copies the stored records line by line through
+// QSaveFile and import reads line by line, appending each batch to the
+// stored history, so neither side ever holds the whole file.
+class HistoryStreamer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit HistoryStreamer(QObject* parent = nullptr);
+
+    void setBatchSize(int size);        // Records held in memory during import
+    void setRepairResults(bool repair);
+
+    bool exportHistory(const UserAuth* auth, const QString& filePath);
+    ImportReport importHistory(const QString& filePath, UserAuth* auth); // Issue indexes are line numbers
+
+signals:
+    void progress(qint64 done, qint64 total); // Bytes read, on export and import
+
+private:
+    int batchSize;
+    bool repairResults;
+};
+
+#endif // HISTORYSTREAMER_H
@@ -0,0 +1,84 @@
+// latencytracker.h - Input-to-paint latency histograms for the game page
+#ifndef LATENCYTRACKER_H
+#define LATENCYTRACKER_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+// Power-of-two buckets from 0.25 ms up; the last one takes everything slower
+class LatencyHistogram {
+public:
+    static const int Buckets = 12;
+
+    LatencyHistogram();
+
+    void add(qint64 nsecs);
+    qint64 count() const;
+    qint64 maxNs() const;
+    double meanMs() const;
+    double percentileMs(double fraction) const; // Upper edge of the bucket holding it
+    qint64 countAbove(double ms) const;         // Exact for bucket edges such as 16 ms
+    static double bucketLimitMs(int bucket);    // Infinity for the last bucket
+
+    QJsonObject toJson() const;
+
+private:
+    qint64 counts[Buckets];
+    qint64 total;
+    qint64 sumNs;
+    qint64 maxSample;
+};
+
+// Timestamps one move from the click to the frame that shows it, with the
+// monotonic clock. A sample starts at begin(), each stage is marked as it is
+// reached, and reaching Painted files the time of every segment under the
+// category given to begin() (the AI difficulty, or two-player games).
+class LatencyTracker {
+public:
+    enum Stage {
+        Input,         // Click delivered to the game page
+        MoveApplied,   // makeMove() returned, the AI's reply included
+        BoardNotified, // The coalesced board change reached the page
+        Painted,       // The board finished painting both moves
+        StageCount
+    };
+
+    static constexpr double FrameBudgetMs = 16.0;
+
+    LatencyTracker();
+
+    void begin(const QString& category);
+    void mark(Stage stage);
+    void cancel();                 // The click did not lead to a move
+    bool isPending() const;
+
+    // Segment from the previous stage to this one; Input is the whole sample
+    const LatencyHistogram* histogram(const QString& category, Stage stage) const;
+    QStringList categories() const;
+    qint64 overBudget(const QString& category) const;
+    qint64 lastTotalNs() const;
+
+    void clear();
+    QString summary() const;       // A few lines for the on-screen overlay
+    QJsonObject toJson() const;
+    bool exportTo(const QString& path) const;
+
+    static QString stageName(Stage stage);
+
+private:
+    struct Category {
+        LatencyHistogram stages[StageCount];
+    };
+
+    QElapsedTimer clock;
+    QString pendingCategory;
+    qint64 stamps[StageCount];
+    int reached;                   // Last stage marked, -1 when idle
+    qint64 lastTotal;
+    QMap<QString, Category> results;
+};
+
+#endif // LATENCYTRACKER_H
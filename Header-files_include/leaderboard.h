@@ -0,0 +1,61 @@
+// leaderboard.h - Order-statistics index over player ratings
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+
+struct LeaderboardEntry {
+    QString username;
+    int rating;
+    int rank; // 1 = best
+};
+
+// Treap ordered by (rating descending, username ascending). Every node keeps
+// its subtree size, so insert, remove, rank and select are all O(log n) and
+// top-K is O(log n + K) without touching the rest of the table.
+class Leaderboard {
+public:
+    Leaderboard();
+
+    void setRating(const QString& username, int rating);
+    bool remove(const QString& username);
+    void clear();
+
+    bool contains(const QString& username) const;
+    int ratingOf(const QString& username) const;
+    int rankOf(const QString& username) const; // 0 when not on the board
+    LeaderboardEntry entryAt(int rank) const;
+    QVector<LeaderboardEntry> topK(int k) const;
+    int size() const;
+
+    // Standard Elo helpers
+    static double expectedScore(int rating, int opponentRating);
+    static int updatedRating(int rating, int opponentRating, double score, int gamesPlayed);
+
+private:
+    struct Node {
+        QString username;
+        int rating;
+        quint32 priority;
+        int left;
+        int right;
+        int size;
+    };
+
+    QVector<Node> nodes;     // Arena; removed nodes are recycled through freeList
+    QVector<int> freeList;
+    QHash<QString, int> index;
+    int root;
+    quint32 seed;
+
+    bool before(int node, int rating, const QString& username) const;
+    int sizeOf(int node) const;
+    void pull(int node);
+    quint32 nextPriority();
+    void split(int node, int rating, const QString& username, bool inclusive, int& left, int& right);
+    int merge(int left, int right);
+};
+
+#endif // LEADERBOARD_H
@@ -8,12 +8,19 @@
 #include <QStackedWidget>
 #include <QGridLayout>
 #include <QSlider>
-#include <QListWidget>
+#include <QListView>
+#include <QProgressBar>
 #include <QJsonObject>
 #include <QComboBox>
 #include <QButtonGroup>
 #include "userauth.h"
 #include "gamelogic.h"
+#include "boardwidget.h"
+#include "latencytracker.h"
+#include "startuptimings.h"
+#include "thumbnailcache.h"
+#include "historylistmodel.h"
+#include "gameanalyzer.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -22,15 +29,25 @@ QT_END_NAMESPACE
 class MainWindow : public QMainWindow
 {
     friend class IntegrationTest;
+    friend class UiBenchmark;
     Q_OBJECT
 
 public:
     explicit MainWindow(UserAuth* auth, QWidget* parent = nullptr);
     ~MainWindow();
 
+    // Marks the first paint and the point the login page takes input
+    void setStartupTimings(StartupTimings* timings);
+
+signals:
+    void startupCompleted();
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
 private slots:
-    void handleCellClicked();
-    void updateBoard();
+    void handleCellClicked(int row, int col);
+    void updateBoard(const BoardChange& change);
     void handleGameEnd(Player winner);
     void showLoginPage();
     void showSignupPage();
@@ -52,12 +69,15 @@ private:
     Ui::MainWindow* ui;
     UserAuth* userAuth;
     GameLogic* gameLogic;
+    GameLogic* replayLogic; // Saved games are replayed here, the game being played is left alone
     QStackedWidget* stackedWidget;
     QComboBox* difficultyComboBox;
     QPushButton* difficultyConfirmButton;
+    QComboBox* boardComboBox;
     QButtonGroup* playerSymbolGroup;
     bool playerIsX; // Track player's chosen symbol
     void handleDifficultyChanged();
+    void applyBoardChoice();
 
     // Login page widgets
     QWidget* loginPage;
@@ -93,30 +113,54 @@ private:
     QWidget* gamePage;
     QLabel* gameStatusLabel;
     QPushButton* backToMenuFromGameButton;
-    QPushButton* boardButtons[3][3];
-    QGridLayout* boardLayout;
+    BoardWidget* boardView;
+    QPushButton* hintsButton;
+    QPushButton* undoButton;
+    QPushButton* redoButton;
+    bool hintsEnabled;
+
+    // Click-to-paint timing, shown with Ctrl+Shift+L and saved with Ctrl+Shift+E
+    LatencyTracker latency;
+    QLabel* latencyOverlay;
+    QString latencyPath;
+    QString latencyCategory() const;
+    void exportLatency();
 
     // History page widgets
     QWidget* historyPage;
-    QListWidget* gamesList;
+    QListView* gamesList;
+    HistoryListModel* historyModel;
+    ThumbnailCache* thumbnails;
+    GameAnalyzer* analyzer;
+    QLineEdit* historyFilterEdit;
+    QLabel* historyCountLabel;
     QPushButton* loadGameButton;
+    QPushButton* analyzeButton;
+    QProgressBar* analysisProgress;
     QPushButton* backToMenuFromHistoryButton;
     QLabel* replayStatusLabel;
     QSlider* replaySlider;
     QPushButton* previousMoveButton;
     QPushButton* nextMoveButton;
-    QPushButton* boardReplayButtons[3][3];
-    QGridLayout* replayBoardLayout;
+    BoardWidget* replayBoardView;
+
+    StartupTimings* startupTimings;
 
+    // Pages other than the login page are built on first visit
     void setupLoginPage();
     void setupSignupPage();
     void setupMenuPage();
     void setupGameModePage();
     void setupGamePage();
     void setupHistoryPage();
-    void updateBoardButtons();
-    void updateReplayBoardButtons();
+    void updateHints();
+    void showHints(const QVector<RootScore>& scores);
+    QColor hintColor(int score) const;
+    void updateReplayBoard();
     void loadGameHistory();
+    void applyHistoryFilter();
+    void analyzeHistory();
+    QString analysisSummary(const QJsonArray& games, int* analyzedGames = nullptr) const;
 };
 
 #endif // MAINWINDOW_H
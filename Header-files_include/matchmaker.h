@@ -0,0 +1,106 @@
+// matchmaker.h - Matchmaking queue for pairing players and AI opponents
+#ifndef MATCHMAKER_H
+#define MATCHMAKER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QMetaType>
+#include <atomic>
+#include <memory>
+#include "gamelogic.h"
+#include "mpmcqueue.h"
+
+enum class MatchMode {
+    TwoPlayer, // Wants a human opponent, falls back to AI after a timeout
+    VsAI       // Wants an AI opponent straight away
+};
+
+struct MatchRequest {
+    QString username;
+    int rating = 0;
+    MatchMode mode = MatchMode::TwoPlayer;
+    AIDifficulty difficulty = AIDifficulty::Medium;
+    qint64 enqueuedAt = 0; // Milliseconds on the matchmaker clock
+};
+
+struct MatchResult {
+    QString playerX;
+    QString playerO;       // Empty when the opponent is the AI
+    bool vsAI = false;
+    AIDifficulty difficulty = AIDifficulty::Medium;
+    qint64 waitMs = 0;     // Longest wait of the paired players
+};
+Q_DECLARE_METATYPE(MatchResult)
+
+struct MatchmakerMetrics {
+    qint64 queueDepth = 0;      // Requests enqueued but not yet drained
+    qint64 waitingPlayers = 0;  // Drained requests still looking for a partner
+    qint64 matchesMade = 0;
+    qint64 aiFallbacks = 0;
+    qint64 rejected = 0;        // Enqueues refused because a queue was full
+    qint64 playersMatched = 0;
+    double averageTimeToMatchMs = 0.0;
+    qint64 maxTimeToMatchMs = 0;
+    QVector<qint64> timeToMatchHistogram; // One count per histogramBounds() bucket, plus overflow
+};
+
+class Matchmaker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit Matchmaker(QObject* parent = nullptr, int queueCapacity = 4096);
+
+    // Safe to call from any thread, never blocks
+    bool enqueue(const QString& username, int rating, MatchMode mode, AIDifficulty difficulty);
+
+    void start(int tickMs = 50);
+    void stop();
+    int processQueues();
+
+    void setRatingWindow(int baseWindow, int growthPerSecond);
+    void setAIFallbackTimeout(int ms);
+    MatchmakerMetrics getMetrics() const;
+    static QVector<qint64> histogramBounds();
+
+    GameLogic* createSession(const MatchResult& match, QObject* parent = nullptr) const;
+
+signals:
+    void matchFound(const MatchResult& match);
+
+private:
+    static const int BucketCount = 8; // 2 modes x 4 difficulties
+    static const int HistogramSize = 8;
+
+    struct Bucket {
+        std::unique_ptr<MpmcQueue<MatchRequest>> queue;
+        std::atomic<qint64> depth{0};
+        std::atomic<qint64> waitingCount{0};
+        QVector<MatchRequest> waiting; // Only touched by the matching thread
+    };
+
+    Bucket buckets[BucketCount];
+    QElapsedTimer clock;
+    QTimer* tickTimer;
+    int baseRatingWindow;
+    int ratingWindowGrowth;
+    int aiFallbackMs;
+
+    std::atomic<qint64> matchesMade{0};
+    std::atomic<qint64> aiFallbacks{0};
+    std::atomic<qint64> rejected{0};
+    std::atomic<qint64> playersMatched{0};
+    std::atomic<qint64> totalWaitMs{0};
+    std::atomic<qint64> maxWaitMs{0};
+    std::atomic<qint64> histogram[HistogramSize];
+
+    static int bucketIndex(MatchMode mode, AIDifficulty difficulty);
+    int ratingWindow(qint64 waitMs) const;
+    void recordWait(qint64 waitMs);
+    void emitPair(const MatchRequest& a, const MatchRequest& b, qint64 now);
+    void emitAIMatch(const MatchRequest& request, qint64 now);
+};
+
+#endif // MATCHMAKER_H
@@ -0,0 +1,91 @@
+// mctsengine.h - Monte Carlo tree search for boards too large to solve
+#ifndef MCTSENGINE_H
+#define MCTSENGINE_H
+
+#include <QVector>
+#include <QElapsedTimer>
+#include <atomic>
+#include "boardstate.h"
+
+struct MctsLimits {
+    int iterations = 0;   // Playouts across all threads; 0 means until the deadline
+    int timeBudgetMs = 0; // 0 means no deadline
+    int threads = 1;      // Independent trees searched in parallel (root parallelism)
+};
+
+// Root statistics of one move, summed over all trees
+struct MctsMove {
+    int cell = -1;
+    qint64 visits = 0;
+    double winRate = 0.0;
+};
+
+struct MctsResult {
+    int cell = -1;
+    qint64 iterations = 0;
+    qint64 visits = 0;      // Visits of the chosen move, summed over all trees
+    double winRate = 0.0;   // Expected score of the chosen move for the side to move
+    int treeNodes = 0;      // Nodes held by all trees after the search
+    int reusedTrees = 0;    // Trees carried over from the previous search
+    bool tactical = false;  // Immediate win or forced block, no search needed
+    qint64 elapsedMs = 0;
+    QVector<MctsMove> moves; // Every visited root move, in board order
+};
+
+// UCT search with random playouts on a BoardState; playouts take an
+// immediate win or block one near the last stones before choosing at random. Each thread owns
+// one tree stored in a flat node arena, with each node's children kept
+// contiguous. After a search the trees are kept, and the next search re-roots
+// them when the new position follows from the old one.
+class MctsEngine {
+public:
+    MctsEngine();
+
+    MctsResult search(const BoardState& root, const MctsLimits& limits);
+
+    void setExploration(double c);
+    void setMaxNodesPerTree(int count);
+    void reset(); // Drops every tree
+
+private:
+    static const int MaxCells = BoardState::MaxSize * BoardState::MaxSize;
+
+    struct Node {
+        int firstChild = -1;  // Index of the first child in the arena, -1 until expanded
+        qint16 childCount = 0;
+        qint8 cell = -1;      // Move that leads to this node
+        qint8 terminal = 0;   // 0 open, 1 the move won, 2 the move filled the board
+        int visits = 0;
+        float score = 0.0f;   // Sum of results for the player who made the move
+    };
+
+    struct Tree {
+        QVector<Node> nodes;
+        BoardState root;
+        quint64 rng = 0;
+        qint64 iterations = 0;
+    };
+
+    QVector<Tree> trees;
+    double exploration;
+    int maxNodes;
+
+    QElapsedTimer timer;
+    qint64 deadlineMs;
+    bool countIterations;
+    std::atomic<qint64> iterationsLeft; // Shared by all workers
+
+    static bool reroot(Tree& tree, const BoardState& newRoot);
+    static int tacticalMove(const BoardState& state);
+    static quint64 neighbours(const BoardState& state, quint64 cells);
+    static quint64 candidateMoves(const BoardState& state);
+    static quint64 nextRandom(quint64& state);
+    void runWorker(Tree& tree);
+    void iterate(Tree& tree);
+    void expand(Tree& tree, int node, const BoardState& state);
+    int selectChild(const Tree& tree, int node) const;
+    Player playout(BoardState& state, int lastMine, int lastTheirs, quint64& rng) const;
+    static int lineWin(const BoardState& state, int anchor, Player player);
+};
+
+#endif // MCTSENGINE_H
@@ -0,0 +1,145 @@
+// metrics.h - Runtime counters, gauges and histograms in Prometheus text format
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QString>
+#include <QMap>
+#include <QMutex>
+#include <atomic>
+
+class Metric;
+
+// Every metric registers itself here when constructed. Counters and
+// histograms are split into shards so threads updating the same metric do
+// not share a cache line; the shards are summed only when the text is built.
+// While metrics are off an update is one relaxed load and nothing else.
+class Metrics {
+public:
+    static const int Shards = 16;
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    static int shardIndex();           // Fixed per thread
+
+    static QString prometheusText();   // Exposition format, one family per name
+    static bool writePrometheus(const QString& path); // Replaced whole, never seen half written
+    static void reset();               // Zero every metric
+
+private:
+    friend class Metric;
+    static std::atomic<bool> enabled;
+    static void add(Metric* metric);
+    static void remove(Metric* metric);
+};
+
+class Metric {
+public:
+    enum Type { CounterType, GaugeType, HistogramType };
+
+    // name, help and labels (such as mode="ai") must outlive the metric
+    Metric(Type type, const char* name, const char* help, const char* labels);
+    virtual ~Metric();
+
+    Metric(const Metric&) = delete;
+    Metric& operator=(const Metric&) = delete;
+
+    Type type() const;
+    const char* name() const;
+    const char* help() const;
+
+    virtual void writeSamples(QString& out) const = 0;
+    virtual void reset() = 0;
+
+protected:
+    QString series(const char* suffix, const QString& extraLabel = QString()) const;
+
+private:
+    Type metricType;
+    const char* metricName;
+    const char* metricHelp;
+    const char* metricLabels;
+};
+
+class Counter : public Metric {
+public:
+    Counter(const char* name, const char* help, const char* labels = "");
+
+    void add(qint64 amount = 1) {
+        if (Metrics::isEnabled()) {
+            shards[Metrics::shardIndex()].value.fetch_add(amount, std::memory_order_relaxed);
+        }
+    }
+    qint64 value() const;
+
+    void writeSamples(QString& out) const override;
+    void reset() override;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<qint64> value{0};
+    };
+    Shard shards[Metrics::Shards];
+};
+
+// Durations in seconds, in buckets from half a millisecond to ten seconds
+class Histogram : public Metric {
+public:
+    static const int Bounds = 14;
+
+    Histogram(const char* name, const char* help, const char* labels = "");
+
+    void observeNs(qint64 nsecs) {
+        if (Metrics::isEnabled()) {
+            record(nsecs);
+        }
+    }
+    qint64 count() const;
+    double sumSeconds() const;
+    static double bound(int bucket);
+
+    void writeSamples(QString& out) const override;
+    void reset() override;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<qint64> buckets[Bounds + 1]; // The last one is +Inf
+        std::atomic<qint64> sumNs;
+        Shard();
+    };
+    Shard shards[Metrics::Shards];
+
+    void record(qint64 nsecs);
+};
+
+// A value per label, such as history size per user. Set rarely, so a
+// mutex and a map are fine here where they would not be for a counter.
+class LabeledGauge : public Metric {
+public:
+    LabeledGauge(const char* name, const char* help, const char* labelName);
+
+    void set(const QString& label, double value);
+    double value(const QString& label) const;
+
+    void writeSamples(QString& out) const override;
+    void reset() override;
+
+private:
+    const char* labelName;
+    mutable QMutex mutex;
+    QMap<QString, double> values;
+};
+
+// The application's own metrics
+namespace AppMetrics {
+extern Counter gamesStarted[2];      // Two-player, then against the AI
+extern Counter gamesFinished[3];     // X wins, O wins, tie
+extern Histogram aiMoveSeconds[4];   // Indexed by AIDifficulty
+extern Histogram usersSaveSeconds;
+extern Counter usersSaveBytes;
+extern Histogram signInSeconds;
+extern LabeledGauge historyGames;    // Per user
+}
+
+#endif // METRICS_H
@@ -0,0 +1,103 @@
+// mpmcqueue.h - Bounded lock-free multi-producer multi-consumer queue
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Vyukov-style ring buffer: every slot carries a sequence number telling
+// producers and consumers whether it is free or filled, so neither side locks.
+template <typename T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(size_t capacity = 4096) {
+        // Round the capacity up to a power of two so positions can be masked
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask = size - 1;
+        buffer.reset(new Slot[size]);
+        for (size_t i = 0; i < size; ++i) {
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueuePos.store(0, std::memory_order_relaxed);
+        dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // Returns false when the queue is full
+    bool tryEnqueue(T value) {
+        Slot* slot;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            slot = &buffer[pos & mask];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false when the queue is empty
+    bool tryDequeue(T& out) {
+        Slot* slot;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            slot = &buffer[pos & mask];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(slot->value);
+        slot->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    // Only a snapshot: producers and consumers may move while we read
+    size_t sizeApprox() const {
+        size_t tail = enqueuePos.load(std::memory_order_relaxed);
+        size_t head = dequeuePos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> buffer;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+};
+
+#endif // MPMCQUEUE_H
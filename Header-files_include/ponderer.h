@@ -0,0 +1,50 @@
+// ponderer.h - Background search during the opponent's turn
+#ifndef PONDERER_H
+#define PONDERER_H
+
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <atomic>
+#include "searchengine.h"
+
+// While the opponent thinks, searches the position after each of their
+// likely replies on a worker thread, best-looking reply first, and keeps the
+// finished results keyed by position hash. The real reply then costs a hash
+// lookup instead of a search. Only results of searches that ran to their own
+// limits are kept, so a cached answer is as good as a fresh one.
+class Ponderer {
+public:
+    Ponderer();
+    ~Ponderer();
+
+    void setTablebase(const Tablebase* tablebase); // Only while stopped
+
+    // position has the opponent to move; limits are those of a real AI move.
+    // Replies already cached for the same position are not searched again.
+    void start(const BoardState& position, const SearchLimits& limits, int predictedReply = -1);
+    void stop();                // Cancels the search in progress, keeps finished results
+    void clear();
+    void waitForFinished();     // Until every reply has been searched or stop() was called
+    bool isRunning() const;
+    int cachedReplies() const;
+
+    // Stops pondering and hands over the result for the position after the
+    // actual reply, if it was searched. The cache is cleared either way.
+    bool take(const BoardState& position, SearchResult* result);
+
+private:
+    SearchEngine engine;      // Only used by the worker while it runs
+    QFuture<void> worker;
+    std::atomic<bool> stopRequested;
+    BoardState root;
+    SearchLimits rootLimits;
+    int predicted;
+
+    mutable QMutex mutex;
+    QHash<quint64, SearchResult> results; // Keyed by the hash after the reply
+
+    void run();
+};
+
+#endif // PONDERER_H
@@ -0,0 +1,121 @@
+// searchengine.h - Time-budgeted iterative-deepening alpha-beta search
+#ifndef SEARCHENGINE_H
+#define SEARCHENGINE_H
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <atomic>
+#include "boardstate.h"
+#include "tablebase.h"
+
+// Move ordering heuristics, combined as flags
+enum MoveOrdering {
+    OrderNone = 0,
+    OrderStaticPrior = 1, // Cells on more winning windows first (center, then corners, then edges on 3x3)
+    OrderTTMove = 2,      // Best move stored in the transposition table first
+    OrderKillers = 4,     // Quiet moves that caused a cutoff at the same ply
+    OrderHistory = 8,     // Moves that caused cutoffs anywhere, weighted by depth
+    OrderAll = OrderStaticPrior | OrderTTMove | OrderKillers | OrderHistory
+};
+
+struct SearchLimits {
+    int maxDepth = 0;     // Plies; 0 searches until the board is full
+    int timeBudgetMs = 0; // 0 means no deadline
+    bool scoreAllMoves = false; // Full window for every root move, so none is only a bound
+};
+
+struct SearchStats {
+    qint64 nodes = 0;
+    qint64 cutoffs = 0;
+    qint64 firstMoveCutoffs = 0; // Cutoffs caused by the first move tried
+    qint64 ttHits = 0;           // Probes that ended the node without searching
+    qint64 tablebaseHits = 0;    // Nodes answered by the endgame tablebase
+
+    double firstMoveCutoffRate() const {
+        return cutoffs > 0 ? static_cast<double>(firstMoveCutoffs) / cutoffs : 0.0;
+    }
+};
+
+// Score of one root move in the last completed iteration
+struct RootScore {
+    int cell = -1;
+    int score = 0;
+    bool upperBound = false; // Refuted by the alpha-beta window, the true score may be lower
+};
+
+struct SearchResult {
+    int cell = -1;           // Best move from the deepest completed iteration
+    int score = 0;           // From the side to move's point of view
+    int depthCompleted = 0;
+    bool exact = false;      // The completed search reached every game end
+    bool timedOut = false;   // The deadline cut an iteration short
+    qint64 elapsedMs = 0;
+    SearchStats stats;
+    QVector<int> principalVariation; // Starts with cell, followed from the transposition table
+    QVector<RootScore> rootScores;   // In the order they were searched
+};
+
+// Negamax with alpha-beta, deepened one ply at a time. A deadline only ever
+// discards the unfinished iteration, so a result is always available. Depth 1
+// is always completed, whatever the budget. The transposition table and
+// history scores persist between searches on boards of the same shape.
+class SearchEngine {
+public:
+    static const int WinScore = 1000000;
+
+    SearchEngine();
+
+    SearchResult search(const BoardState& root, const SearchLimits& limits);
+
+    void setMoveOrdering(int flags);
+    int moveOrdering() const;
+    void clearTables();
+    void setTablebase(const Tablebase* tablebase); // Probed at every covered node, may be null
+    void setStopFlag(const std::atomic<bool>* flag); // Set from any thread to abort, even depth 1; may be null
+
+    // Static evaluation of a non-terminal position for the side to move
+    static int evaluate(const BoardState& state);
+    static bool isWinScore(int score) { return qAbs(score) > WinScore - 1000; }
+
+private:
+    static const int MaxCells = BoardState::MaxSize * BoardState::MaxSize;
+    static const int TableBits = 16;
+    static const int HistoryLimit = (1 << 27) - 1; // Stays below the killer scores once scaled
+
+    enum Bound : quint8 { BoundExact, BoundLower, BoundUpper };
+
+    struct TTEntry {
+        quint64 key = 0;
+        int score = 0;
+        qint8 depth = -1;   // SolvedDepth when the subtree reached every game end
+        quint8 bound = BoundExact;
+        qint8 bestCell = -1;
+    };
+
+    QVector<TTEntry> table;
+    int history[2][MaxCells];
+    int killers[MaxCells + 1][2];
+    int prior[MaxCells];
+    int tableSize;
+    int tableWinLength;
+    int orderingFlags;
+    const Tablebase* endgame;
+    const std::atomic<bool>* stopFlag;
+
+    QElapsedTimer timer;
+    qint64 deadlineMs;
+    bool aborted;
+    bool hitHorizon;
+    SearchStats stats;
+    QVector<RootScore> iterationScores;
+
+    void prepareTables(const BoardState& root);
+    int orderMoves(const BoardState& state, int ply, int ttCell, int* moves) const;
+    int rootSearch(BoardState& state, int depth, int preferredCell, bool scoreAll, int* bestCell);
+    int negamax(BoardState& state, int depth, int ply, int alpha, int beta);
+    void recordCutoff(const BoardState& state, int cell, int depth, int ply);
+    bool outOfTime();
+    QVector<int> principalVariation(const BoardState& root, int cell, int maxLength) const;
+};
+
+#endif // SEARCHENGINE_H
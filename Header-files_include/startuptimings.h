@@ -0,0 +1,36 @@
+// startuptimings.h - Cold-start phase timings, printed with --startup-timings
+#ifndef STARTUPTIMINGS_H
+#define STARTUPTIMINGS_H
+
+#include <QString>
+#include <QElapsedTimer>
+
+// Monotonic timestamps of the phases between entering main() and the login
+// page taking input. Create it first thing in main(); each phase is recorded
+// once, later marks of the same phase are ignored.
+class StartupTimings {
+public:
+    enum Phase {
+        MainEntered,  // The clock starts here
+        AppCreated,   // QApplication constructed
+        WindowBuilt,  // MainWindow constructed, users.json may still be loading
+        FirstPaint,   // The login page painted for the first time
+        Interactive,  // Users loaded and the event loop free again
+        PhaseCount
+    };
+
+    StartupTimings();
+
+    void mark(Phase phase);
+    bool reached(Phase phase) const;
+    qint64 elapsedNs(Phase phase) const; // Since MainEntered, -1 until reached
+
+    QString report() const;              // One line per phase with the step from the one before
+    static QString phaseName(Phase phase);
+
+private:
+    QElapsedTimer clock;
+    qint64 stamps[PhaseCount];
+};
+
+#endif // STARTUPTIMINGS_H
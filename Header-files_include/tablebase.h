@@ -0,0 +1,74 @@
+// tablebase.h - Memory-mapped endgame tablebase for N x N, k-in-a-row boards
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <QFile>
+#include <QString>
+#include "boardstate.h"
+
+// Value of a position for the side to move
+struct TablebaseEntry {
+    enum Result : quint8 { Unknown = 0, Loss = 1, Draw = 2, Win = 3 };
+
+    Result result = Unknown; // Unknown when not covered, or the game is already over
+    int distance = 0;        // Plies to the end of the game with best play
+
+    bool isValid() const { return result != Unknown; }
+};
+
+// Positions are grouped into layers by the number of empty cells. Inside a
+// layer a position's index is the combinatorial rank of its empty cells,
+// followed by the rank of X's stones among the filled cells. The side to
+// move follows from the stone count, so every index is a legal position and
+// one byte per position holds the result (top two bits) and distance.
+//
+// File layout, little-endian:
+//   char[4] "TTTB", quint8 version, size, winLength, maxEmpty,
+//   quint8 layersComplete, 7 bytes padding,
+//   quint64 offset[maxEmpty + 1], then the layers.
+// Layers are written in order and layersComplete is updated last, so an
+// interrupted generator leaves a usable file that it can resume.
+class Tablebase {
+public:
+    static const int Version = 1;
+    static const int MaxEmpty = 63;
+
+    Tablebase();
+    ~Tablebase();
+
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    bool open(const QString& path); // Maps the file read-only
+    void close();
+    bool isOpen() const;
+
+    int size() const;
+    int winLength() const;
+    int layersComplete() const;       // Positions with fewer empty cells are covered
+    bool covers(const BoardState& state) const;
+
+    TablebaseEntry probe(const BoardState& state) const;
+    int bestMove(const BoardState& state, TablebaseEntry* value = nullptr) const; // -1 when not covered
+
+    // Shared with the generator
+    static QString fileName(int size, int winLength);
+    static quint64 binomial(int n, int k);
+    static quint64 layerSize(int cells, int empty);
+    static quint64 indexOf(quint64 empty, quint64 x, quint64 fullMask);
+    static quint8 encode(TablebaseEntry::Result result, int distance);
+    static TablebaseEntry decode(quint8 value);
+    static TablebaseEntry afterMove(const TablebaseEntry& child); // Child's value seen from the parent
+    static bool isBetter(const TablebaseEntry& a, const TablebaseEntry& b);
+    static int headerSize(int maxEmpty);
+
+private:
+    QFile file;
+    const uchar* data;
+    int boardSize;
+    int boardWinLength;
+    int completeLayers;
+    QVector<quint64> offsets;
+};
+
+#endif // TABLEBASE_H
@@ -0,0 +1,44 @@
+// tablebasegenerator.h - Offline retrograde solver that writes tablebase files
+#ifndef TABLEBASEGENERATOR_H
+#define TABLEBASEGENERATOR_H
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include "tablebase.h"
+
+// Solves every position with up to maxEmpty empty cells, one layer at a
+// time starting from full boards. Each layer only depends on the one below
+// it, so only two layers are ever in memory and the positions of a layer
+// are solved in parallel. Finished layers are flushed to disk before the
+// header counts them, and an existing file for the same board is resumed.
+class TablebaseGenerator : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TablebaseGenerator(QObject* parent = nullptr);
+
+    void setBoard(int size, int winLength);
+    void setMaxEmpty(int empty);  // Clamped to the number of cells
+    void setThreads(int count);   // 0 uses the global thread pool
+
+    int maxEmpty() const;
+    quint64 fileSize() const;     // Bytes the finished file takes
+
+    bool generate(const QString& path, QString* error = nullptr);
+    void requestStop();           // Thread-safe, stops after the current layer
+
+signals:
+    void layerFinished(int empty, int maxEmpty, quint64 positions);
+
+private:
+    int boardSize;
+    int boardWinLength;
+    int emptyLimit;
+    int threadCount;
+    std::atomic<bool> stopRequested;
+
+    void solveLayer(int empty, const QByteArray& below, QByteArray& layer) const;
+};
+
+#endif // TABLEBASEGENERATOR_H
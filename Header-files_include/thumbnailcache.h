@@ -0,0 +1,85 @@
+// thumbnailcache.h - Final-board thumbnails for the history list
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QJsonObject>
+#include <QMutex>
+#include <QPixmap>
+#include <QSet>
+#include <QStyledItemDelegate>
+#include <QThreadPool>
+#include <atomic>
+
+// Thumbnails are drawn into a QImage on a private thread pool, or read back
+// from the disk directory if an earlier run already drew them, and handed to
+// the GUI thread as pixmaps. Pixmaps are kept in memory up to a byte budget.
+// Later requests run first, so rows scrolled into view jump the queue ahead
+// of rows that have already scrolled past; a row asked for again after many
+// newer requests is moved back to the front.
+class ThumbnailCache : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ThumbnailCache(int side, QObject* parent = nullptr);
+    ~ThumbnailCache();
+
+    void setByteBudget(qint64 bytes);
+    void setDiskDirectory(const QString& path); // Empty keeps thumbnails in memory only
+    int side() const;
+
+    // Identifies a game by what it looks like, so a re-imported copy shares the file
+    static QString gameKey(const QJsonObject& record);
+    static QImage render(const QJsonObject& record, int side);
+
+    QPixmap thumbnail(const QString& key) const;   // Null until ready
+    void request(const QString& key, const QJsonObject& record);
+    void cancelPending();                          // Queued requests are dropped, running ones finish
+
+    qint64 rendered() const;                       // Drawn rather than read from disk
+    qint64 cachedBytes() const;
+
+signals:
+    void thumbnailReady(const QString& key);
+
+private:
+    int thumbSide;
+    QString diskPath;
+    QThreadPool pool;
+    QCache<QString, QPixmap> pixmaps;   // GUI thread only, cost in bytes
+    int nextPriority;
+
+    struct QueuedJob {
+        QRunnable* job;
+        int priority;
+    };
+
+    mutable QMutex mutex;
+    QHash<QString, QueuedJob> queued;   // Not started yet, so they can be re-queued
+    QSet<QString> running;
+    std::atomic<qint64> renderCount;
+
+    void load(const QString& key, const QJsonObject& record);
+    void deliver(const QString& key, const QImage& image);
+};
+
+// Shows each row's thumbnail as its decoration, asking for it on first paint
+class ThumbnailDelegate : public QStyledItemDelegate {
+public:
+    static const int KeyRole = Qt::UserRole + 1;
+    static const int RecordRole = Qt::UserRole + 2;
+
+    ThumbnailDelegate(ThumbnailCache* cache, QObject* parent = nullptr);
+
+protected:
+    void initStyleOption(QStyleOptionViewItem* option, const QModelIndex& index) const override;
+
+private:
+    ThumbnailCache* cache;
+    QPixmap placeholder;
+};
+
+#endif // THUMBNAILCACHE_H
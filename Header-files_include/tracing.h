@@ -0,0 +1,63 @@
+// tracing.h - Scoped spans on hot paths, exported as Chrome trace events
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+#include <QJsonObject>
+#include <atomic>
+
+// Spans are written to a ring buffer owned by the thread that records them,
+// so recording never locks; only a thread's first span registers its buffer.
+// Each buffer keeps the newest BufferEvents spans. A buffer whose thread has
+// ended goes to the next new thread once its spans were exported or cleared,
+// or sooner when MaxThreadBuffers are registered. While tracing is off a
+// span costs one relaxed load. The export opens in chrome://tracing or
+// Perfetto, and may be taken while other threads are still recording.
+class Tracer {
+public:
+    static const int BufferEvents = 16384; // Per thread, a power of two
+    static const int MaxThreadBuffers = 64; // Beyond this, ended threads' spans make way even unexported
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    static qint64 now();                   // Nanoseconds on the trace clock
+    static void record(const char* name, qint64 startNs, qint64 endNs); // name must outlive the tracer
+    static void clear();                   // Forget everything recorded so far
+    static int eventCount();
+    static int threadBufferCount();        // Allocated so far, whether their threads still run or not
+
+    static QJsonObject toChromeTrace();
+    static bool writeChromeTrace(const QString& path);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Records the time from construction to the end of the scope
+class TraceScope {
+public:
+    explicit TraceScope(const char* spanName) : name(Tracer::isEnabled() ? spanName : nullptr),
+    start(name ? Tracer::now() : 0) {
+    }
+    ~TraceScope() {
+        if (name) {
+            Tracer::record(name, start, Tracer::now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    qint64 start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif // TRACING_H
@@ -0,0 +1,60 @@
+// ultimateboard.h - Bitboard state for ultimate tic-tac-toe
+#ifndef ULTIMATEBOARD_H
+#define ULTIMATEBOARD_H
+
+#include <QtGlobal>
+#include "gametypes.h"
+
+// Nine 3x3 boards, each with one 9-bit mask per player. Cell index =
+// board * 9 + square, both numbered row by row, so the square a move is
+// played on names the board the opponent must answer in. When that board is
+// already won or full the opponent may play on any open board. Three won
+// boards in a line win the game; when every board is closed first it is a tie.
+class UltimateBoard {
+public:
+    static const int Cells = 81;
+    static const int AnyBoard = -1;
+
+    UltimateBoard();
+
+    Player at(int cell) const;
+    Player toMove() const { return (plies % 2 == 0) ? Player::X : Player::O; }
+    int moveCount() const { return plies; }
+    int forcedBoard() const { return forced; } // AnyBoard when the mover may choose
+    quint64 hash() const { return zobrist; }
+
+    quint16 localStones(int board, Player player) const;
+    quint16 boardsWon(Player player) const;
+    quint16 closedBoards() const { return closed; } // Won or full
+    Player boardWinner(int board) const;
+
+    bool isLegal(int cell) const;
+    int legalMoves(int* out) const; // Writes at most 81 cells, returns the count
+    void play(int cell);            // Must be legal
+    void undo();                    // Takes back the last move
+
+    Player winner() const { return result; }
+    bool isOver() const { return over; }
+
+    // Conversions to the 9x9 grid the user sees
+    static int cellAt(int row, int col);
+    static int rowOf(int cell);
+    static int colOf(int cell);
+    static bool isLine(quint16 squares); // Do the squares hold three in a row?
+
+private:
+    quint16 local[2][9];
+    quint16 macro[2];
+    quint16 closed;
+    qint8 history[Cells];     // Cells in the order they were played
+    qint8 forcedBefore[Cells]; // Forced board before each move, for undo
+    int forced;
+    int plies;
+    Player result;
+    bool over;
+    quint64 zobrist;
+
+    void updateResult();
+};
+
+#endif // ULTIMATEBOARD_H
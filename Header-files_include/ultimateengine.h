@@ -0,0 +1,61 @@
+// ultimateengine.h - Alpha-beta search for ultimate tic-tac-toe
+#ifndef ULTIMATEENGINE_H
+#define ULTIMATEENGINE_H
+
+#include <QElapsedTimer>
+#include <QVector>
+#include "searchengine.h"
+#include "ultimateboard.h"
+
+// Same iterative-deepening negamax as SearchEngine, on an UltimateBoard.
+// Cells in results use the UltimateBoard numbering (board * 9 + square).
+// A heuristic is unavoidable here, so the score mixes boards won, open
+// lines on the big board and open lines inside the boards still in play.
+class UltimateEngine {
+public:
+    static const int WinScore = SearchEngine::WinScore;
+
+    UltimateEngine();
+
+    SearchResult search(const UltimateBoard& root, const SearchLimits& limits);
+    void clearTables();
+    void setStopFlag(const std::atomic<bool>* flag); // Set from any thread to abort, even depth 1; may be null
+
+    // Static evaluation for the side to move
+    static int evaluate(const UltimateBoard& board);
+
+private:
+    static const int TableBits = 18;
+    static const int MaxPly = UltimateBoard::Cells + 1;
+    static const int HistoryLimit = (1 << 20) - 1; // Saturates, below the tactical bonuses once scaled
+
+    enum Bound : quint8 { BoundExact, BoundLower, BoundUpper };
+
+    struct TTEntry {
+        quint64 key = 0;
+        int score = 0;
+        qint8 depth = -1;
+        quint8 bound = BoundExact;
+        qint8 bestCell = -1;
+    };
+
+    QVector<TTEntry> table;
+    int history[2][UltimateBoard::Cells];
+    int killers[MaxPly][2];
+
+    const std::atomic<bool>* stopFlag;
+
+    QElapsedTimer timer;
+    qint64 deadlineMs;
+    bool aborted;
+    SearchStats stats;
+    QVector<RootScore> iterationScores;
+
+    int orderMoves(const UltimateBoard& board, int ply, int ttCell, int* moves) const;
+    int rootSearch(UltimateBoard& board, int depth, int preferredCell, bool scoreAll, int* bestCell);
+    int negamax(UltimateBoard& board, int depth, int ply, int alpha, int beta);
+    bool outOfTime();
+    QVector<int> principalVariation(const UltimateBoard& root, int cell, int maxLength) const;
+};
+
+#endif // ULTIMATEENGINE_H
@@ -9,38 +9,72 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QFuture>
+#include "leaderboard.h"
+#include "historyindex.h"
 
 struct User {
     QString username;
     QString passwordHash;
-    QJsonArray gameHistory;
+    int rating = 1200;
+    int ratedGames = 0;
 };
 
 class UserAuth {
     friend class IntegrationTest;
 public:
-    UserAuth();
+    // In the background, users.json is parsed on another thread and the
+    // first call that needs the users waits for it
+    explicit UserAuth(bool loadInBackground = false);
     ~UserAuth();
 
+    void waitForLoad() const;
+    bool isLoadPending() const;
+
     bool signUp(const QString& username, const QString& password);
     bool signIn(const QString& username, const QString& password);
     bool isLoggedIn() const;
     QString getCurrentUser() const;
     void signOut();
     bool saveGameToHistory(const QJsonObject& gameData);
-    QJsonArray getGameHistory() const;
+    bool saveGamesToHistory(const QJsonArray& games);
+    QJsonArray getGameHistory() const;  // Read from the history file on first use after sign-in
+    int getHistorySize() const;         // Without keeping the games in memory
+    const HistoryIndex& getHistoryIndex() const; // Over getGameHistory(), built on first use
+    QString getHistoryFilePath() const; // Signed-in user's stored games, one JSON object per line
+
+    // Ratings and leaderboard
+    int getRating(const QString& username) const;
+    int getRank(const QString& username) const;
+    QVector<LeaderboardEntry> getTopPlayers(int count) const;
+    static int aiRating(const QString& difficulty);
 
 private:
-    QMap<QString, User> users;
+    // Filled in by the first call that needs the users, const ones included
+    mutable QMap<QString, User> users;
     QString currentUser;
     bool loggedIn;
     bool isValidEmail(const QString& email);
     bool isValidPassword(const QString& password);
     bool isValidUsername(const QString& username);
     QString hashPassword(const QString& password);
-    bool loadUsersFromFile();
+    static QMap<QString, User> readUsersFile(const QString& path);
+    static QString historyFilePath(const QString& usersPath, const QString& username);
+    static QJsonArray readHistoryFile(const QString& path);
+    static int countHistoryFile(const QString& path);
+    static bool appendToHistoryFile(const QString& path, const QJsonArray& games);
+    void adoptUsers(const QMap<QString, User>& loaded) const;
     bool saveUsersToFile();
+    mutable QFuture<QMap<QString, User>> pendingLoad;
+    mutable bool loadPending;
     QString usersFilePath;
+    mutable Leaderboard leaderboard;
+    mutable QJsonArray history;         // Signed-in user only, loaded on demand
+    mutable bool historyLoaded;
+    mutable int historySize;            // -1 until counted
+    mutable HistoryIndex historyIndex; // Signed-in user only
+    mutable bool historyIndexBuilt;
+    void updateRatings(const QJsonObject& gameData);
 };
 
 #endif // USERAUTH_H
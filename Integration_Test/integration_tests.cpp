@@ -2,6 +2,11 @@
 #include "gamelogic.h"
 #include "mainwindow.h"
 #include "userauth.h"
+#include "gameimporter.h"
+#include "historystreamer.h"
+#include "boardwidget.h"
+#include "thumbnailcache.h"
+#include <QTemporaryDir>
 
 // Test class for integration tests
 class IntegrationTest : public QObject {
@@ -10,6 +15,12 @@ private slots:
     void testLoginAndStartAIGame();
     void testGameLogicVsAI();
     void testGameEndAndHistory();
+    void testUndoAfterGameEnd();
+    void testBulkImport();
+    void testHistoryStreaming();
+    void testBoardWidget();
+    void testLazyStartup();
+    void testHistoryThumbnails();
 };
 
 void IntegrationTest::testLoginAndStartAIGame() {
@@ -103,5 +114,263 @@ void IntegrationTest::testGameEndAndHistory() {
     QVERIFY(lastGame["moves"].toArray().size() > 0);
 }
 
+void IntegrationTest::testUndoAfterGameEnd() {
+    UserAuth auth;
+    QString username = "undouser";
+    QString password = "Password5!";
+    if (!auth.signIn(username, password)) {
+        QVERIFY(auth.signUp(username, password));
+        QVERIFY(auth.signIn(username, password));
+    }
+    int stored = auth.getGameHistory().size();
+
+    // The game page saves a game when it ends, and an ended game stays ended
+    MainWindow window(&auth);
+    window.showGameModePage();
+    window.startTwoPlayerGame();
+    QSignalSpy ended(window.gameLogic, &GameLogic::gameEnded);
+    for (int cell : { 0, 3, 1, 4, 2 }) {
+        QVERIFY(window.gameLogic->makeMove(cell / 3, cell % 3));
+    }
+    QCOMPARE(ended.count(), 1);
+    QVERIFY(!window.gameLogic->undo());
+    QVERIFY(!window.gameLogic->redo());
+    QTRY_VERIFY(!window.undoButton->isEnabled());
+    QCOMPARE(ended.count(), 1);
+    QCOMPARE(auth.getGameHistory().size(), stored + 1);
+}
+
+void IntegrationTest::testBulkImport() {
+    UserAuth auth;
+    QString username = "importuser";
+    QString password = "Password3!";
+
+    if (!auth.signIn(username, password)) {
+        QVERIFY(auth.signUp(username, password));
+        QVERIFY(auth.signIn(username, password));
+    }
+    int historyBefore = auth.getGameHistory().size();
+
+    // Build a mix of real games and damaged copies
+    QJsonArray records;
+    for (int i = 0; i < 300; ++i) {
+        GameLogic logic;
+        logic.newGame(false);
+        int cell = 0;
+        while (!logic.isGameOver()) {
+            logic.makeMove(cell / 3, cell % 3);
+            ++cell;
+        }
+        QJsonObject gameData = logic.getGameAsJson();
+        if (i % 10 == 0) {
+            gameData["result"] = "O wins"; // Wrong result
+        } else if (i % 10 == 1) {
+            gameData["moves"] = QJsonArray(); // Empty game, also contradicts its result
+        } else if (i % 10 == 2) {
+            gameData.remove("moves");
+        }
+        records.append(gameData);
+    }
+
+    GameImporter importer;
+    importer.setBatchSize(64);
+    int progressCalls = 0;
+    connect(&importer, &GameImporter::progress, this, [&](int, int) { ++progressCalls; });
+
+    ImportReport report = importer.importToHistory(records, &auth);
+    QCOMPARE(report.total, 300);
+    QCOMPARE(report.rejected, 90);
+    QCOMPARE(report.accepted, 210);
+    QCOMPARE(report.committed, 210);
+    QCOMPARE(report.issues.size(), 90);
+    QCOMPARE(report.issues.first().index, 0);
+    QCOMPARE(progressCalls, 4);
+    QCOMPARE(auth.getGameHistory().size(), historyBefore + 210);
+
+    // With repair on, wrong results are rewritten instead of rejected
+    importer.setRepairResults(true);
+    QVector<QJsonObject> accepted;
+    report = importer.validate(records, &accepted);
+    QCOMPARE(report.repaired, 60);
+    QCOMPARE(report.rejected, 30);
+    QCOMPARE(accepted.first()["result"].toString(), QString("X wins"));
+}
+
+void IntegrationTest::testHistoryStreaming() {
+    UserAuth auth;
+    QString username = "streamuser";
+    QString password = "Password4!";
+
+    if (!auth.signIn(username, password)) {
+        QVERIFY(auth.signUp(username, password));
+        QVERIFY(auth.signIn(username, password));
+    }
+
+    GameLogic logic;
+    logic.newGame(false);
+    logic.makeMove(0, 0);
+    logic.makeMove(1, 1);
+    QVERIFY(auth.saveGameToHistory(logic.getGameAsJson()));
+    int historySize = auth.getGameHistory().size();
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.filePath("history.ndjson");
+
+    HistoryStreamer streamer;
+    streamer.setBatchSize(2);
+    QVERIFY(streamer.exportHistory(&auth, path));
+
+    // Append a broken line; the rest of the file must still import
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::Append));
+    file.write("{not json\n");
+    file.close();
+
+    qint64 lastDone = 0;
+    qint64 lastTotal = -1;
+    connect(&streamer, &HistoryStreamer::progress, this, [&](qint64 done, qint64 total) {
+        lastDone = done;
+        lastTotal = total;
+    });
+
+    ImportReport report = streamer.importHistory(path, &auth);
+    QCOMPARE(report.total, historySize + 1);
+    QCOMPARE(report.committed, historySize);
+    QCOMPARE(report.rejected, 1);
+    QCOMPARE(report.issues.last().index, historySize + 1);
+    QCOMPARE(lastDone, lastTotal);
+
+    // The import only appended to the file; the games are read when next wanted
+    QVERIFY(!auth.historyLoaded);
+    QCOMPARE(auth.getHistorySize(), historySize * 2);
+    QCOMPARE(auth.getGameHistory().size(), historySize * 2);
+
+    // Batches were appended to the user's history file, which a fresh load reads back
+    QFile stored(auth.getHistoryFilePath());
+    QVERIFY(stored.open(QIODevice::ReadOnly));
+    int storedLines = 0;
+    while (!stored.atEnd()) {
+        storedLines += stored.readLine().trimmed().isEmpty() ? 0 : 1;
+    }
+    QCOMPARE(storedLines, historySize * 2);
+    UserAuth reloaded;
+    QVERIFY(reloaded.signIn(username, password));
+    QCOMPARE(reloaded.getGameHistory().size(), historySize * 2);
+}
+
+void IntegrationTest::testBoardWidget() {
+    // Clicks are mapped to cells by the widget itself
+    BoardWidget board(300);
+    QSignalSpy spy(&board, &BoardWidget::cellClicked);
+    board.setBoardSize(5);
+    QRect rect = board.cellRect(2, 3);
+    QCOMPARE(board.cellAt(rect.center()), 2 * 5 + 3);
+    QCOMPARE(board.cellAt(QPoint(rect.right() + 1, rect.center().y())), -1);
+    QTest::mouseClick(&board, Qt::LeftButton, Qt::NoModifier, rect.center());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toInt(), 2);
+    QCOMPARE(spy.at(0).at(1).toInt(), 3);
+
+    board.setInteractive(false);
+    QTest::mouseClick(&board, Qt::LeftButton, Qt::NoModifier, rect.center());
+    QCOMPARE(spy.count(), 1);
+
+    // Ultimate boards are set apart by a wider gap
+    board.setBoardSize(9);
+    board.setSubBoards(true);
+    int insideGap = board.cellRect(0, 1).left() - board.cellRect(0, 0).right();
+    int boardGap = board.cellRect(0, 3).left() - board.cellRect(0, 2).right();
+    QVERIFY(boardGap > insideGap);
+
+    // The game page plays through it, on the board size picked beforehand
+    UserAuth auth;
+    MainWindow window(&auth);
+    window.showGameModePage();
+    window.boardComboBox->setCurrentIndex(2); // 5 x 5, four in a row
+    window.startAIGame();
+    QTRY_COMPARE(window.boardView->boardSize(), 5); // Board changes arrive on the next event loop turn
+    QTest::mouseClick(window.boardView, Qt::LeftButton, Qt::NoModifier, window.boardView->cellRect(0, 0).center());
+    QCOMPARE(window.gameLogic->getMoves().size(), 2);
+    QTRY_COMPARE(window.boardView->cell(0, 0), Player::X);
+    Move reply = window.gameLogic->getMoves().last();
+    QCOMPARE(window.boardView->cell(reply.row, reply.col), Player::O);
+}
+
+void IntegrationTest::testLazyStartup() {
+    // Users parsed in the background are there by the time anything asks
+    {
+        UserAuth auth;
+        if (!auth.signIn("testuser", "Password1!")) {
+            QVERIFY(auth.signUp("testuser", "Password1!"));
+        }
+    }
+    UserAuth auth(true);
+    QVERIFY(auth.signIn("testuser", "Password1!"));
+    QVERIFY(!auth.isLoadPending());
+
+    // Only the login page exists until the others are visited
+    MainWindow window(&auth);
+    QCOMPARE(window.stackedWidget->count(), 1);
+    QVERIFY(window.gamePage == nullptr);
+    QVERIFY(window.historyPage == nullptr);
+    window.showMenuPage();
+    window.showGameModePage();
+    window.showGameModePage();
+    QCOMPARE(window.stackedWidget->count(), 3);
+    QVERIFY(window.gamePage == nullptr);
+
+    // Phases are recorded in order up to the login page taking input
+    StartupTimings timings;
+    window.showLoginPage();
+    window.setStartupTimings(&timings);
+    QSignalSpy spy(&window, &MainWindow::startupCompleted);
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+    QTRY_COMPARE(spy.count(), 1);
+    QVERIFY(timings.elapsedNs(StartupTimings::FirstPaint) <= timings.elapsedNs(StartupTimings::Interactive));
+}
+
+void IntegrationTest::testHistoryThumbnails() {
+    QTemporaryDir dir;
+    GameLogic logic;
+    logic.newGame(false);
+    logic.makeMove(0, 0);
+    logic.makeMove(1, 1);
+    QJsonObject first = logic.getGameAsJson();
+    logic.makeMove(0, 1);
+    QJsonObject second = logic.getGameAsJson();
+    QString firstKey = ThumbnailCache::gameKey(first);
+    QString secondKey = ThumbnailCache::gameKey(second);
+    QVERIFY(firstKey != secondKey);
+
+    // Drawn once on the pool, however often it is asked for
+    {
+        ThumbnailCache cache(32);
+        cache.setDiskDirectory(dir.path());
+        QSignalSpy spy(&cache, &ThumbnailCache::thumbnailReady);
+        cache.request(firstKey, first);
+        cache.request(firstKey, first);
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(cache.thumbnail(firstKey).size(), QSize(32, 32));
+        QCOMPARE(cache.rendered(), qint64(1));
+    }
+
+    // The next run reads it back from disk, and the byte budget holds one thumbnail
+    ThumbnailCache cache(32);
+    cache.setDiskDirectory(dir.path());
+    cache.setByteBudget(32 * 32 * 4);
+    QSignalSpy spy(&cache, &ThumbnailCache::thumbnailReady);
+    cache.request(firstKey, first);
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(cache.rendered(), qint64(0));
+    cache.request(secondKey, second);
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(cache.rendered(), qint64(1));
+    QVERIFY(cache.thumbnail(firstKey).isNull());
+    QVERIFY(!cache.thumbnail(secondKey).isNull());
+    QVERIFY(cache.cachedBytes() <= 32 * 32 * 4);
+}
+
 QTEST_MAIN(IntegrationTest)
 #include "integration_tests.moc"
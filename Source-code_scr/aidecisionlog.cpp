@@ -0,0 +1,100 @@
+// aidecisionlog.cpp - Per-move AI statistics and a rolling log of them
+#include "aidecisionlog.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+QJsonObject AIDecisionStats::toJson() const {
+    QJsonObject json;
+    json["time"] = timestamp.toString(Qt::ISODateWithMs);
+    json["move"] = moveNumber;
+    json["backend"] = backend;
+    json["difficulty"] = static_cast<int>(difficulty);
+    json["random"] = randomMove;
+    json["cell"] = cell;
+    json["boardSize"] = boardSize;
+    json["nodes"] = nodes;
+    json["depth"] = depth;
+    json["cacheHits"] = cacheHits;
+    json["timedOut"] = timedOut;
+    json["pondered"] = pondered;
+    json["searchMs"] = searchMs;
+    json["ponderMs"] = ponderMs;
+    json["wallMs"] = wallMs;
+
+    QJsonArray pv;
+    for (int pvCell : principalVariation) {
+        pv.append(pvCell);
+    }
+    json["pv"] = pv;
+
+    QJsonArray moves;
+    for (const AICandidate& candidate : candidates) {
+        QJsonObject entry;
+        entry["cell"] = candidate.cell;
+        entry["score"] = candidate.score;
+        if (candidate.upperBound) {
+            entry["upperBound"] = true;
+        }
+        if (candidate.visits > 0) {
+            entry["visits"] = candidate.visits;
+        }
+        moves.append(entry);
+    }
+    json["candidates"] = moves;
+    return json;
+}
+
+AIDecisionLog::AIDecisionLog() : maxBytes(1024 * 1024), maxFiles(3) {
+}
+
+void AIDecisionLog::setPath(const QString& path) {
+    filePath = path;
+}
+
+QString AIDecisionLog::path() const {
+    return filePath;
+}
+
+void AIDecisionLog::setMaxBytes(qint64 bytes) {
+    maxBytes = qMax<qint64>(1, bytes);
+}
+
+void AIDecisionLog::setMaxFiles(int count) {
+    maxFiles = qMax(0, count);
+}
+
+void AIDecisionLog::rotate() {
+    // Drop the oldest file and shift the rest up by one
+    QFile::remove(filePath + "." + QString::number(maxFiles));
+    for (int i = maxFiles - 1; i >= 1; --i) {
+        QFile::rename(filePath + "." + QString::number(i), filePath + "." + QString::number(i + 1));
+    }
+    if (maxFiles > 0) {
+        QFile::rename(filePath, filePath + ".1");
+    } else {
+        QFile::remove(filePath);
+    }
+}
+
+bool AIDecisionLog::append(const AIDecisionStats& stats) {
+    if (filePath.isEmpty()) {
+        return false;
+    }
+
+    QByteArray line = QJsonDocument(stats.toJson()).toJson(QJsonDocument::Compact);
+    line.append('\n');
+
+    // Start a new file rather than letting one grow without bound
+    QFileInfo info(filePath);
+    if (info.exists() && info.size() > 0 && info.size() + line.size() > maxBytes) {
+        rotate();
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+    return file.write(line) == line.size();
+}
@@ -0,0 +1,156 @@
+// boardstate.cpp - Compact bitboard for N x N, k-in-a-row positions
+#include "boardstate.h"
+#include <QVector>
+
+namespace {
+
+struct ZobristKeys {
+    quint64 keys[2][BoardState::MaxSize * BoardState::MaxSize];
+
+    ZobristKeys() {
+        // Fixed splitmix64 sequence so hashes are stable between runs
+        quint64 state = 0x2545F4914F6CDD1DULL;
+        for (int side = 0; side < 2; ++side) {
+            for (int cell = 0; cell < BoardState::MaxSize * BoardState::MaxSize; ++cell) {
+                state += 0x9E3779B97F4A7C15ULL;
+                quint64 z = state;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                keys[side][cell] = z ^ (z >> 31);
+            }
+        }
+    }
+};
+
+struct WindowTable {
+    QVector<quint64> masks[BoardState::MaxSize + 1][BoardState::MaxSize + 1];
+
+    WindowTable() {
+        const int directions[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+        for (int n = 1; n <= BoardState::MaxSize; ++n) {
+            for (int k = 1; k <= n; ++k) {
+                for (int row = 0; row < n; ++row) {
+                    for (int col = 0; col < n; ++col) {
+                        for (const auto& d : directions) {
+                            int endRow = row + d[0] * (k - 1);
+                            int endCol = col + d[1] * (k - 1);
+                            if (endRow >= n || endCol < 0 || endCol >= n) {
+                                continue;
+                            }
+                            // A single cell is the same window in every direction
+                            if (k == 1 && (d[0] != 0 || d[1] != 1)) {
+                                continue;
+                            }
+                            quint64 mask = 0;
+                            for (int i = 0; i < k; ++i) {
+                                mask |= 1ULL << ((row + d[0] * i) * n + col + d[1] * i);
+                            }
+                            masks[n][k].append(mask);
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+const ZobristKeys& zobristKeys() {
+    static const ZobristKeys keys;
+    return keys;
+}
+
+} // namespace
+
+BoardState::BoardState(int size, int winLength) :
+n(qBound(1, size, int(MaxSize))), k(qBound(1, winLength, n)), plies(0), xBits(0), oBits(0), zobrist(0) {
+    int cells = n * n;
+    fullMask = (cells == 64) ? ~0ULL : ((1ULL << cells) - 1);
+}
+
+Player BoardState::at(int cell) const {
+    quint64 bit = 1ULL << cell;
+    if (xBits & bit) {
+        return Player::X;
+    }
+    if (oBits & bit) {
+        return Player::O;
+    }
+    return Player::None;
+}
+
+void BoardState::play(int cell) {
+    quint64 bit = 1ULL << cell;
+    if (plies % 2 == 0) {
+        xBits |= bit;
+        zobrist ^= zobristKeys().keys[0][cell];
+    } else {
+        oBits |= bit;
+        zobrist ^= zobristKeys().keys[1][cell];
+    }
+    ++plies;
+}
+
+void BoardState::undo(int cell) {
+    quint64 bit = 1ULL << cell;
+    --plies;
+    if (plies % 2 == 0) {
+        xBits &= ~bit;
+        zobrist ^= zobristKeys().keys[0][cell];
+    } else {
+        oBits &= ~bit;
+        zobrist ^= zobristKeys().keys[1][cell];
+    }
+}
+
+int BoardState::runLength(int row, int col, int dRow, int dCol, quint64 bits) const {
+    int length = 0;
+    row += dRow;
+    col += dCol;
+    while (row >= 0 && row < n && col >= 0 && col < n && (bits & (1ULL << (row * n + col)))) {
+        ++length;
+        row += dRow;
+        col += dCol;
+    }
+    return length;
+}
+
+bool BoardState::wins(int cell) const {
+    quint64 bit = 1ULL << cell;
+    quint64 bits = (xBits & bit) ? xBits : ((oBits & bit) ? oBits : 0);
+    return bits && completesLine(cell, bits);
+}
+
+bool BoardState::winsFor(int cell, Player player) const {
+    return completesLine(cell, stones(player) | (1ULL << cell));
+}
+
+bool BoardState::completesLine(int cell, quint64 bits) const {
+    // Count stones in both directions along each line through the cell
+    int row = cell / n;
+    int col = cell % n;
+    const int directions[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+    for (const auto& d : directions) {
+        int length = 1 + runLength(row, col, d[0], d[1], bits) + runLength(row, col, -d[0], -d[1], bits);
+        if (length >= k) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Player BoardState::findWinner() const {
+    for (quint64 window : windows(n, k)) {
+        if ((xBits & window) == window) {
+            return Player::X;
+        }
+        if ((oBits & window) == window) {
+            return Player::O;
+        }
+    }
+    return Player::None;
+}
+
+const QVector<quint64>& BoardState::windows(int size, int winLength) {
+    static const WindowTable table;
+    return table.masks[size][winLength];
+}
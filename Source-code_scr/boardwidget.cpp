@@ -0,0 +1,300 @@
+// boardwidget.cpp - Custom-painted game board for the live and replay pages
+#include "boardwidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QLinearGradient>
+
+BoardWidget::BoardWidget(int boardPixels, QWidget* parent) : QWidget(parent),
+pixels(boardPixels), size(0), interactive(true), subBoards(false), forcedBoard(-1), hoveredCell(-1),
+subBoardWinners(9, Player::None), tileSide(0) {
+    setMouseTracking(true);
+    setFixedSize(pixels, pixels);
+    setBoardSize(3);
+}
+
+void BoardWidget::setBoardSize(int newSize) {
+    if (newSize == size) {
+        return;
+    }
+    size = newSize;
+    cells.fill(Player::None, size * size);
+    hints.fill(QColor(), size * size);
+    hoveredCell = -1;
+    tileSide = 0; // Cells changed size, so do the tiles
+    update();
+}
+
+int BoardWidget::boardSize() const {
+    return size;
+}
+
+void BoardWidget::setCell(int row, int col, Player player) {
+    int index = row * size + col;
+    if (index < 0 || index >= cells.size() || cells[index] == player) {
+        return;
+    }
+    cells[index] = player;
+    if (index == hoveredCell) {
+        hoveredCell = -1;
+    }
+    updateCell(index);
+}
+
+Player BoardWidget::cell(int row, int col) const {
+    int index = row * size + col;
+    return (index >= 0 && index < cells.size()) ? cells[index] : Player::None;
+}
+
+void BoardWidget::setInteractive(bool enabled) {
+    interactive = enabled;
+    setMouseTracking(enabled);
+    if (!enabled && hoveredCell >= 0) {
+        int previous = hoveredCell;
+        hoveredCell = -1;
+        updateCell(previous);
+    }
+}
+
+void BoardWidget::setHint(int row, int col, const QColor& color) {
+    int index = row * size + col;
+    if (index < 0 || index >= hints.size() || hints[index] == color) {
+        return;
+    }
+    hints[index] = color;
+    updateCell(index);
+}
+
+void BoardWidget::setSubBoards(bool enabled) {
+    if (enabled == subBoards) {
+        return;
+    }
+    subBoards = enabled;
+    tileSide = 0; // The separators take room from the cells
+    update();
+}
+
+void BoardWidget::setForcedBoard(int board) {
+    if (board == forcedBoard) {
+        return;
+    }
+    // Only the outlines of the old and new boards change
+    if (forcedBoard >= 0) {
+        update(subBoardRect(forcedBoard));
+    }
+    forcedBoard = board;
+    if (forcedBoard >= 0) {
+        update(subBoardRect(forcedBoard));
+    }
+}
+
+void BoardWidget::setSubBoardWinner(int board, Player winner) {
+    if (board < 0 || board >= 9 || subBoardWinners[board] == winner) {
+        return;
+    }
+    subBoardWinners[board] = winner;
+    update(subBoardRect(board));
+}
+
+int BoardWidget::gap() const {
+    return qMax(2, pixels / (size * 24));
+}
+
+int BoardWidget::cellSide() const {
+    // Boards of an ultimate game are set apart by three gaps instead of one
+    int side = qMin(width(), height());
+    int separators = subBoards ? 4 * gap() : 0;
+    return qMax(1, (side - (size + 1) * gap() - separators) / size);
+}
+
+QRect BoardWidget::cellRect(int row, int col) const {
+    int cellPixels = cellSide();
+    int step = cellPixels + gap();
+    int used = size * step + gap() + (subBoards ? 4 * gap() : 0);
+    int left = (width() - used) / 2 + gap() + col * step + (subBoards ? (col / 3) * 2 * gap() : 0);
+    int top = (height() - used) / 2 + gap() + row * step + (subBoards ? (row / 3) * 2 * gap() : 0);
+    return QRect(left, top, cellPixels, cellPixels);
+}
+
+QRect BoardWidget::subBoardRect(int board) const {
+    QRect first = cellRect((board / 3) * 3, (board % 3) * 3);
+    QRect last = cellRect((board / 3) * 3 + 2, (board % 3) * 3 + 2);
+    int margin = gap() + 1;
+    return first.united(last).adjusted(-margin, -margin, margin, margin);
+}
+
+int BoardWidget::cellAt(const QPoint& pos) const {
+    for (int row = 0; row < size; ++row) {
+        if (pos.y() < cellRect(row, 0).top() || pos.y() > cellRect(row, 0).bottom()) {
+            continue;
+        }
+        for (int col = 0; col < size; ++col) {
+            if (cellRect(row, col).contains(pos)) {
+                return row * size + col;
+            }
+        }
+    }
+    return -1;
+}
+
+QSize BoardWidget::sizeHint() const {
+    return QSize(pixels, pixels);
+}
+
+void BoardWidget::updateCell(int index) {
+    update(cellRect(index / size, index % size));
+}
+
+QPixmap BoardWidget::renderTile(const QColor& top, const QColor& bottom, const QColor& border, Player mark) const {
+    // Drawn at device resolution so the tiles stay sharp on high-DPI screens
+    qreal ratio = devicePixelRatioF();
+    QPixmap tile(QSize(tileSide, tileSide) * ratio);
+    tile.setDevicePixelRatio(ratio);
+    tile.fill(Qt::transparent);
+
+    QPainter painter(&tile);
+    painter.setRenderHint(QPainter::Antialiasing);
+    qreal pen = qMax(2.0, tileSide / 25.0);
+    QRectF frame(pen / 2, pen / 2, tileSide - pen, tileSide - pen);
+    QLinearGradient gradient(frame.topLeft(), frame.bottomRight());
+    gradient.setColorAt(0, top);
+    gradient.setColorAt(1, bottom);
+    painter.setBrush(gradient);
+    painter.setPen(QPen(border, pen));
+    painter.drawRoundedRect(frame, tileSide / 7.0, tileSide / 7.0);
+
+    QRectF glyph = frame.adjusted(tileSide / 4.0, tileSide / 4.0, -tileSide / 4.0, -tileSide / 4.0);
+    painter.setPen(QPen(Qt::white, qMax(2.0, tileSide / 9.0), Qt::SolidLine, Qt::RoundCap));
+    painter.setBrush(Qt::NoBrush);
+    if (mark == Player::X) {
+        painter.drawLine(glyph.topLeft(), glyph.bottomRight());
+        painter.drawLine(glyph.topRight(), glyph.bottomLeft());
+    } else if (mark == Player::O) {
+        painter.drawEllipse(glyph);
+    }
+    return tile;
+}
+
+void BoardWidget::renderTiles() {
+    tileSide = cellSide();
+    xTile = renderTile(QColor("#ff7675"), QColor("#fd79a8"), QColor("#e84393"), Player::X);
+    oTile = renderTile(QColor("#74b9ff"), QColor("#0984e3"), QColor("#00b894"), Player::O);
+    emptyTile = renderTile(QColor("#ffffff"), QColor("#e9ecef"), QColor("#495057"), Player::None);
+    hoverTile = renderTile(QColor("#74b9ff"), QColor("#0984e3"), QColor("#f1c40f"), Player::None);
+}
+
+void BoardWidget::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    tileSide = 0;
+}
+
+void BoardWidget::paintEvent(QPaintEvent* event) {
+    if (tileSide != cellSide()) {
+        renderTiles();
+    }
+
+    QPainter painter(this);
+    const QRect dirty = event->rect();
+    for (int index = 0; index < cells.size(); ++index) {
+        QRect rect = cellRect(index / size, index % size);
+        if (!dirty.intersects(rect)) {
+            continue;
+        }
+        if (cells[index] == Player::X) {
+            painter.drawPixmap(rect.topLeft(), xTile);
+        } else if (cells[index] == Player::O) {
+            painter.drawPixmap(rect.topLeft(), oTile);
+        } else if (index == hoveredCell) {
+            painter.drawPixmap(rect.topLeft(), hoverTile);
+        } else if (hints[index].isValid()) {
+            // Hints change every move, a flat fill is cheaper than a tile per color
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setPen(QPen(QColor("#495057"), qMax(2, tileSide / 25)));
+            painter.setBrush(hints[index]);
+            painter.drawRoundedRect(rect.adjusted(1, 1, -1, -1), tileSide / 7.0, tileSide / 7.0);
+        } else {
+            painter.drawPixmap(rect.topLeft(), emptyTile);
+        }
+    }
+
+    if (subBoards) {
+        paintSubBoards(painter, dirty);
+    }
+    painter.end();
+    emit framePainted();
+}
+
+void BoardWidget::paintSubBoards(QPainter& painter, const QRect& dirty) {
+    // Boards already decided get a veil and their owner's mark across them
+    painter.setRenderHint(QPainter::Antialiasing);
+    for (int board = 0; board < 9; ++board) {
+        QRect rect = subBoardRect(board);
+        if (!dirty.intersects(rect) || subBoardWinners[board] == Player::None) {
+            continue;
+        }
+        bool x = (subBoardWinners[board] == Player::X);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QColor(0, 0, 0, 110));
+        painter.drawRoundedRect(rect, gap() * 2, gap() * 2);
+        QRectF glyph = QRectF(rect).adjusted(rect.width() / 5.0, rect.height() / 5.0,
+                                             -rect.width() / 5.0, -rect.height() / 5.0);
+        painter.setPen(QPen(x ? QColor("#e84393") : QColor("#00b894"), rect.width() / 12.0,
+                            Qt::SolidLine, Qt::RoundCap));
+        painter.setBrush(Qt::NoBrush);
+        if (x) {
+            painter.drawLine(glyph.topLeft(), glyph.bottomRight());
+            painter.drawLine(glyph.topRight(), glyph.bottomLeft());
+        } else {
+            painter.drawEllipse(glyph);
+        }
+    }
+
+    // Outline the board the mover was sent to
+    if (forcedBoard >= 0) {
+        painter.setPen(QPen(QColor("#f1c40f"), gap()));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRoundedRect(QRectF(subBoardRect(forcedBoard)).adjusted(gap() / 2.0, gap() / 2.0,
+                                                                            -gap() / 2.0, -gap() / 2.0),
+                                gap() * 2, gap() * 2);
+    }
+}
+
+void BoardWidget::mouseMoveEvent(QMouseEvent* event) {
+    if (!interactive) {
+        return;
+    }
+    int index = cellAt(event->position().toPoint());
+    if (index >= 0 && cells[index] != Player::None) {
+        index = -1; // Only empty cells react
+    }
+    if (index == hoveredCell) {
+        return;
+    }
+    int previous = hoveredCell;
+    hoveredCell = index;
+    if (previous >= 0) {
+        updateCell(previous);
+    }
+    if (index >= 0) {
+        updateCell(index);
+    }
+}
+
+void BoardWidget::leaveEvent(QEvent* event) {
+    QWidget::leaveEvent(event);
+    if (hoveredCell >= 0) {
+        int previous = hoveredCell;
+        hoveredCell = -1;
+        updateCell(previous);
+    }
+}
+
+void BoardWidget::mouseReleaseEvent(QMouseEvent* event) {
+    if (!interactive || event->button() != Qt::LeftButton) {
+        return;
+    }
+    int index = cellAt(event->position().toPoint());
+    if (index >= 0) {
+        emit cellClicked(index / size, index % size);
+    }
+}
@@ -0,0 +1,384 @@
+// gameanalyzer.cpp - Post-game analysis of a whole history on a thread pool
+#include "gameanalyzer.h"
+#include "gamerecord.h"
+#include "searchengine.h"
+#include "ultimateengine.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QThread>
+#include <memory>
+
+namespace {
+// Bump when the scoring changes so summaries from older builds are not reused
+const int AnalysisVersion = 1;
+
+// Games per task; each task builds its own engines, so not too few
+const int BatchSize = 16;
+
+// Won, lost or neither, for the side the score belongs to
+int outcome(int score) {
+    if (!SearchEngine::isWinScore(score)) {
+        return 0;
+    }
+    return (score > 0) ? 1 : -1;
+}
+
+int ultimateToGrid(int cell) {
+    return UltimateBoard::rowOf(cell) * 9 + UltimateBoard::colOf(cell);
+}
+
+// The engines for one task, whose tables carry over from game to game
+class Analyst {
+public:
+    Analyst(int searchDepth, const std::atomic<bool>* stop) : depth(searchDepth), stopFlag(stop) {
+        classic.setStopFlag(stop);
+    }
+
+    // False when stopped part way, leaving *result unfinished
+    bool analyze(const QJsonObject& record, GameAnalysis* result, QVector<MoveAnalysis>* details) {
+        *result = GameAnalysis();
+        RecordCheck check = GameRecordValidator::check(record);
+        if (!check.valid && !check.resultMismatch) {
+            return true;
+        }
+        result->valid = true;
+
+        GameVariant variant = GameVariant::Classic;
+        GameRecordValidator::parseVariant(record["variant"].toString("classic"), &variant);
+        const QJsonArray moves = record["moves"].toArray();
+        SearchLimits limits;
+        limits.scoreAllMoves = true;
+
+        if (variant == GameVariant::Ultimate) {
+            if (!ultimate) {
+                ultimate.reset(new UltimateEngine());
+                ultimate->setStopFlag(stopFlag);
+            }
+            limits.maxDepth = depth;
+            UltimateBoard board;
+            for (const QJsonValue& value : moves) {
+                QJsonObject move = value.toObject();
+                int cell = UltimateBoard::cellAt(move["row"].toInt(), move["col"].toInt());
+                SearchResult search = ultimate->search(board, limits);
+                if (search.timedOut || stopped()) {
+                    return false;
+                }
+                MoveAnalysis scored = score(search, cell, board.toMove());
+                scored.cell = ultimateToGrid(cell);
+                scored.bestCell = (search.cell >= 0) ? ultimateToGrid(search.cell) : -1;
+                add(scored, result, details);
+                board.play(cell);
+            }
+            return true;
+        }
+
+        // 3x3 is solved outright, larger boards are searched to the depth limit
+        int size = record["boardSize"].toInt(3);
+        BoardState state(size, record["winLength"].toInt(3));
+        limits.maxDepth = (state.cellCount() <= 9) ? 0 : depth;
+        for (const QJsonValue& value : moves) {
+            QJsonObject move = value.toObject();
+            int cell = move["row"].toInt() * size + move["col"].toInt();
+            SearchResult search = classic.search(state, limits);
+            if (search.timedOut || stopped()) {
+                return false;
+            }
+            MoveAnalysis scored = score(search, cell, state.toMove());
+            scored.cell = cell;
+            scored.bestCell = search.cell;
+            add(scored, result, details);
+            state.play(cell);
+        }
+        return true;
+    }
+
+private:
+    int depth;
+    const std::atomic<bool>* stopFlag;
+    SearchEngine classic;
+    std::unique_ptr<UltimateEngine> ultimate; // Only built for ultimate games, its table is large
+
+    bool stopped() const {
+        return stopFlag->load(std::memory_order_relaxed);
+    }
+
+    static MoveAnalysis score(const SearchResult& search, int cell, Player mover) {
+        MoveAnalysis move;
+        move.player = mover;
+        move.before = search.score;
+        move.after = search.score;
+        for (const RootScore& rootScore : search.rootScores) {
+            if (rootScore.cell == cell) {
+                move.after = rootScore.score;
+                break;
+            }
+        }
+        int best = outcome(move.before);
+        int played = outcome(move.after);
+        move.accurate = (played == best);
+        move.blunder = (best == 0 && played < 0);
+        move.missedWin = (best > 0 && played <= 0);
+        return move;
+    }
+
+    static void add(const MoveAnalysis& move, GameAnalysis* result, QVector<MoveAnalysis>* details) {
+        int side = (move.player == Player::X) ? 0 : 1;
+        ++result->moves[side];
+        result->accurate[side] += move.accurate ? 1 : 0;
+        result->blunders[side] += move.blunder ? 1 : 0;
+        result->missedWins[side] += move.missedWin ? 1 : 0;
+        if (details) {
+            details->append(move);
+        }
+    }
+};
+
+QJsonArray toJson(const GameAnalysis& analysis) {
+    QJsonArray entry;
+    if (!analysis.valid) {
+        return entry; // Empty marks a record that cannot be replayed
+    }
+    for (int side = 0; side < 2; ++side) {
+        entry.append(analysis.moves[side]);
+        entry.append(analysis.accurate[side]);
+        entry.append(analysis.blunders[side]);
+        entry.append(analysis.missedWins[side]);
+    }
+    return entry;
+}
+
+GameAnalysis fromJson(const QJsonArray& entry) {
+    GameAnalysis analysis;
+    if (entry.size() != 8) {
+        return analysis;
+    }
+    analysis.valid = true;
+    for (int side = 0; side < 2; ++side) {
+        analysis.moves[side] = entry[side * 4].toInt();
+        analysis.accurate[side] = entry[side * 4 + 1].toInt();
+        analysis.blunders[side] = entry[side * 4 + 2].toInt();
+        analysis.missedWins[side] = entry[side * 4 + 3].toInt();
+    }
+    return analysis;
+}
+}
+
+int GameAnalysis::accuracy(Player player) const {
+    int side = (player == Player::X) ? 0 : 1;
+    if (moves[side] == 0) {
+        return -1;
+    }
+    return accurate[side] * 100 / moves[side];
+}
+
+GameAnalyzer::GameAnalyzer(QObject* parent) : QObject(parent),
+depth(DefaultSearchDepth), runDone(0), runTotal(0), unsaved(false), analyzedCount(0) {
+    // Leave a core for the GUI thread
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+GameAnalyzer::~GameAnalyzer() {
+    if (stopFlag) {
+        stopFlag->store(true);
+    }
+    pool.clear();
+    pool.waitForDone();
+    if (unsaved) {
+        saveCache();
+    }
+}
+
+void GameAnalyzer::setSearchDepth(int plies) {
+    // Summaries searched to another depth would not compare
+    int newDepth = qMax(1, plies);
+    if (newDepth != depth) {
+        depth = newDepth;
+        results.clear();
+        unsaved = true;
+    }
+}
+
+int GameAnalyzer::searchDepth() const {
+    return depth;
+}
+
+void GameAnalyzer::setCacheFile(const QString& path) {
+    cachePath = path;
+    loadCache();
+}
+
+void GameAnalyzer::setThreadCount(int count) {
+    pool.setMaxThreadCount(qMax(1, count));
+}
+
+QString GameAnalyzer::gameKey(const QJsonObject& record) {
+    // Only what decides the analysis, so replays of the same moves share it
+    QJsonObject identity;
+    identity["variant"] = record["variant"];
+    identity["boardSize"] = record["boardSize"];
+    identity["winLength"] = record["winLength"];
+    identity["moves"] = record["moves"];
+    QByteArray bytes = QJsonDocument(identity).toJson(QJsonDocument::Compact);
+    return QString(QCryptographicHash::hash(bytes, QCryptographicHash::Sha1).toHex());
+}
+
+GameAnalysis GameAnalyzer::analyzeGame(const QJsonObject& record, int searchDepth, QVector<MoveAnalysis>* details) {
+    std::atomic<bool> never(false);
+    Analyst analyst(qMax(1, searchDepth), &never);
+    GameAnalysis result;
+    analyst.analyze(record, &result, details);
+    return result;
+}
+
+void GameAnalyzer::analyze(const QVector<QJsonObject>& records) {
+    // Games added while a run is going join it
+    if (runTotal == 0) {
+        stopFlag = QSharedPointer<std::atomic<bool>>::create(false);
+    }
+
+    QSharedPointer<std::atomic<bool>> run = stopFlag;
+    int plies = depth;
+    QVector<QPair<QString, QJsonObject>> batch;
+    auto startBatch = [&]() {
+        pool.start([this, run, plies, batch]() {
+            Analyst analyst(plies, run.data());
+            for (const QPair<QString, QJsonObject>& game : batch) {
+                GameAnalysis result;
+                if (run->load(std::memory_order_relaxed) || !analyst.analyze(game.second, &result, nullptr)) {
+                    return;
+                }
+                ++analyzedCount;
+                QString key = game.first;
+                QMetaObject::invokeMethod(this, [this, run, key, result]() { deliver(run, key, result); },
+                                          Qt::QueuedConnection);
+            }
+        });
+        batch.clear();
+    };
+
+    int queued = 0;
+    for (const QJsonObject& record : records) {
+        QString key = gameKey(record);
+        if (results.contains(key) || pending.contains(key)) {
+            continue;
+        }
+        pending.insert(key);
+        batch.append(qMakePair(key, record));
+        ++queued;
+        if (batch.size() == BatchSize) {
+            startBatch();
+        }
+    }
+    if (!batch.isEmpty()) {
+        startBatch();
+    }
+
+    runTotal += queued;
+    if (runTotal == 0) {
+        emit finished(false); // Everything was already analyzed
+        return;
+    }
+    emit progress(runDone, runTotal);
+}
+
+void GameAnalyzer::cancel() {
+    if (runTotal == 0) {
+        return;
+    }
+    stopFlag->store(true);
+    pool.clear();
+    pending.clear();
+    finishRun(true);
+}
+
+void GameAnalyzer::waitForFinished() {
+    // Results are handed over through this thread's event queue
+    pool.waitForDone();
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+}
+
+bool GameAnalyzer::isRunning() const {
+    return runTotal > 0;
+}
+
+bool GameAnalyzer::contains(const QString& key) const {
+    return results.contains(key);
+}
+
+GameAnalysis GameAnalyzer::analysis(const QString& key) const {
+    return results.value(key);
+}
+
+int GameAnalyzer::cachedGames() const {
+    return results.size();
+}
+
+qint64 GameAnalyzer::analyzedGames() const {
+    return analyzedCount.load();
+}
+
+void GameAnalyzer::deliver(const QSharedPointer<std::atomic<bool>>& run, const QString& key, const GameAnalysis& result) {
+    // A finished game is worth keeping even if its run was cancelled since
+    results.insert(key, result);
+    unsaved = true;
+    if (run.data() != stopFlag.data() || run->load()) {
+        return;
+    }
+    pending.remove(key);
+    ++runDone;
+    emit progress(runDone, runTotal);
+    if (runDone == runTotal) {
+        finishRun(false);
+    }
+}
+
+void GameAnalyzer::finishRun(bool cancelled) {
+    runDone = 0;
+    runTotal = 0;
+    saveCache();
+    emit finished(cancelled);
+}
+
+void GameAnalyzer::loadCache() {
+    QFile file(cachePath);
+    if (cachePath.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root["version"].toInt() != AnalysisVersion || root["depth"].toInt() != depth) {
+        return;
+    }
+    const QJsonObject games = root["games"].toObject();
+    for (auto it = games.constBegin(); it != games.constEnd(); ++it) {
+        results.insert(it.key(), fromJson(it.value().toArray()));
+    }
+}
+
+bool GameAnalyzer::saveCache() {
+    if (cachePath.isEmpty() || !unsaved) {
+        return true;
+    }
+    QJsonObject games;
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        games[it.key()] = toJson(it.value());
+    }
+    QJsonObject root;
+    root["version"] = AnalysisVersion;
+    root["depth"] = depth;
+    root["games"] = games;
+
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        return false;
+    }
+    unsaved = false;
+    return true;
+}
@@ -0,0 +1,104 @@
+// gameimporter.cpp - Parallel bulk validation and import of game records
+#include "gameimporter.h"
+#include "userauth.h"
+#include <QtConcurrent>
+
+namespace {
+const int ChunkSize = 2048; // Records validated per task
+}
+
+GameImporter::GameImporter(QObject* parent) : QObject(parent),
+batchSize(5000), repairResults(false) {
+}
+
+void GameImporter::setBatchSize(int size) {
+    batchSize = qMax(1, size);
+}
+
+void GameImporter::setRepairResults(bool repair) {
+    repairResults = repair;
+}
+
+ImportReport GameImporter::validate(const QJsonArray& records, QVector<QJsonObject>* accepted) const {
+    ImportReport report;
+    report.total = records.size();
+
+    // Each task checks one contiguous chunk and writes only its own slots
+    QVector<RecordCheck> checks(report.total);
+    RecordCheck* out = checks.data();
+    QVector<int> chunkStarts;
+    for (int start = 0; start < report.total; start += ChunkSize) {
+        chunkStarts.append(start);
+    }
+
+    int total = report.total;
+    QtConcurrent::blockingMap(chunkStarts, [&records, out, total](const int& start) {
+        int end = qMin(start + ChunkSize, total);
+        for (int i = start; i < end; ++i) {
+            QJsonValue value = records.at(i);
+            if (!value.isObject()) {
+                out[i].error = "Record is not an object";
+                continue;
+            }
+            out[i] = GameRecordValidator::check(value.toObject());
+        }
+    });
+
+    // Collect results in input order
+    if (accepted) {
+        accepted->clear();
+        accepted->reserve(report.total);
+    }
+    for (int i = 0; i < report.total; ++i) {
+        const RecordCheck& check = checks[i];
+        bool repairable = check.resultMismatch && repairResults;
+        if (!check.valid && !repairable) {
+            report.rejected++;
+            report.issues.append(ImportIssue{ i, check.error });
+            continue;
+        }
+
+        report.accepted++;
+        if (repairable) {
+            report.repaired++;
+        }
+        if (accepted) {
+            QJsonObject record = records.at(i).toObject();
+            record["result"] = check.derivedResult;
+            accepted->append(record);
+        }
+    }
+
+    return report;
+}
+
+ImportReport GameImporter::importToHistory(const QJsonArray& records, UserAuth* auth) {
+    if (!auth || !auth->isLoggedIn()) {
+        ImportReport report;
+        report.total = records.size();
+        report.rejected = report.total;
+        report.issues.append(ImportIssue{ -1, "No user is signed in" });
+        return report;
+    }
+
+    QVector<QJsonObject> accepted;
+    ImportReport report = validate(records, &accepted);
+
+    // Commit in batches so a failure only loses the batch in flight
+    for (int start = 0; start < accepted.size(); start += batchSize) {
+        int end = qMin(start + batchSize, static_cast<int>(accepted.size()));
+        QJsonArray batch;
+        for (int i = start; i < end; ++i) {
+            batch.append(accepted[i]);
+        }
+
+        if (!auth->saveGamesToHistory(batch)) {
+            report.issues.append(ImportIssue{ -1, "Could not write the history file" });
+            break;
+        }
+        report.committed += end - start;
+        emit progress(report.committed, accepted.size());
+    }
+
+    return report;
+}
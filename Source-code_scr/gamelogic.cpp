@@ -1,11 +1,29 @@
 // gamelogic.cpp - Game Logic Implementation
 #include "gamelogic.h"
+#include "gamerecord.h"
+#include "tracing.h"
+#include "metrics.h"
 #include <QRandomGenerator>
+#include <QThread>
+#include <QElapsedTimer>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QtConcurrent>
+
+namespace {
+// Ultimate cells come back board by board, the grid is row by row
+int ultimateToGrid(int cell) {
+    return UltimateBoard::rowOf(cell) * 9 + UltimateBoard::colOf(cell);
+}
+}
 
 GameLogic::GameLogic(QObject* parent) : QObject(parent),
-gameOver(false), vsAI(false), replayIndex(0), aiDifficulty(AIDifficulty::Medium) {
+boardSize(3), winLength(3), pendingBoardSize(3), pendingWinLength(3),
+variant(GameVariant::Classic), pendingVariant(GameVariant::Classic),
+gameOver(false), vsAI(false), replayIndex(0), aiDifficulty(AIDifficulty::Medium), aiTimeBudgetMs(200),
+aiBackend(AIBackend::AlphaBeta), ponderingEnabled(false), ponderingPaused(false),
+hintStop(false), hintRequest(0), changeQueued(false), resetPending(false), notifiedPlayer(Player::X), notifiedWinner(Player::None),
+notifiedGameOver(false), notifiedForcedBoard(UltimateBoard::AnyBoard) {
     // Initialize the board
     board.resize(3);
     for (int i = 0; i < 3; ++i) {
@@ -13,14 +31,46 @@ gameOver(false), vsAI(false), replayIndex(0), aiDifficulty(AIDifficulty::Medium)
     }
     // Set starting player to X
     currentPlayer = Player::X;
+
+    searchEngine.setTablebase(&tablebase);
+    ponderer.setTablebase(&tablebase);
+    hintEngine.setTablebase(&tablebase);
+    hintEngine.setStopFlag(&hintStop);
+}
+
+GameLogic::~GameLogic() {
+    stopHints();
+}
+void GameLogic::newGame(bool vsAI, GameVariant variant) {
+    setVariant(variant);
+    newGame(vsAI);
 }
+
 void GameLogic::newGame(bool vsAI) {
-    // Clear the board
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 3; ++j) {
-            board[i][j] = Player::None;
-        }
+    // Nothing pondered for the old game is any use now
+    ponderer.stop();
+    ponderer.clear();
+    stopHints();
+    hintCache.clear();
+    ++hintRequest; // Answers still queued are for the old game
+
+    // Apply a pending variant or board size and clear the board
+    variant = pendingVariant;
+    if (variant == GameVariant::Ultimate) {
+        boardSize = 9;
+        winLength = 3;
+        ultimate = UltimateBoard();
+    } else {
+        boardSize = pendingBoardSize;
+        winLength = pendingWinLength;
+        position = BoardState(boardSize, winLength);
+    }
+    board.resize(boardSize);
+    for (int i = 0; i < boardSize; ++i) {
+        board[i].fill(Player::None, boardSize);
     }
+    mctsEngine.reset();
+    openTablebase();
 
     // Reset game state
     currentPlayer = Player::X;
@@ -28,49 +78,146 @@ void GameLogic::newGame(bool vsAI) {
     gameOver = false;
     this->vsAI = vsAI;
     moves.clear();
+    undone.clear();
     replayIndex = 0;
     startTime = QDateTime::currentDateTime();
 
-    emit boardChanged();
+    resetPending = true;
+    queueBoardChange();
+    startPondering();
 }
 
 bool GameLogic::makeMove(int row, int col) {
-    // Check if move is valid
-    if (row < 0 || row >= 3 || col < 0 || col >= 3 || board[row][col] != Player::None || gameOver) {
+    TRACE_SCOPE("GameLogic::makeMove");
+    if (!applyMove(row, col)) {
         return false;
     }
 
-    // Make the move
-    board[row][col] = currentPlayer;
+    // A new move ends the line that could have been redone
+    undone.clear();
 
-    // Record the move
+    // If playing against AI and it's AI's turn
+    if (vsAI && currentPlayer == Player::O && !gameOver) {
+        aiMove();
+    }
+    return true;
+}
+
+bool GameLogic::applyMove(int row, int col) {
+    // Check if move is valid; nothing is played onto an earlier step of a replay
+    if (row < 0 || row >= boardSize || col < 0 || col >= boardSize || board[row][col] != Player::None || gameOver ||
+        replayIndex != moves.size()) {
+        return false;
+    }
+    if (variant == GameVariant::Ultimate && !ultimate.isLegal(UltimateBoard::cellAt(row, col))) {
+        return false; // Outside the board the last move sent us to
+    }
+
+    // Record the move and make it
     Move move;
     move.row = row;
     move.col = col;
     move.player = currentPlayer;
     moves.append(move);
+    stepForward();
 
-    // Check if game is over
-    if (checkWin(row, col)) {
-        winner = currentPlayer;
-        gameOver = true;
-        emit gameEnded(winner);
+    if (gameOver) {
+        ponderer.stop();
+        AppMetrics::gamesFinished[(winner == Player::X) ? 0 : (winner == Player::O) ? 1 : 2].add();
+        emit gameEnded(winner); // None for a tie
     }
-    else if (checkGameOver()) {
-        gameOver = true;
-        emit gameEnded(Player::None); // Tie
+
+    queueBoardChange();
+    return true;
+}
+
+void GameLogic::unmakeMove() {
+    stepBack();
+    undone.append(moves.takeLast());
+}
+
+void GameLogic::stepForward() {
+    const Move& move = moves[replayIndex++];
+    board[move.row][move.col] = move.player;
+
+    // Check if game is over
+    bool won;
+    bool finished;
+    if (variant == GameVariant::Ultimate) {
+        ultimate.play(UltimateBoard::cellAt(move.row, move.col));
+        won = ultimate.winner() != Player::None;
+        finished = ultimate.isOver();
+    } else {
+        position.play(move.row * boardSize + move.col);
+        won = checkWin(move.row, move.col);
+        finished = won || checkGameOver();
     }
-    else {
-        // Switch player
+
+    currentPlayer = move.player;
+    winner = won ? move.player : Player::None;
+    gameOver = finished;
+    if (!finished) {
         switchPlayer();
+    }
+}
 
-        // If playing against AI and it's AI's turn
-        if (vsAI && currentPlayer == Player::O && !gameOver) {
-            aiMove();
-        }
+void GameLogic::stepBack() {
+    // Every position before the last move was still being played
+    const Move& move = moves[--replayIndex];
+    board[move.row][move.col] = Player::None;
+    if (variant == GameVariant::Ultimate) {
+        ultimate.undo();
+    } else {
+        position.undo(move.row * boardSize + move.col);
     }
+    currentPlayer = move.player;
+    winner = Player::None;
+    gameOver = false;
+}
+
+bool GameLogic::canUndo() const {
+    // Not while the board shows an earlier step of a replay. A finished game
+    // has been reported through gameEnded(), so it is saved and rated once.
+    return !moves.isEmpty() && replayIndex == moves.size() && !gameOver;
+}
+
+bool GameLogic::canRedo() const {
+    return !undone.isEmpty() && replayIndex == moves.size() && !gameOver;
+}
+
+bool GameLogic::undo() {
+    if (!canUndo()) {
+        return false;
+    }
+
+    // Whatever was being pondered answers a position that is gone
+    ponderer.stop();
+    ponderer.clear();
 
-    emit boardChanged();
+    // Back to the human's turn when playing the AI
+    do {
+        unmakeMove();
+    } while (vsAI && currentPlayer == Player::O && !moves.isEmpty());
+
+    queueBoardChange();
+    startPondering();
+    return true;
+}
+
+bool GameLogic::redo() {
+    if (!canRedo()) {
+        return false;
+    }
+    ponderer.stop();
+    ponderer.clear();
+
+    // The AI's recorded reply is replayed rather than searched again
+    do {
+        Move move = undone.takeLast();
+        applyMove(move.row, move.col);
+    } while (vsAI && currentPlayer == Player::O && !gameOver && !undone.isEmpty());
+
+    startPondering();
     return true;
 }
 void GameLogic::setDifficulty(AIDifficulty difficulty) {
@@ -81,6 +228,62 @@ AIDifficulty GameLogic::getDifficulty() const {
     return aiDifficulty;
 }
 
+void GameLogic::setAITimeBudget(int ms) {
+    aiTimeBudgetMs = qMax(1, ms);
+}
+
+int GameLogic::getAITimeBudget() const {
+    return aiTimeBudgetMs;
+}
+
+SearchResult GameLogic::getLastSearch() const {
+    return lastSearch;
+}
+
+MctsResult GameLogic::getLastMctsSearch() const {
+    return lastMctsSearch;
+}
+
+void GameLogic::setAIBackend(AIBackend backend) {
+    aiBackend = backend;
+}
+
+AIBackend GameLogic::getAIBackend() const {
+    return aiBackend;
+}
+
+void GameLogic::setBoardSize(int size, int length) {
+    pendingBoardSize = qBound(3, size, int(BoardState::MaxSize));
+    pendingWinLength = qBound(3, length, pendingBoardSize);
+}
+
+int GameLogic::getBoardSize() const {
+    return boardSize;
+}
+
+int GameLogic::getWinLength() const {
+    return winLength;
+}
+
+void GameLogic::setVariant(GameVariant variant) {
+    pendingVariant = variant;
+}
+
+GameVariant GameLogic::getVariant() const {
+    return variant;
+}
+
+int GameLogic::getForcedBoard() const {
+    return (variant == GameVariant::Ultimate) ? ultimate.forcedBoard() : UltimateBoard::AnyBoard;
+}
+
+Player GameLogic::getSubBoardWinner(int board) const {
+    if (variant != GameVariant::Ultimate || board < 0 || board >= 9) {
+        return Player::None;
+    }
+    return ultimate.boardWinner(board);
+}
+
 bool GameLogic::shouldUseOptimalMove() {
     int probability;
     switch (aiDifficulty) {
@@ -104,170 +307,344 @@ bool GameLogic::shouldUseOptimalMove() {
     int randomNum = QRandomGenerator::global()->bounded(100);
     return randomNum < probability;
 }
+QVector<RootScore> GameLogic::getMoveHints(int timeBudgetMs) {
+    if (gameOver) {
+        return QVector<RootScore>();
+    }
+
+    // One search scores every empty cell; the engines keep their tables, so
+    // the AI's next search starts from what the hints already explored
+    SearchLimits limits;
+    limits.timeBudgetMs = timeBudgetMs;
+    limits.scoreAllMoves = true;
+    if (variant == GameVariant::Ultimate) {
+        QVector<RootScore> hints = ultimateSearch().search(ultimate, limits).rootScores;
+        for (RootScore& hint : hints) {
+            hint.cell = ultimateToGrid(hint.cell);
+        }
+        return hints;
+    }
+    return searchEngine.search(toBoardState(), limits).rootScores;
+}
+
+void GameLogic::requestMoveHints(int timeBudgetMs) {
+    // Only the latest request is answered, so a search for a position
+    // already left is stopped rather than waited for
+    stopHints();
+    int request = ++hintRequest;
+    if (gameOver) {
+        return;
+    }
+    bool ultimateGame = (variant == GameVariant::Ultimate);
+    quint64 key = ultimateGame ? ultimate.hash() : position.hash();
+    auto cached = hintCache.constFind(key);
+    if (cached != hintCache.constEnd()) {
+        emit moveHintsReady(cached.value());
+        return;
+    }
+
+    if (ultimateGame && !hintUltimateEngine) {
+        hintUltimateEngine.reset(new UltimateEngine());
+        hintUltimateEngine->setStopFlag(&hintStop);
+    }
+    SearchLimits limits;
+    limits.timeBudgetMs = timeBudgetMs;
+    limits.scoreAllMoves = true;
+    UltimateBoard ultimateRoot = ultimate;
+    BoardState classicRoot = position;
+    hintWorker = QtConcurrent::run([this, request, key, limits, ultimateGame, ultimateRoot, classicRoot]() {
+        QVector<RootScore> hints;
+        if (ultimateGame) {
+            hints = hintUltimateEngine->search(ultimateRoot, limits).rootScores;
+            for (RootScore& hint : hints) {
+                hint.cell = ultimateToGrid(hint.cell);
+            }
+        } else {
+            hints = hintEngine.search(classicRoot, limits).rootScores;
+        }
+        if (hintStop.load(std::memory_order_relaxed)) {
+            return; // Cut short, so not every cell was scored
+        }
+        QMetaObject::invokeMethod(this, [this, request, key, hints]() {
+            if (request != hintRequest) {
+                return;
+            }
+            // Kept even if a move was made meanwhile, undo may come back to it
+            hintCache.insert(key, hints);
+            quint64 current = (variant == GameVariant::Ultimate) ? ultimate.hash() : position.hash();
+            if (key == current && !gameOver) {
+                emit moveHintsReady(hints);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void GameLogic::stopHints() {
+    hintStop.store(true);
+    hintWorker.waitForFinished();
+    hintStop.store(false);
+}
+
 void GameLogic::aiMove() {
-    // AI uses minimax to make a move
+    // AI searches for its move
     makeAIMove();
 }
 
+MctsLimits GameLogic::mctsLimits() const {
+    // Difficulty is a playout budget, always capped by the time budget
+    MctsLimits limits;
+    limits.timeBudgetMs = aiTimeBudgetMs;
+    switch (aiDifficulty) {
+    case AIDifficulty::Easy:
+        limits.iterations = 200;
+        break;
+    case AIDifficulty::Medium:
+        limits.iterations = 2000;
+        break;
+    case AIDifficulty::Hard:
+        limits.iterations = 20000;
+        limits.threads = qBound(1, QThread::idealThreadCount(), 4);
+        break;
+    case AIDifficulty::Unbeatable:
+        limits.iterations = 0; // The time budget alone
+        limits.threads = qBound(1, QThread::idealThreadCount(), 4);
+        break;
+    }
+    return limits;
+}
+
+UltimateEngine& GameLogic::ultimateSearch() {
+    if (!ultimateEngine) {
+        ultimateEngine.reset(new UltimateEngine());
+    }
+    return *ultimateEngine;
+}
+
 void GameLogic::makeAIMove() {
-    if (shouldUseOptimalMove()) {
-        // Use minimax for optimal move
-        int bestScore = -1000;
-        int bestRow = -1;
-        int bestCol = -1;
-
-        for (int i = 0; i < 3; ++i) {
-            for (int j = 0; j < 3; ++j) {
-                if (board[i][j] == Player::None) {
-                    // Try this move
-                    board[i][j] = Player::O;
-                    // Get score from minimax
-                    int score = minimax(board, 0, false, -1000, 1000);
-                    // Undo the move
-                    board[i][j] = Player::None;
-                    // Update best move if needed
-                    if (score > bestScore) {
-                        bestScore = score;
-                        bestRow = i;
-                        bestCol = j;
-                    }
-                }
-            }
+    TRACE_SCOPE("GameLogic::makeAIMove");
+    QElapsedTimer wallTimer;
+    wallTimer.start();
+
+    AIDecisionStats stats;
+    stats.timestamp = QDateTime::currentDateTime();
+    stats.moveNumber = moves.size();
+    stats.difficulty = aiDifficulty;
+    stats.boardSize = boardSize;
+
+    bool ultimateGame = (variant == GameVariant::Ultimate);
+    BoardState state = ultimateGame ? BoardState() : toBoardState();
+
+    // Stop pondering whatever happens, and keep its answer if it searched this reply
+    SearchResult ponderedSearch;
+    bool pondered = !ultimateGame && ponderer.take(state, &ponderedSearch);
+
+    bool optimal = (aiBackend == AIBackend::MonteCarlo && !ultimateGame) || shouldUseOptimalMove();
+    if (optimal && ultimateGame) {
+        SearchLimits limits;
+        limits.timeBudgetMs = aiTimeBudgetMs;
+        lastSearch = ultimateSearch().search(ultimate, limits);
+        stats.backend = "ultimate";
+        stats.cell = (lastSearch.cell >= 0) ? ultimateToGrid(lastSearch.cell) : -1;
+        stats.nodes = lastSearch.stats.nodes;
+        stats.depth = lastSearch.depthCompleted;
+        stats.cacheHits = lastSearch.stats.ttHits;
+        stats.timedOut = lastSearch.timedOut;
+        stats.searchMs = lastSearch.elapsedMs;
+        for (int cell : lastSearch.principalVariation) {
+            stats.principalVariation.append(ultimateToGrid(cell));
         }
-
-        // Make the best move
-        if (bestRow != -1 && bestCol != -1) {
-            makeMove(bestRow, bestCol);
+        for (const RootScore& rootScore : lastSearch.rootScores) {
+            AICandidate candidate;
+            candidate.cell = ultimateToGrid(rootScore.cell);
+            candidate.score = rootScore.score;
+            candidate.upperBound = rootScore.upperBound;
+            stats.candidates.append(candidate);
+        }
+    }
+    else if (optimal && tablebase.covers(state) && tablebase.probe(state).isValid()) {
+        // Solved endgames skip the search entirely
+        QElapsedTimer probeTimer;
+        probeTimer.start();
+        TablebaseEntry value;
+        stats.backend = "tablebase";
+        stats.cell = tablebase.bestMove(state, &value);
+        stats.depth = value.distance; // Plies to the end of the game
+        stats.cacheHits = 1;
+        stats.principalVariation.append(stats.cell);
+        stats.searchMs = probeTimer.elapsed();
+    }
+    else if (aiBackend == AIBackend::MonteCarlo && !ultimateGame) {
+        lastMctsSearch = mctsEngine.search(state, mctsLimits());
+        stats.backend = "mcts";
+        stats.cell = lastMctsSearch.cell;
+        stats.nodes = lastMctsSearch.iterations;
+        stats.cacheHits = lastMctsSearch.reusedTrees;
+        stats.searchMs = lastMctsSearch.elapsedMs;
+        if (lastMctsSearch.cell >= 0) {
+            stats.principalVariation.append(lastMctsSearch.cell);
+        }
+        for (const MctsMove& move : lastMctsSearch.moves) {
+            AICandidate candidate;
+            candidate.cell = move.cell;
+            candidate.score = move.winRate;
+            candidate.visits = move.visits;
+            stats.candidates.append(candidate);
+        }
+    }
+    else if (optimal) {
+        // Search within the time budget, the best move so far is always playable
+        SearchLimits limits;
+        limits.timeBudgetMs = aiTimeBudgetMs;
+        lastSearch = pondered ? ponderedSearch : searchEngine.search(state, limits);
+        stats.backend = "alphabeta";
+        stats.pondered = pondered;
+        stats.cell = lastSearch.cell;
+        stats.nodes = lastSearch.stats.nodes;
+        stats.depth = lastSearch.depthCompleted;
+        stats.cacheHits = lastSearch.stats.ttHits;
+        stats.timedOut = lastSearch.timedOut;
+        // A pondered move cost this turn only the hand-over, not the search behind it
+        stats.searchMs = pondered ? wallTimer.elapsed() : lastSearch.elapsedMs;
+        stats.ponderMs = pondered ? lastSearch.elapsedMs : 0;
+        stats.principalVariation = lastSearch.principalVariation;
+        for (const RootScore& rootScore : lastSearch.rootScores) {
+            AICandidate candidate;
+            candidate.cell = rootScore.cell;
+            candidate.score = rootScore.score;
+            candidate.upperBound = rootScore.upperBound;
+            stats.candidates.append(candidate);
         }
     }
     else {
-        // Make a random move
+        // Pick a random move
+        stats.backend = "random";
+        stats.randomMove = true;
         QVector<QPair<int, int>> availableMoves = getAvailableMoves(board);
         if (!availableMoves.isEmpty()) {
             int randomIndex = QRandomGenerator::global()->bounded(availableMoves.size());
             QPair<int, int> randomMove = availableMoves[randomIndex];
-            makeMove(randomMove.first, randomMove.second);
+            stats.cell = randomMove.first * boardSize + randomMove.second;
         }
     }
-}
+    stats.wallMs = wallTimer.elapsed();
+    AppMetrics::aiMoveSeconds[static_cast<int>(aiDifficulty)].observeNs(wallTimer.nsecsElapsed());
 
-int GameLogic::minimax(QVector<QVector<Player>>& board, int depth, bool isMaximizing, int alpha, int beta) {
-    // Check for terminal states
-    if (isWin(board, Player::O)) {
-        return 10 - depth; // AI wins
-    }
-    if (isWin(board, Player::X)) {
-        return depth - 10; // Human wins
-    }
-
-    // Check for a tie
-    bool isFull = true;
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 3; ++j) {
-            if (board[i][j] == Player::None) {
-                isFull = false;
-                break;
-            }
-        }
-        if (!isFull) break;
+    if (stats.cell < 0) {
+        return;
     }
+    makeMove(stats.cell / boardSize, stats.cell % boardSize);
 
-    if (isFull) {
-        return 0; // Tie
-    }
+    // Report once the move is on the board
+    lastDecision = stats;
+    decisionLog.append(stats);
+    emit aiDecision(stats);
 
-    // Maximizing player (AI)
-    if (isMaximizing) {
-        int bestScore = -1000;
+    startPondering();
+}
 
-        for (int i = 0; i < 3; ++i) {
-            for (int j = 0; j < 3; ++j) {
-                if (board[i][j] == Player::None) {
-                    // Try this move
-                    board[i][j] = Player::O;
+void GameLogic::startPondering() {
+    // Classic alpha-beta games only, and only on the human's turn
+    if (!ponderingEnabled || ponderingPaused || !vsAI || gameOver || variant != GameVariant::Classic ||
+        aiBackend != AIBackend::AlphaBeta || currentPlayer != Player::X) {
+        return;
+    }
 
-                    // Recurse
-                    int score = minimax(board, depth + 1, false, alpha, beta);
+    // The reply the last search expected goes first
+    int predictedReply = -1;
+    if (lastDecision.backend == "alphabeta" && lastDecision.principalVariation.size() > 1 &&
+        lastDecision.moveNumber == moves.size() - 1) {
+        predictedReply = lastDecision.principalVariation[1];
+    }
 
-                    // Undo the move
-                    board[i][j] = Player::None;
+    SearchLimits limits;
+    limits.timeBudgetMs = aiTimeBudgetMs;
+    ponderer.start(toBoardState(), limits, predictedReply);
+}
 
-                    // Update best score
-                    bestScore = qMax(score, bestScore);
+void GameLogic::setPonderingEnabled(bool enabled) {
+    ponderingEnabled = enabled;
+    if (enabled) {
+        startPondering();
+    } else {
+        ponderer.stop();
+        ponderer.clear();
+    }
+}
 
-                    // Alpha-beta pruning
-                    alpha = qMax(alpha, bestScore);
-                    if (beta <= alpha) {
-                        break;
-                    }
-                }
-            }
-        }
+bool GameLogic::isPonderingEnabled() const {
+    return ponderingEnabled;
+}
 
-        return bestScore;
+void GameLogic::setPonderingPaused(bool paused) {
+    // Replies finished before the pause stay cached and are skipped on resume
+    ponderingPaused = paused;
+    if (paused) {
+        ponderer.stop();
+    } else {
+        startPondering();
     }
-    // Minimizing player (Human)
-    else {
-        int bestScore = 1000;
+}
+
+bool GameLogic::isPonderRunning() const {
+    return ponderer.isRunning();
+}
 
-        for (int i = 0; i < 3; ++i) {
-            for (int j = 0; j < 3; ++j) {
-                if (board[i][j] == Player::None) {
-                    // Try this move
-                    board[i][j] = Player::X;
+AIDecisionStats GameLogic::getLastDecision() const {
+    return lastDecision;
+}
 
-                    // Recurse
-                    int score = minimax(board, depth + 1, true, alpha, beta);
+void GameLogic::setDecisionLogPath(const QString& path) {
+    decisionLog.setPath(path);
+}
 
-                    // Undo the move
-                    board[i][j] = Player::None;
+QString GameLogic::getDecisionLogPath() const {
+    return decisionLog.path();
+}
 
-                    // Update best score
-                    bestScore = qMin(score, bestScore);
+void GameLogic::setTablebaseDirectory(const QString& directory) {
+    tablebaseDirectory = directory;
 
-                    // Alpha-beta pruning
-                    beta = qMin(beta, bestScore);
-                    if (beta <= alpha) {
-                        break;
-                    }
-                }
-            }
-        }
+    // Both workers may be probing the mapping about to go
+    ponderer.stop();
+    ponderer.clear();
+    stopHints();
+    tablebase.close();
+    openTablebase();
+    startPondering();
+}
 
-        return bestScore;
-    }
+QString GameLogic::getTablebaseDirectory() const {
+    return tablebaseDirectory;
 }
-bool GameLogic::isWin(const QVector<QVector<Player>>& board, Player player) const {
-    // Check rows
-    for (int i = 0; i < 3; ++i) {
-        if (board[i][0] == player && board[i][1] == player && board[i][2] == player) {
-            return true;
-        }
-    }
 
-    // Check columns
-    for (int i = 0; i < 3; ++i) {
-        if (board[0][i] == player && board[1][i] == player && board[2][i] == player) {
-            return true;
-        }
-    }
+bool GameLogic::hasTablebase() const {
+    return tablebase.isOpen();
+}
 
-    // Check diagonals
-    if (board[0][0] == player && board[1][1] == player && board[2][2] == player) {
-        return true;
+void GameLogic::openTablebase() {
+    // Keep the mapping while the board shape stays the same
+    if (tablebase.isOpen() && tablebase.size() == boardSize && tablebase.winLength() == winLength) {
+        return;
     }
-    if (board[0][2] == player && board[1][1] == player && board[2][0] == player) {
-        return true;
+    tablebase.close();
+    if (!tablebaseDirectory.isEmpty()) {
+        tablebase.open(tablebaseDirectory + "/" + Tablebase::fileName(boardSize, winLength));
     }
+}
 
-    return false;
+BoardState GameLogic::toBoardState() const {
+    // Played and undone move by move, so the side to move and the hash are current
+    return position;
 }
 
 QVector<QPair<int, int>> GameLogic::getAvailableMoves(const QVector<QVector<Player>>& board) const {
     QVector<QPair<int, int>> moves;
 
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 3; ++j) {
+    for (int i = 0; i < boardSize; ++i) {
+        for (int j = 0; j < boardSize; ++j) {
+            if (variant == GameVariant::Ultimate && !ultimate.isLegal(UltimateBoard::cellAt(i, j))) {
+                continue;
+            }
             if (board[i][j] == Player::None) {
                 moves.append(qMakePair(i, j));
             }
@@ -278,7 +655,7 @@ QVector<QPair<int, int>> GameLogic::getAvailableMoves(const QVector<QVector<Play
 }
 
 Player GameLogic::getCell(int row, int col) const {
-    if (row >= 0 && row < 3 && col >= 0 && col < 3) {
+    if (row >= 0 && row < boardSize && col >= 0 && col < boardSize) {
         return board[row][col];
     }
     return Player::None;
@@ -307,25 +684,20 @@ void GameLogic::switchPlayer() {
 bool GameLogic::checkWin(int row, int col) {
     Player p = board[row][col];
 
-    // Check row
-    if (board[row][0] == p && board[row][1] == p && board[row][2] == p) {
-        return true;
-    }
-
-    // Check column
-    if (board[0][col] == p && board[1][col] == p && board[2][col] == p) {
-        return true;
-    }
-
-    // Check diagonals
-    if (row == col) {
-        if (board[0][0] == p && board[1][1] == p && board[2][2] == p) {
-            return true;
+    // Count matching cells both ways along the row, column and diagonals
+    const int directions[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+    for (const auto& d : directions) {
+        int count = 1;
+        for (int sign = -1; sign <= 1; sign += 2) {
+            int r = row + sign * d[0];
+            int c = col + sign * d[1];
+            while (r >= 0 && r < boardSize && c >= 0 && c < boardSize && board[r][c] == p) {
+                ++count;
+                r += sign * d[0];
+                c += sign * d[1];
+            }
         }
-    }
-
-    if (row + col == 2) {
-        if (board[0][2] == p && board[1][1] == p && board[2][0] == p) {
+        if (count >= winLength) {
             return true;
         }
     }
@@ -335,8 +707,8 @@ bool GameLogic::checkWin(int row, int col) {
 
 bool GameLogic::checkGameOver() {
     // Check if board is full
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 3; ++j) {
+    for (int i = 0; i < boardSize; ++i) {
+        for (int j = 0; j < boardSize; ++j) {
             if (board[i][j] == Player::None) {
                 return false;
             }
@@ -352,6 +724,9 @@ QJsonObject GameLogic::getGameAsJson() const {
     // Game metadata
     gameData["date"] = startTime.toString(Qt::ISODate);
     gameData["vsAI"] = vsAI;
+    gameData["variant"] = GameRecordValidator::variantString(variant);
+    gameData["boardSize"] = boardSize;
+    gameData["winLength"] = winLength;
 
     // Add difficulty level
     if (vsAI) {
@@ -394,45 +769,68 @@ QJsonObject GameLogic::getGameAsJson() const {
 
 
 void GameLogic::replayMove(int index) {
+    TRACE_SCOPE("GameLogic::replayMove");
     if (index < 0 || index > moves.size()) {
         return;
     }
 
-    // Reset the board
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 3; ++j) {
-            board[i][j] = Player::None;
-        }
+    // Moves are taken back or played again one at a time, so the board, the
+    // engines' positions and the result always describe the step shown
+    while (replayIndex > index) {
+        stepBack();
     }
-
-    // Play up to the specified move
-    for (int i = 0; i < index; ++i) {
-        const Move& move = moves[i];
-        board[move.row][move.col] = move.player;
+    while (replayIndex < index) {
+        stepForward();
     }
+    queueBoardChange();
+}
 
-    replayIndex = index;
-
-    // Set current player based on replay state
-    if (index % 2 == 0) {
-        currentPlayer = Player::X;
-    } else {
-        currentPlayer = Player::O;
+void GameLogic::queueBoardChange() {
+    // The AI's reply, a replay step or a whole loaded game all end up in one signal
+    if (changeQueued) {
+        return;
     }
+    changeQueued = true;
+    QMetaObject::invokeMethod(this, [this]() { emitBoardChange(); }, Qt::QueuedConnection);
+}
 
-    // Set game over status
-    if (index == moves.size()) {
-        gameOver = isGameOver();
-    } else {
-        gameOver = false;
-        winner = Player::None;
+void GameLogic::emitBoardChange() {
+    changeQueued = false;
+
+    BoardChange change;
+    int cellCount = boardSize * boardSize;
+    change.reset = resetPending || notifiedCells.size() != cellCount;
+    if (change.reset) {
+        notifiedCells.fill(Player::None, cellCount);
+    }
+    for (int cell = 0; cell < cellCount; ++cell) {
+        Player owner = board[cell / boardSize][cell % boardSize];
+        if (notifiedCells[cell] != owner) {
+            notifiedCells[cell] = owner;
+            if (!change.reset) {
+                change.cells.append(cell);
+            }
+        }
     }
 
-    emit boardChanged();
+    int forcedBoard = getForcedBoard();
+    change.playerChanged = change.reset || currentPlayer != notifiedPlayer;
+    change.resultChanged = change.reset || winner != notifiedWinner || gameOver != notifiedGameOver;
+    change.forcedBoardChanged = change.reset || forcedBoard != notifiedForcedBoard;
+    resetPending = false;
+    notifiedPlayer = currentPlayer;
+    notifiedWinner = winner;
+    notifiedGameOver = gameOver;
+    notifiedForcedBoard = forcedBoard;
+
+    // A move and its undo in the same turn leave nothing to draw
+    if (change.reset || !change.cells.isEmpty() || change.playerChanged || change.resultChanged ||
+        change.forcedBoardChanged) {
+        emit boardChanged(change);
+    }
 }
 
 void GameLogic::resetReplay() {
-    replayIndex = 0;
     replayMove(0);
 }
 
@@ -440,22 +838,31 @@ QVector<Move> GameLogic::getMoves() const {
     return moves;
 }
 
-void GameLogic::loadFromJson(const QJsonObject& gameData) {
-    // Clear the board and reset game state
-    newGame(gameData["vsAI"].toBool());
+bool GameLogic::loadFromJson(const QJsonObject& gameData) {
+    // Refuse records whose moves could not have been played; a stale
+    // "result" string is harmless because the outcome is re-derived below
+    RecordCheck check = GameRecordValidator::check(gameData);
+    if (!check.valid && !check.resultMismatch) {
+        return false;
+    }
+
+    // Clear the board and reset game state, older records are all classic 3x3.
+    // The variant and size chosen for the next real game are left as they were.
+    int nextSize = pendingBoardSize;
+    int nextWinLength = pendingWinLength;
+    GameVariant nextVariant = pendingVariant;
+    GameVariant recordVariant = GameVariant::Classic;
+    GameRecordValidator::parseVariant(gameData["variant"].toString("classic"), &recordVariant);
+    setBoardSize(gameData["boardSize"].toInt(3), gameData["winLength"].toInt(3));
+    newGame(gameData["vsAI"].toBool(), recordVariant);
+    ponderer.stop(); // Loaded games are replayed, not played on
+    pendingBoardSize = nextSize;
+    pendingWinLength = nextWinLength;
+    pendingVariant = nextVariant;
 
     // Set difficulty if available
     if (gameData.contains("difficulty")) {
-        QString difficultyStr = gameData["difficulty"].toString();
-        if (difficultyStr == "Easy") {
-            aiDifficulty = AIDifficulty::Easy;
-        } else if (difficultyStr == "Medium") {
-            aiDifficulty = AIDifficulty::Medium;
-        } else if (difficultyStr == "Hard") {
-            aiDifficulty = AIDifficulty::Hard;
-        } else if (difficultyStr == "Unbeatable") {
-            aiDifficulty = AIDifficulty::Unbeatable;
-        }
+        GameRecordValidator::parseDifficulty(gameData["difficulty"].toString(), &aiDifficulty);
     }
 
     // Load moves
@@ -470,7 +877,8 @@ void GameLogic::loadFromJson(const QJsonObject& gameData) {
         moves.append(move);
     }
 
-    // Execute all moves to recreate the final state
+    // Execute all moves to recreate the final state, the result included
     replayMove(moves.size());
+    return true;
 }
 
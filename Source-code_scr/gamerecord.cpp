@@ -0,0 +1,214 @@
+// gamerecord.cpp - Validation of saved game records
+#include "gamerecord.h"
+#include "boardstate.h"
+#include "ultimateboard.h"
+#include <QJsonArray>
+#include <QJsonValue>
+
+namespace {
+
+bool readInteger(const QJsonValue& value, int low, int high, int* out) {
+    if (!value.isDouble()) {
+        return false;
+    }
+    double number = value.toDouble();
+    int integer = static_cast<int>(number);
+    if (integer != number || integer < low || integer > high) {
+        return false;
+    }
+    *out = integer;
+    return true;
+}
+
+// Reads the row, column and player of one move and checks whose turn it is
+bool readMove(const QJsonValue& value, int index, int size, Player toMove, int* row, int* col, RecordCheck* result) {
+    QJsonObject moveObj = value.toObject();
+    if (!readInteger(moveObj["row"], 0, size - 1, row) || !readInteger(moveObj["col"], 0, size - 1, col)) {
+        result->error = QString("Move %1 is off the board").arg(index + 1);
+        return false;
+    }
+
+    QString expected = (toMove == Player::X) ? "X" : "O";
+    if (moveObj["player"].toString() != expected) {
+        result->error = QString("Move %1 should be played by %2").arg(index + 1).arg(expected);
+        return false;
+    }
+    return true;
+}
+
+// Replays the moves, X always opens
+bool replayClassic(const QJsonArray& movesArray, int size, int winLength, RecordCheck* result) {
+    BoardState state(size, winLength);
+
+    for (int i = 0; i < movesArray.size(); ++i) {
+        if (result->finished) {
+            result->error = QString("Move %1 comes after the game ended").arg(i + 1);
+            return false;
+        }
+
+        int row;
+        int col;
+        if (!readMove(movesArray.at(i), i, size, state.toMove(), &row, &col, result)) {
+            return false;
+        }
+
+        int cell = row * size + col;
+        if (state.at(cell) != Player::None) {
+            result->error = QString("Move %1 plays an occupied cell").arg(i + 1);
+            return false;
+        }
+
+        Player mover = state.toMove();
+        state.play(cell);
+        if (state.wins(cell)) {
+            result->winner = mover;
+            result->finished = true;
+        } else if (state.isFull()) {
+            result->finished = true;
+        }
+    }
+    return true;
+}
+
+// Same for ultimate games, where each move must also respect the forced board
+bool replayUltimate(const QJsonArray& movesArray, RecordCheck* result) {
+    UltimateBoard state;
+
+    for (int i = 0; i < movesArray.size(); ++i) {
+        if (state.isOver()) {
+            result->error = QString("Move %1 comes after the game ended").arg(i + 1);
+            return false;
+        }
+
+        int row;
+        int col;
+        if (!readMove(movesArray.at(i), i, 9, state.toMove(), &row, &col, result)) {
+            return false;
+        }
+
+        int cell = UltimateBoard::cellAt(row, col);
+        if (state.at(cell) != Player::None) {
+            result->error = QString("Move %1 plays an occupied cell").arg(i + 1);
+            return false;
+        }
+        if (!state.isLegal(cell)) {
+            result->error = QString("Move %1 is outside the board it was sent to").arg(i + 1);
+            return false;
+        }
+        state.play(cell);
+    }
+
+    result->winner = state.winner();
+    result->finished = state.isOver();
+    return true;
+}
+
+} // namespace
+
+QString GameRecordValidator::resultString(Player winner, bool finished) {
+    if (winner == Player::X) {
+        return "X wins";
+    } else if (winner == Player::O) {
+        return "O wins";
+    } else if (finished) {
+        return "Tie";
+    }
+    return "Incomplete";
+}
+
+QString GameRecordValidator::variantString(GameVariant variant) {
+    return (variant == GameVariant::Ultimate) ? "ultimate" : "classic";
+}
+
+bool GameRecordValidator::parseVariant(const QString& text, GameVariant* variant) {
+    if (text == "classic") {
+        *variant = GameVariant::Classic;
+    } else if (text == "ultimate") {
+        *variant = GameVariant::Ultimate;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool GameRecordValidator::parseDifficulty(const QString& text, AIDifficulty* difficulty) {
+    if (text == "Easy") {
+        *difficulty = AIDifficulty::Easy;
+    } else if (text == "Medium") {
+        *difficulty = AIDifficulty::Medium;
+    } else if (text == "Hard") {
+        *difficulty = AIDifficulty::Hard;
+    } else if (text == "Unbeatable") {
+        *difficulty = AIDifficulty::Unbeatable;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+RecordCheck GameRecordValidator::check(const QJsonObject& record) {
+    RecordCheck result;
+
+    if (record.contains("vsAI") && !record["vsAI"].isBool()) {
+        result.error = "\"vsAI\" is not a boolean";
+        return result;
+    }
+    if (record.contains("difficulty")) {
+        AIDifficulty difficulty;
+        if (!parseDifficulty(record["difficulty"].toString(), &difficulty)) {
+            result.error = "Unknown difficulty";
+            return result;
+        }
+    }
+    if (!record["moves"].isArray()) {
+        result.error = "Missing \"moves\" array";
+        return result;
+    }
+
+    // Records written before variants existed are classic
+    GameVariant variant = GameVariant::Classic;
+    if (record.contains("variant") && !parseVariant(record["variant"].toString(), &variant)) {
+        result.error = "Unknown variant";
+        return result;
+    }
+    QJsonArray movesArray = record["moves"].toArray();
+
+    if (variant == GameVariant::Ultimate) {
+        int size = 9;
+        if (record.contains("boardSize") && !readInteger(record["boardSize"], 9, 9, &size)) {
+            result.error = "Ultimate games are played on a 9x9 grid";
+            return result;
+        }
+        if (!replayUltimate(movesArray, &result)) {
+            return result;
+        }
+    } else {
+        // Records written before larger boards existed are 3x3
+        int size = 3;
+        int winLength = 3;
+        if (record.contains("boardSize") && !readInteger(record["boardSize"], 3, BoardState::MaxSize, &size)) {
+            result.error = "Unsupported board size";
+            return result;
+        }
+        if (record.contains("winLength") && !readInteger(record["winLength"], 3, size, &winLength)) {
+            result.error = "Unsupported win length";
+            return result;
+        }
+        if (!replayClassic(movesArray, size, winLength, &result)) {
+            return result;
+        }
+    }
+
+    result.derivedResult = resultString(result.winner, result.finished);
+
+    // A record without a result is accepted, a wrong one is flagged
+    if (record.contains("result") && record["result"].toString() != result.derivedResult) {
+        result.resultMismatch = true;
+        result.error = QString("Stored result \"%1\" does not match the moves (%2)")
+                           .arg(record["result"].toString(), result.derivedResult);
+        return result;
+    }
+
+    result.valid = true;
+    return result;
+}
@@ -0,0 +1,429 @@
+// gametreeenumerator.cpp - Exhaustive game enumeration that checks the engine against a reference
+#include "gametreeenumerator.h"
+#include "boardstate.h"
+#include "gamelogic.h"
+#include "searchengine.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+typedef QPair<quint64, quint64> PositionKey; // X stones, O stones
+
+// Deliberately naive, sharing no code with BoardState: one Player per cell
+// and lines found by walking from every stone in every direction
+struct ReferenceBoard {
+    int n;
+    int k;
+    int plies;
+    Player cells[BoardState::MaxSize * BoardState::MaxSize];
+
+    ReferenceBoard(int size, int winLength) : n(size), k(winLength), plies(0) {
+        for (int cell = 0; cell < n * n; ++cell) {
+            cells[cell] = Player::None;
+        }
+    }
+
+    Player toMove() const {
+        return (plies % 2 == 0) ? Player::X : Player::O;
+    }
+    bool isFull() const {
+        return plies == n * n;
+    }
+    void play(int cell) {
+        cells[cell] = toMove();
+        ++plies;
+    }
+    void undo(int cell) {
+        cells[cell] = Player::None;
+        --plies;
+    }
+
+    Player winner() const {
+        static const int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+        for (int row = 0; row < n; ++row) {
+            for (int col = 0; col < n; ++col) {
+                Player player = cells[row * n + col];
+                if (player == Player::None) {
+                    continue;
+                }
+                for (const auto& direction : directions) {
+                    int run = 1;
+                    int r = row + direction[0];
+                    int c = col + direction[1];
+                    while (run < k && r >= 0 && r < n && c >= 0 && c < n && cells[r * n + c] == player) {
+                        ++run;
+                        r += direction[0];
+                        c += direction[1];
+                    }
+                    if (run >= k) {
+                        return player;
+                    }
+                }
+            }
+        }
+        return Player::None;
+    }
+
+    PositionKey key() const {
+        PositionKey key(0, 0);
+        for (int cell = 0; cell < n * n; ++cell) {
+            if (cells[cell] == Player::X) {
+                key.first |= quint64(1) << cell;
+            } else if (cells[cell] == Player::O) {
+                key.second |= quint64(1) << cell;
+            }
+        }
+        return key;
+    }
+};
+
+// +1 if the side to move wins with best play, -1 if it loses, 0 for a draw
+int referenceValue(ReferenceBoard& board, QHash<PositionKey, int>& memo) {
+    if (board.winner() != Player::None) {
+        return -1; // The last stone won
+    }
+    if (board.isFull()) {
+        return 0;
+    }
+    PositionKey key = board.key();
+    auto known = memo.constFind(key);
+    if (known != memo.constEnd()) {
+        return known.value();
+    }
+
+    int best = -1;
+    for (int cell = 0; cell < board.n * board.n && best < 1; ++cell) {
+        if (board.cells[cell] != Player::None) {
+            continue;
+        }
+        board.play(cell);
+        best = qMax(best, -referenceValue(board, memo));
+        board.undo(cell);
+    }
+    memo.insert(key, best);
+    return best;
+}
+
+QString describeMoves(const QVector<int>& moves, int size) {
+    QStringList cells;
+    for (int cell : moves) {
+        cells.append(QString("(%1,%2)").arg(cell / size).arg(cell % size));
+    }
+    return cells.isEmpty() ? QString("empty board") : cells.join(' ');
+}
+
+struct Tally {
+    EnumerationReport report;
+    QSet<PositionKey> aiPositions;
+
+    void fail(const QString& what, const QVector<int>& moves, int size) {
+        ++report.mismatches;
+        if (report.issues.size() < GameTreeEnumerator::MaxIssues) {
+            report.issues.append(QString("%1 after %2").arg(what, describeMoves(moves, size)));
+        }
+    }
+
+    void merge(const Tally& other) {
+        report.games += other.report.games;
+        report.xWins += other.report.xWins;
+        report.oWins += other.report.oWins;
+        report.draws += other.report.draws;
+        report.cutOff += other.report.cutOff;
+        report.nodes += other.report.nodes;
+        report.mismatches += other.report.mismatches;
+        for (const QString& issue : other.report.issues) {
+            if (report.issues.size() < GameTreeEnumerator::MaxIssues) {
+                report.issues.append(issue);
+            }
+        }
+        aiPositions.unite(other.aiPositions);
+    }
+};
+
+class SubtreeWalker {
+public:
+    SubtreeWalker(int size, int winLength, int maxDepth, int aiMaxEmpty) : reference(size, winLength),
+    state(size, winLength), depthLimit(maxDepth), aiEmptyLimit(aiMaxEmpty) {
+        logic.setBoardSize(size, winLength);
+    }
+
+    Tally walk(const QVector<int>& prefix) {
+        for (int cell : prefix) {
+            reference.play(cell);
+            state.play(cell);
+        }
+        moves = prefix;
+        visit();
+        return tally;
+    }
+
+private:
+    ReferenceBoard reference;
+    BoardState state;
+    GameLogic logic;
+    int depthLimit;
+    int aiEmptyLimit;
+    QVector<int> moves;
+    Tally tally;
+
+    void visit() {
+        ++tally.report.nodes;
+        int size = reference.n;
+        Player winner = reference.winner();
+
+        // The bitboard, move by move and by full scan
+        if (!moves.isEmpty() && state.wins(moves.last()) != (winner != Player::None)) {
+            tally.fail("BoardState::wins disagrees", moves, size);
+        }
+        if (state.findWinner() != winner) {
+            tally.fail("BoardState::findWinner disagrees", moves, size);
+        }
+        if (state.isFull() != reference.isFull() || state.toMove() != reference.toMove()) {
+            tally.fail("BoardState fill or turn disagrees", moves, size);
+        }
+
+        bool ended = winner != Player::None || reference.isFull();
+        if (ended || (depthLimit > 0 && reference.plies >= depthLimit)) {
+            ++tally.report.games;
+            if (winner == Player::X) {
+                ++tally.report.xWins;
+            } else if (winner == Player::O) {
+                ++tally.report.oWins;
+            } else if (ended) {
+                ++tally.report.draws;
+            } else {
+                ++tally.report.cutOff;
+            }
+            replayThroughGameLogic(ended);
+            return;
+        }
+
+        if (size * size - reference.plies <= aiEmptyLimit) {
+            tally.aiPositions.insert(reference.key());
+        }
+        for (int cell = 0; cell < size * size; ++cell) {
+            if (reference.cells[cell] != Player::None) {
+                continue;
+            }
+            reference.play(cell);
+            state.play(cell);
+            moves.append(cell);
+            visit();
+            moves.removeLast();
+            state.undo(cell);
+            reference.undo(cell);
+        }
+    }
+
+    // Every prefix of the game is checked on the way, so each node is covered
+    void replayThroughGameLogic(bool ended) {
+        int size = reference.n;
+        ReferenceBoard replay(size, reference.k);
+        logic.newGame(false);
+        for (int i = 0; i < moves.size(); ++i) {
+            int cell = moves[i];
+            Player mover = replay.toMove();
+            if (!logic.makeMove(cell / size, cell % size)) {
+                tally.fail("GameLogic::makeMove refused a legal move", moves.mid(0, i + 1), size);
+                return;
+            }
+            replay.play(cell);
+
+            Player winner = replay.winner();
+            bool over = winner != Player::None || replay.isFull();
+            if (logic.getCell(cell / size, cell % size) != mover) {
+                tally.fail("GameLogic placed the wrong stone", moves.mid(0, i + 1), size);
+            }
+            if (logic.isGameOver() != over || logic.getWinner() != winner) {
+                tally.fail("GameLogic winner or game over disagrees", moves.mid(0, i + 1), size);
+            }
+            if (!over && logic.getCurrentPlayer() != replay.toMove()) {
+                tally.fail("GameLogic turn disagrees", moves.mid(0, i + 1), size);
+            }
+            if (i > 0 && logic.makeMove(moves[i - 1] / size, moves[i - 1] % size)) {
+                tally.fail("GameLogic::makeMove took an occupied cell", moves.mid(0, i + 1), size);
+                return;
+            }
+        }
+
+        // A finished game takes no more moves
+        if (ended && !replay.isFull()) {
+            for (int cell = 0; cell < size * size; ++cell) {
+                if (replay.cells[cell] == Player::None) {
+                    if (logic.makeMove(cell / size, cell % size)) {
+                        tally.fail("GameLogic::makeMove played after the game ended", moves, size);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+};
+
+struct AiCheck {
+    qint64 checked = 0;
+    qint64 mismatches = 0;
+    QStringList issues;
+};
+
+AiCheck checkSearch(const QVector<PositionKey>& positions, int size, int winLength) {
+    AiCheck result;
+    SearchEngine engine;
+    QHash<PositionKey, int> memo;
+    for (const PositionKey& key : positions) {
+        // Interleave the stones so BoardState's turn and hash come out right
+        QVector<int> xs;
+        QVector<int> os;
+        for (int cell = 0; cell < size * size; ++cell) {
+            if (key.first & (quint64(1) << cell)) {
+                xs.append(cell);
+            } else if (key.second & (quint64(1) << cell)) {
+                os.append(cell);
+            }
+        }
+        BoardState state(size, winLength);
+        ReferenceBoard reference(size, winLength);
+        QVector<int> moves;
+        for (int i = 0; i < xs.size(); ++i) {
+            moves.append(xs[i]);
+            if (i < os.size()) {
+                moves.append(os[i]);
+            }
+        }
+        for (int cell : moves) {
+            state.play(cell);
+            reference.play(cell);
+        }
+
+        SearchResult search = engine.search(state, SearchLimits());
+        int expected = referenceValue(reference, memo);
+        int found = !SearchEngine::isWinScore(search.score) ? 0 : (search.score > 0 ? 1 : -1);
+        ++result.checked;
+
+        QString problem;
+        if (!search.exact) {
+            problem = "search did not finish";
+        } else if (found != expected) {
+            problem = QString("search scored %1, the position is worth %2").arg(found).arg(expected);
+        } else if (search.cell < 0 || reference.cells[search.cell] != Player::None) {
+            problem = "search chose an occupied cell";
+        } else {
+            reference.play(search.cell);
+            int chosen = -referenceValue(reference, memo);
+            reference.undo(search.cell);
+            if (chosen != expected) {
+                problem = QString("search chose (%1,%2), worth %3 instead of %4")
+                              .arg(search.cell / size).arg(search.cell % size).arg(chosen).arg(expected);
+            }
+        }
+        if (!problem.isEmpty()) {
+            ++result.mismatches;
+            if (result.issues.size() < GameTreeEnumerator::MaxIssues) {
+                result.issues.append(QString("%1 at %2").arg(problem, describeMoves(moves, size)));
+            }
+        }
+    }
+    return result;
+}
+}
+
+GameTreeEnumerator::GameTreeEnumerator() : boardSize(3), boardWinLength(3), depthLimit(0),
+aiEmptyLimit(9), threadCount(0) {
+}
+
+void GameTreeEnumerator::setBoard(int size, int winLength) {
+    boardSize = qBound(3, size, int(BoardState::MaxSize));
+    boardWinLength = qBound(3, winLength, boardSize);
+}
+
+void GameTreeEnumerator::setMaxDepth(int plies) {
+    depthLimit = qMax(0, plies);
+}
+
+void GameTreeEnumerator::setAIMaxEmpty(int empty) {
+    aiEmptyLimit = empty;
+}
+
+void GameTreeEnumerator::setThreads(int count) {
+    threadCount = qMax(0, count);
+}
+
+EnumerationReport GameTreeEnumerator::run() {
+    QElapsedTimer timer;
+    timer.start();
+    int cells = boardSize * boardSize;
+
+    // The first two plies are fanned out serially; no game can end that early
+    int splitDepth = (depthLimit > 0) ? qMin(2, depthLimit) : 2;
+    Tally total;
+    QVector<QVector<int>> prefixes;
+    total.report.nodes = 1; // The empty board
+    if (cells <= aiEmptyLimit) {
+        total.aiPositions.insert(ReferenceBoard(boardSize, boardWinLength).key());
+    }
+    for (int first = 0; first < cells; ++first) {
+        if (splitDepth == 1) {
+            prefixes.append(QVector<int>{first});
+            continue;
+        }
+        ++total.report.nodes;
+        ReferenceBoard board(boardSize, boardWinLength);
+        board.play(first);
+        if (cells - 1 <= aiEmptyLimit) {
+            total.aiPositions.insert(board.key());
+        }
+        for (int second = 0; second < cells; ++second) {
+            if (second != first) {
+                prefixes.append(QVector<int>{first, second});
+            }
+        }
+    }
+
+    int size = boardSize;
+    int winLength = boardWinLength;
+    int maxDepth = depthLimit;
+    int aiMaxEmpty = aiEmptyLimit;
+    auto walkPrefix = [size, winLength, maxDepth, aiMaxEmpty](const QVector<int>& prefix) {
+        SubtreeWalker walker(size, winLength, maxDepth, aiMaxEmpty);
+        return walker.walk(prefix);
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount > 0 ? threadCount : QThread::idealThreadCount());
+    const QList<Tally> subtrees = QtConcurrent::blockingMapped(&pool, prefixes, walkPrefix);
+    for (const Tally& subtree : subtrees) {
+        total.merge(subtree);
+    }
+    EnumerationReport report = total.report;
+    report.enumerationMs = timer.elapsed();
+
+    // Chunks big enough that each engine's tables are reused across positions
+    timer.restart();
+    QVector<PositionKey> positions(total.aiPositions.constBegin(), total.aiPositions.constEnd());
+    std::sort(positions.begin(), positions.end());
+    QVector<QVector<PositionKey>> chunks;
+    for (int start = 0; start < positions.size(); start += 256) {
+        chunks.append(positions.mid(start, 256));
+    }
+    auto checkChunk = [size, winLength](const QVector<PositionKey>& chunk) {
+        return checkSearch(chunk, size, winLength);
+    };
+    const QList<AiCheck> checks = QtConcurrent::blockingMapped(&pool, chunks, checkChunk);
+    for (const AiCheck& check : checks) {
+        report.aiPositions += check.checked;
+        report.mismatches += check.mismatches;
+        for (const QString& issue : check.issues) {
+            if (report.issues.size() < MaxIssues) {
+                report.issues.append(issue);
+            }
+        }
+    }
+    report.aiMs = timer.elapsed();
+    return report;
+}
@@ -0,0 +1,186 @@
+// historyindex.cpp - Secondary indexes for filtering a player's game history
+#include "historyindex.h"
+#include <QRegularExpression>
+#include <QStringList>
+#include <algorithm>
+#include <limits>
+
+namespace {
+const qint64 NoDate = std::numeric_limits<qint64>::min();
+
+// A year, month or day as the half-open range of times it covers
+bool parsePeriod(const QString& text, QDateTime* start, QDateTime* end) {
+    static const QRegularExpression pattern("^(\\d{4})(?:-(\\d{1,2})(?:-(\\d{1,2}))?)?$");
+    QRegularExpressionMatch match = pattern.match(text);
+    if (!match.hasMatch()) {
+        return false;
+    }
+
+    int year = match.captured(1).toInt();
+    bool hasMonth = !match.captured(2).isEmpty();
+    bool hasDay = !match.captured(3).isEmpty();
+    QDate first(year, hasMonth ? match.captured(2).toInt() : 1, hasDay ? match.captured(3).toInt() : 1);
+    if (!first.isValid()) {
+        return false;
+    }
+
+    QDate last = hasDay ? first.addDays(1) : (hasMonth ? first.addMonths(1) : first.addYears(1));
+    *start = QDateTime(first, QTime(0, 0));
+    *end = QDateTime(last, QTime(0, 0));
+    return true;
+}
+}
+
+bool HistoryFilter::isEmpty() const {
+    return !from.isValid() && !to.isValid() && result.isEmpty() && vsAI < 0 && difficulty.isEmpty();
+}
+
+HistoryFilter HistoryFilter::parse(const QString& text) {
+    HistoryFilter filter;
+    const QStringList words = text.simplified().toLower().split(' ', Qt::SkipEmptyParts);
+    for (const QString& word : words) {
+        if (word == "win" || word == "wins" || word == "won") {
+            filter.result = "X wins"; // The signed-in player is always X
+        } else if (word == "loss" || word == "lost" || word == "lose") {
+            filter.result = "O wins";
+        } else if (word == "tie" || word == "draw") {
+            filter.result = "Tie";
+        } else if (word == "incomplete" || word == "unfinished") {
+            filter.result = "Incomplete";
+        } else if (word == "ai" || word == "bot") {
+            filter.vsAI = 1;
+        } else if (word == "pvp" || word == "2p" || word == "local") {
+            filter.vsAI = 0;
+        } else if (word == "easy" || word == "medium" || word == "hard" || word == "unbeatable") {
+            filter.difficulty = word.left(1).toUpper() + word.mid(1);
+            filter.vsAI = 1;
+        } else if (word.contains("..")) {
+            // Either side of a range may be left open
+            int dots = word.indexOf("..");
+            QString low = word.left(dots);
+            QString high = word.mid(dots + 2);
+            QDateTime start;
+            QDateTime end;
+            if (!low.isEmpty() && parsePeriod(low, &start, &end)) {
+                filter.from = start;
+            }
+            if (!high.isEmpty() && parsePeriod(high, &start, &end)) {
+                filter.to = end;
+            }
+        } else {
+            QDateTime start;
+            QDateTime end;
+            if (parsePeriod(word, &start, &end)) {
+                filter.from = start;
+                filter.to = end;
+            }
+        }
+    }
+    return filter;
+}
+
+HistoryIndex::HistoryIndex() : count(0) {
+}
+
+void HistoryIndex::clear() {
+    count = 0;
+    byDate.clear();
+    byResult.clear();
+    byDifficulty.clear();
+    vsAI.clear();
+}
+
+void HistoryIndex::rebuild(const QJsonArray& history) {
+    clear();
+    byDate.reserve(history.size());
+    for (const QJsonValue& game : history) {
+        append(game.toObject());
+    }
+}
+
+int HistoryIndex::size() const {
+    return count;
+}
+
+void HistoryIndex::setBit(Bitmap& bitmap, int bit) {
+    int word = bit / 64;
+    if (bitmap.size() <= word) {
+        bitmap.resize(word + 1);
+    }
+    bitmap[word] |= quint64(1) << (bit % 64);
+}
+
+void HistoryIndex::append(const QJsonObject& game) {
+    int index = count++;
+
+    QDateTime date = QDateTime::fromString(game["date"].toString(), Qt::ISODate);
+    DateEntry entry;
+    entry.secs = date.isValid() ? date.toSecsSinceEpoch() : NoDate;
+    entry.game = index;
+
+    // Games are normally saved in order, so this is almost always a push to the back
+    auto position = std::upper_bound(byDate.begin(), byDate.end(), entry, [](const DateEntry& a, const DateEntry& b) {
+        return a.secs < b.secs || (a.secs == b.secs && a.game < b.game);
+    });
+    byDate.insert(position, entry);
+
+    setBit(byResult[game["result"].toString()], index);
+    if (game["vsAI"].toBool()) {
+        setBit(vsAI, index);
+        setBit(byDifficulty[game["difficulty"].toString()], index);
+    }
+}
+
+void HistoryIndex::intersect(Bitmap& result, const Bitmap* bitmap, bool invert) {
+    // Bitmaps stop at their last set bit; a missing value matches nothing
+    for (int word = 0; word < result.size(); ++word) {
+        quint64 bits = (bitmap && word < bitmap->size()) ? bitmap->at(word) : 0;
+        result[word] &= invert ? ~bits : bits;
+    }
+}
+
+QVector<int> HistoryIndex::query(const HistoryFilter& filter) const {
+    Bitmap result((count + 63) / 64, ~quint64(0));
+    if (count % 64 != 0) {
+        result.last() = (quint64(1) << (count % 64)) - 1;
+    }
+
+    if (!filter.result.isEmpty()) {
+        auto it = byResult.constFind(filter.result);
+        intersect(result, it == byResult.constEnd() ? nullptr : &it.value(), false);
+    }
+    if (filter.vsAI >= 0) {
+        intersect(result, &vsAI, filter.vsAI == 0);
+    }
+    if (!filter.difficulty.isEmpty()) {
+        auto it = byDifficulty.constFind(filter.difficulty);
+        intersect(result, it == byDifficulty.constEnd() ? nullptr : &it.value(), false);
+    }
+
+    if (filter.from.isValid() || filter.to.isValid()) {
+        // Binary search both ends, then turn the slice between them into a bitmap
+        qint64 low = filter.from.isValid() ? filter.from.toSecsSinceEpoch() : NoDate + 1;
+        qint64 high = filter.to.isValid() ? filter.to.toSecsSinceEpoch() : std::numeric_limits<qint64>::max();
+        auto first = std::lower_bound(byDate.constBegin(), byDate.constEnd(), low, [](const DateEntry& entry, qint64 secs) {
+            return entry.secs < secs;
+        });
+        auto last = std::lower_bound(first, byDate.constEnd(), high, [](const DateEntry& entry, qint64 secs) {
+            return entry.secs < secs;
+        });
+        Bitmap inRange(result.size());
+        for (auto it = first; it != last; ++it) {
+            setBit(inRange, it->game);
+        }
+        intersect(result, &inRange, false);
+    }
+
+    QVector<int> games;
+    for (int word = 0; word < result.size(); ++word) {
+        quint64 bits = result[word];
+        while (bits) {
+            games.append(word * 64 + qCountTrailingZeroBits(bits));
+            bits &= bits - 1;
+        }
+    }
+    return games;
+}
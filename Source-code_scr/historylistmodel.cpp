@@ -0,0 +1,70 @@
+// historylistmodel.cpp - Rows of the history page, limited to the games a filter matched
+#include "historylistmodel.h"
+#include <QJsonObject>
+
+HistoryListModel::HistoryListModel(QObject* parent) : QAbstractListModel(parent) {
+}
+
+void HistoryListModel::setHistory(const QJsonArray& games) {
+    beginResetModel();
+    history = games;
+    thumbnailKeys.clear();
+    rows.resize(history.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        rows[i] = i;
+    }
+    endResetModel();
+}
+
+void HistoryListModel::showAll() {
+    beginResetModel();
+    rows.resize(history.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        rows[i] = i;
+    }
+    endResetModel();
+}
+
+void HistoryListModel::setGames(const QVector<int>& games) {
+    beginResetModel();
+    rows = games;
+    endResetModel();
+}
+
+int HistoryListModel::totalGames() const {
+    return history.size();
+}
+
+int HistoryListModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : rows.size();
+}
+
+QVariant HistoryListModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= rows.size()) {
+        return QVariant();
+    }
+    int game = rows[index.row()];
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        QJsonObject gameData = history[game].toObject();
+        QString date = gameData["date"].toString();
+        QString result = gameData["result"].toString();
+        QString vsAI = gameData["vsAI"].toBool() ? "player vs AI" : "player vs Player";
+        return QString(" %1 - %2 (%3)").arg(date).arg(result).arg(vsAI);
+    }
+    case GameIndexRole:
+        return game;
+    case ThumbnailKeyRole: {
+        QString& key = thumbnailKeys[game];
+        if (key.isEmpty()) {
+            key = ThumbnailCache::gameKey(history[game].toObject());
+        }
+        return key;
+    }
+    case RecordRole:
+        return history[game].toObject();
+    default:
+        return QVariant();
+    }
+}
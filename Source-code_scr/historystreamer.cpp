@@ -0,0 +1,130 @@
+// historystreamer.cpp - Streaming NDJSON export and import of game history
+#include "historystreamer.h"
+#include "userauth.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonParseError>
+
+HistoryStreamer::HistoryStreamer(QObject* parent) : QObject(parent),
+batchSize(1000), repairResults(false) {
+}
+
+void HistoryStreamer::setBatchSize(int size) {
+    batchSize = qMax(1, size);
+}
+
+void HistoryStreamer::setRepairResults(bool repair) {
+    repairResults = repair;
+}
+
+bool HistoryStreamer::exportHistory(const UserAuth* auth, const QString& filePath) {
+    if (!auth || !auth->isLoggedIn()) {
+        return false;
+    }
+
+    // QSaveFile only replaces the target once everything was written
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    // Copies the stored records line by line, the history is never built in memory
+    QFile stored(auth->getHistoryFilePath());
+    if (!stored.exists()) {
+        return file.commit(); // Nothing saved yet
+    }
+    if (!stored.open(QIODevice::ReadOnly)) {
+        file.cancelWriting();
+        return false;
+    }
+    qint64 total = stored.size();
+    int records = 0;
+    while (!stored.atEnd()) {
+        QByteArray line = stored.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        line.append('\n');
+        if (file.write(line) != line.size()) {
+            file.cancelWriting();
+            return false;
+        }
+        if (++records % batchSize == 0 || stored.atEnd()) {
+            emit progress(stored.pos(), total);
+        }
+    }
+
+    return file.commit();
+}
+
+ImportReport HistoryStreamer::importHistory(const QString& filePath, UserAuth* auth) {
+    ImportReport report;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        report.issues.append(ImportIssue{ -1, "Could not open " + filePath });
+        return report;
+    }
+    if (!auth || !auth->isLoggedIn()) {
+        report.issues.append(ImportIssue{ -1, "No user is signed in" });
+        return report;
+    }
+
+    GameImporter importer;
+    importer.setBatchSize(batchSize);
+    importer.setRepairResults(repairResults);
+
+    qint64 fileSize = file.size();
+    int lineNumber = 0;
+    QJsonArray batch;
+    QVector<int> batchLines; // Line number of each record in the batch
+
+    // Validate and commit whatever has been read so far
+    auto flush = [&]() {
+        if (batch.isEmpty()) {
+            return true;
+        }
+        ImportReport part = importer.importToHistory(batch, auth);
+        report.accepted += part.accepted;
+        report.repaired += part.repaired;
+        report.rejected += part.rejected;
+        report.committed += part.committed;
+        for (const ImportIssue& issue : part.issues) {
+            int line = (issue.index >= 0) ? batchLines[issue.index] : -1;
+            report.issues.append(ImportIssue{ line, issue.error });
+        }
+        batch = QJsonArray();
+        batchLines.clear();
+        emit progress(file.pos(), fileSize);
+        return part.committed == part.accepted;
+    };
+
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        ++lineNumber;
+
+        line = line.trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        report.total++;
+
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            report.rejected++;
+            report.issues.append(ImportIssue{ lineNumber, "Line is not a JSON object" });
+            continue;
+        }
+
+        batch.append(doc.object());
+        batchLines.append(lineNumber);
+        if (batch.size() >= batchSize && !flush()) {
+            return report;
+        }
+    }
+
+    flush();
+    return report;
+}
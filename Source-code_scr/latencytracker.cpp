@@ -0,0 +1,215 @@
+// latencytracker.cpp - Input-to-paint latency histograms for the game page
+#include "latencytracker.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <limits>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram() : total(0), sumNs(0), maxSample(0) {
+    for (int bucket = 0; bucket < Buckets; ++bucket) {
+        counts[bucket] = 0;
+    }
+}
+
+double LatencyHistogram::bucketLimitMs(int bucket) {
+    if (bucket >= Buckets - 1) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return 0.25 * (1 << bucket);
+}
+
+void LatencyHistogram::add(qint64 nsecs) {
+    int bucket = 0;
+    while (bucket < Buckets - 1 && nsecs > bucketLimitMs(bucket) * 1000000.0) {
+        ++bucket;
+    }
+    ++counts[bucket];
+    ++total;
+    sumNs += nsecs;
+    maxSample = qMax(maxSample, nsecs);
+}
+
+qint64 LatencyHistogram::count() const {
+    return total;
+}
+
+qint64 LatencyHistogram::maxNs() const {
+    return maxSample;
+}
+
+double LatencyHistogram::meanMs() const {
+    return total > 0 ? sumNs / 1000000.0 / total : 0.0;
+}
+
+double LatencyHistogram::percentileMs(double fraction) const {
+    if (total == 0) {
+        return 0.0;
+    }
+    qint64 target = qMax<qint64>(1, static_cast<qint64>(std::ceil(fraction * total)));
+    qint64 seen = 0;
+    for (int bucket = 0; bucket < Buckets; ++bucket) {
+        seen += counts[bucket];
+        if (seen >= target) {
+            // Never report more than the slowest sample actually seen
+            return qMin(bucketLimitMs(bucket), maxSample / 1000000.0);
+        }
+    }
+    return maxSample / 1000000.0;
+}
+
+qint64 LatencyHistogram::countAbove(double ms) const {
+    qint64 above = 0;
+    for (int bucket = 1; bucket < Buckets; ++bucket) {
+        if (bucketLimitMs(bucket - 1) >= ms) {
+            above += counts[bucket];
+        }
+    }
+    return above;
+}
+
+QJsonObject LatencyHistogram::toJson() const {
+    QJsonObject json;
+    json["count"] = total;
+    json["meanMs"] = meanMs();
+    json["p50Ms"] = percentileMs(0.5);
+    json["p95Ms"] = percentileMs(0.95);
+    json["p99Ms"] = percentileMs(0.99);
+    json["maxMs"] = maxSample / 1000000.0;
+
+    QJsonArray buckets;
+    for (int bucket = 0; bucket < Buckets; ++bucket) {
+        QJsonObject entry;
+        if (bucket < Buckets - 1) {
+            entry["leMs"] = bucketLimitMs(bucket);
+        }
+        entry["count"] = counts[bucket];
+        buckets.append(entry);
+    }
+    json["buckets"] = buckets;
+    return json;
+}
+
+LatencyTracker::LatencyTracker() : reached(-1), lastTotal(0) {
+    clock.start();
+    for (int stage = 0; stage < StageCount; ++stage) {
+        stamps[stage] = 0;
+    }
+}
+
+void LatencyTracker::begin(const QString& category) {
+    pendingCategory = category;
+    stamps[Input] = clock.nsecsElapsed();
+    reached = Input;
+}
+
+void LatencyTracker::mark(Stage stage) {
+    // Stages arrive in order; a repaint before the change was delivered is not the one we want
+    if (reached < 0 || stage != reached + 1) {
+        return;
+    }
+    stamps[stage] = clock.nsecsElapsed();
+    reached = stage;
+    if (stage != Painted) {
+        return;
+    }
+
+    Category& category = results[pendingCategory];
+    lastTotal = stamps[Painted] - stamps[Input];
+    category.stages[Input].add(lastTotal);
+    for (int segment = MoveApplied; segment < StageCount; ++segment) {
+        category.stages[segment].add(stamps[segment] - stamps[segment - 1]);
+    }
+    reached = -1;
+}
+
+void LatencyTracker::cancel() {
+    reached = -1;
+}
+
+bool LatencyTracker::isPending() const {
+    return reached >= 0;
+}
+
+const LatencyHistogram* LatencyTracker::histogram(const QString& category, Stage stage) const {
+    auto it = results.constFind(category);
+    if (it == results.constEnd() || stage < Input || stage >= StageCount) {
+        return nullptr;
+    }
+    return &it->stages[stage];
+}
+
+QStringList LatencyTracker::categories() const {
+    return results.keys();
+}
+
+qint64 LatencyTracker::overBudget(const QString& category) const {
+    const LatencyHistogram* whole = histogram(category, Input);
+    return whole ? whole->countAbove(FrameBudgetMs) : 0;
+}
+
+qint64 LatencyTracker::lastTotalNs() const {
+    return lastTotal;
+}
+
+void LatencyTracker::clear() {
+    results.clear();
+    reached = -1;
+    lastTotal = 0;
+}
+
+QString LatencyTracker::stageName(Stage stage) {
+    switch (stage) {
+    case Input:
+        return "total";
+    case MoveApplied:
+        return "move";
+    case BoardNotified:
+        return "notify";
+    case Painted:
+        return "paint";
+    default:
+        return QString();
+    }
+}
+
+QString LatencyTracker::summary() const {
+    QStringList lines;
+    lines << QString("last %1 ms").arg(lastTotal / 1000000.0, 0, 'f', 2);
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        const LatencyHistogram& whole = it->stages[Input];
+        lines << QString("%1: n=%2 p50 %3 p95 %4 max %5 ms, %6 over %7 ms")
+                     .arg(it.key())
+                     .arg(whole.count())
+                     .arg(whole.percentileMs(0.5), 0, 'f', 2)
+                     .arg(whole.percentileMs(0.95), 0, 'f', 2)
+                     .arg(whole.maxNs() / 1000000.0, 0, 'f', 2)
+                     .arg(whole.countAbove(FrameBudgetMs))
+                     .arg(FrameBudgetMs, 0, 'f', 0);
+    }
+    return lines.join('\n');
+}
+
+QJsonObject LatencyTracker::toJson() const {
+    QJsonObject json;
+    json["budgetMs"] = FrameBudgetMs;
+    QJsonObject categoriesJson;
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        QJsonObject stagesJson;
+        for (int stage = Input; stage < StageCount; ++stage) {
+            stagesJson[stageName(static_cast<Stage>(stage))] = it->stages[stage].toJson();
+        }
+        stagesJson["overBudget"] = it->stages[Input].countAbove(FrameBudgetMs);
+        categoriesJson[it.key()] = stagesJson;
+    }
+    json["categories"] = categoriesJson;
+    return json;
+}
+
+bool LatencyTracker::exportTo(const QString& path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(QJsonDocument(toJson()).toJson()) >= 0;
+}
@@ -0,0 +1,248 @@
+// leaderboard.cpp - Order-statistics index over player ratings
+#include "leaderboard.h"
+#include <QtMath>
+
+Leaderboard::Leaderboard() : root(-1), seed(0x9E3779B9u) {
+}
+
+bool Leaderboard::before(int node, int rating, const QString& username) const {
+    // Higher ratings come first, ties are broken alphabetically
+    const Node& n = nodes[node];
+    return n.rating > rating || (n.rating == rating && n.username < username);
+}
+
+int Leaderboard::sizeOf(int node) const {
+    return node < 0 ? 0 : nodes[node].size;
+}
+
+void Leaderboard::pull(int node) {
+    nodes[node].size = sizeOf(nodes[node].left) + sizeOf(nodes[node].right) + 1;
+}
+
+quint32 Leaderboard::nextPriority() {
+    // xorshift32 is plenty for treap priorities
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+void Leaderboard::split(int node, int rating, const QString& username, bool inclusive, int& left, int& right) {
+    if (node < 0) {
+        left = -1;
+        right = -1;
+        return;
+    }
+
+    bool goesLeft = before(node, rating, username) ||
+                    (inclusive && nodes[node].rating == rating && nodes[node].username == username);
+    if (goesLeft) {
+        int subLeft;
+        int subRight;
+        split(nodes[node].right, rating, username, inclusive, subLeft, subRight);
+        nodes[node].right = subLeft;
+        left = node;
+        right = subRight;
+    } else {
+        int subLeft;
+        int subRight;
+        split(nodes[node].left, rating, username, inclusive, subLeft, subRight);
+        nodes[node].left = subRight;
+        left = subLeft;
+        right = node;
+    }
+    pull(node);
+}
+
+int Leaderboard::merge(int left, int right) {
+    if (left < 0) {
+        return right;
+    }
+    if (right < 0) {
+        return left;
+    }
+
+    if (nodes[left].priority > nodes[right].priority) {
+        int merged = merge(nodes[left].right, right);
+        nodes[left].right = merged;
+        pull(left);
+        return left;
+    }
+
+    int merged = merge(left, nodes[right].left);
+    nodes[right].left = merged;
+    pull(right);
+    return right;
+}
+
+void Leaderboard::setRating(const QString& username, int rating) {
+    // Re-keying a node is a remove followed by an insert
+    remove(username);
+
+    Node node;
+    node.username = username;
+    node.rating = rating;
+    node.priority = nextPriority();
+    node.left = -1;
+    node.right = -1;
+    node.size = 1;
+
+    int id;
+    if (!freeList.isEmpty()) {
+        id = freeList.takeLast();
+        nodes[id] = node;
+    } else {
+        id = nodes.size();
+        nodes.append(node);
+    }
+    index.insert(username, id);
+
+    int left;
+    int right;
+    split(root, rating, username, false, left, right);
+    root = merge(merge(left, id), right);
+}
+
+bool Leaderboard::remove(const QString& username) {
+    auto it = index.constFind(username);
+    if (it == index.constEnd()) {
+        return false;
+    }
+
+    int id = it.value();
+    int rating = nodes[id].rating;
+
+    // Cut out exactly the range holding this key
+    int left;
+    int rest;
+    int middle;
+    int right;
+    split(root, rating, username, false, left, rest);
+    split(rest, rating, username, true, middle, right);
+    root = merge(left, right);
+
+    nodes[id].username.clear();
+    freeList.append(id);
+    index.remove(username);
+    return true;
+}
+
+void Leaderboard::clear() {
+    nodes.clear();
+    freeList.clear();
+    index.clear();
+    root = -1;
+}
+
+bool Leaderboard::contains(const QString& username) const {
+    return index.contains(username);
+}
+
+int Leaderboard::ratingOf(const QString& username) const {
+    auto it = index.constFind(username);
+    if (it == index.constEnd()) {
+        return 0;
+    }
+    return nodes[it.value()].rating;
+}
+
+int Leaderboard::rankOf(const QString& username) const {
+    auto it = index.constFind(username);
+    if (it == index.constEnd()) {
+        return 0;
+    }
+
+    int target = it.value();
+    int rating = nodes[target].rating;
+    int rank = 0;
+    int node = root;
+
+    // Count everything that sorts before the target on the way down
+    while (node >= 0) {
+        if (node == target) {
+            rank += sizeOf(nodes[node].left) + 1;
+            break;
+        }
+        if (before(node, rating, username)) {
+            rank += sizeOf(nodes[node].left) + 1;
+            node = nodes[node].right;
+        } else {
+            node = nodes[node].left;
+        }
+    }
+
+    return rank;
+}
+
+LeaderboardEntry Leaderboard::entryAt(int rank) const {
+    LeaderboardEntry entry;
+    entry.rating = 0;
+    entry.rank = 0;
+
+    if (rank < 1 || rank > size()) {
+        return entry;
+    }
+
+    int node = root;
+    int remaining = rank;
+    while (node >= 0) {
+        int leftSize = sizeOf(nodes[node].left);
+        if (remaining == leftSize + 1) {
+            entry.username = nodes[node].username;
+            entry.rating = nodes[node].rating;
+            entry.rank = rank;
+            break;
+        }
+        if (remaining <= leftSize) {
+            node = nodes[node].left;
+        } else {
+            remaining -= leftSize + 1;
+            node = nodes[node].right;
+        }
+    }
+
+    return entry;
+}
+
+QVector<LeaderboardEntry> Leaderboard::topK(int k) const {
+    QVector<LeaderboardEntry> result;
+    if (k <= 0) {
+        return result;
+    }
+    result.reserve(qMin(k, size()));
+
+    // In-order walk that stops after k nodes
+    QVector<int> stack;
+    int node = root;
+    while ((node >= 0 || !stack.isEmpty()) && result.size() < k) {
+        while (node >= 0) {
+            stack.append(node);
+            node = nodes[node].left;
+        }
+        node = stack.takeLast();
+
+        LeaderboardEntry entry;
+        entry.username = nodes[node].username;
+        entry.rating = nodes[node].rating;
+        entry.rank = result.size() + 1;
+        result.append(entry);
+
+        node = nodes[node].right;
+    }
+
+    return result;
+}
+
+int Leaderboard::size() const {
+    return sizeOf(root);
+}
+
+double Leaderboard::expectedScore(int rating, int opponentRating) {
+    return 1.0 / (1.0 + qPow(10.0, (opponentRating - rating) / 400.0));
+}
+
+int Leaderboard::updatedRating(int rating, int opponentRating, double score, int gamesPlayed) {
+    // Provisional players move faster until their rating settles
+    int kFactor = (gamesPlayed < 30) ? 32 : 16;
+    return qRound(rating + kFactor * (score - expectedScore(rating, opponentRating)));
+}
@@ -1,23 +1,68 @@
 // main.cpp - Entry point for the application
 #include <QApplication>
+#include <QDebug>
 #include "mainwindow.h"
 #include "userauth.h"
 #include "gamelogic.h"
+#include "startuptimings.h"
+#include "tracing.h"
+#include "metrics.h"
+#include <QTimer>
 
 int main(int argc, char *argv[])
 {
+    StartupTimings timings;
     QApplication a(argc, argv);
+    timings.mark(StartupTimings::AppCreated);
 
     // Set application information
     QApplication::setApplicationName("Advanced Tic Tac Toe");
     QApplication::setOrganizationName("Your University Name");
 
-    // Initialize user authentication system
-    UserAuth auth;
+    // Spans are collected with TICTACTOE_TRACE=<file> or --trace <file> and written on exit
+    QString tracePath = qEnvironmentVariable("TICTACTOE_TRACE");
+    int traceArgument = a.arguments().indexOf("--trace");
+    if (traceArgument >= 0 && traceArgument + 1 < a.arguments().size()) {
+        tracePath = a.arguments().at(traceArgument + 1);
+    }
+    Tracer::setEnabled(!tracePath.isEmpty());
+
+    // Metrics are dumped in Prometheus text format to TICTACTOE_METRICS=<file> or
+    // --metrics <file> every 15 seconds, for a node exporter's textfile collector
+    QString metricsPath = qEnvironmentVariable("TICTACTOE_METRICS");
+    int metricsArgument = a.arguments().indexOf("--metrics");
+    if (metricsArgument >= 0 && metricsArgument + 1 < a.arguments().size()) {
+        metricsPath = a.arguments().at(metricsArgument + 1);
+    }
+    Metrics::setEnabled(!metricsPath.isEmpty());
+    QTimer metricsTimer;
+    if (!metricsPath.isEmpty()) {
+        QObject::connect(&metricsTimer, &QTimer::timeout, [metricsPath]() {
+            Metrics::writePrometheus(metricsPath);
+        });
+        metricsTimer.start(15000);
+    }
+
+    // Initialize user authentication system, reading users.json while the window is built
+    UserAuth auth(true);
 
     // Create and show the main window
     MainWindow w(&auth);
+    timings.mark(StartupTimings::WindowBuilt);
+    w.setStartupTimings(&timings);
+    if (a.arguments().contains("--startup-timings")) {
+        QObject::connect(&w, &MainWindow::startupCompleted, [&timings]() {
+            qInfo().noquote() << timings.report();
+        });
+    }
     w.show();
 
-    return a.exec();
+    int result = a.exec();
+    if (!metricsPath.isEmpty()) {
+        Metrics::writePrometheus(metricsPath);
+    }
+    if (!tracePath.isEmpty() && !Tracer::writeChromeTrace(tracePath)) {
+        qWarning().noquote() << "Could not write the trace to" << tracePath;
+    }
+    return result;
 }
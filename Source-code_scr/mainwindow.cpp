@@ -1,4 +1,6 @@
 #include "mainwindow.h"
+#include "tracing.h"
+#include "metrics.h"
 #include <QMessageBox>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -9,9 +11,18 @@
 #include <QPainter>
 #include <QRadioButton>
 #include <QButtonGroup>
+#include <QDir>
+#include <QStandardPaths>
+#include <QGuiApplication>
+#include <QColor>
+#include <QShortcut>
+#include <QKeySequence>
+#include <QEvent>
 
 MainWindow::MainWindow(UserAuth* auth, QWidget* parent)
-    : QMainWindow(parent), userAuth(auth), playerIsX(true)
+    : QMainWindow(parent), userAuth(auth), playerIsX(true), loginPage(nullptr), signupPage(nullptr),
+    menuPage(nullptr), gameModePage(nullptr), gamePage(nullptr), hintsEnabled(false), historyPage(nullptr),
+    startupTimings(nullptr)
 {
     // Set window properties
     setWindowTitle("Advanced Tic Tac Toe");
@@ -60,7 +71,7 @@ MainWindow::MainWindow(UserAuth* auth, QWidget* parent)
         "font-size: 14px;"
         "color: #2d3436;"
         "}"
-        "QListWidget {"
+        "QListView {"
         "background: rgba(255,255,255,0.95);"
         "border: 3px solid #74b9ff;"
         "border-radius: 15px;"
@@ -94,32 +105,34 @@ MainWindow::MainWindow(UserAuth* auth, QWidget* parent)
         "}"
     );
 
-    // Create game logic
+    // Create game logic, keeping a rolling log of AI decisions for diagnostics
+    // and picking up any endgame tablebases built with Tablebase_Tool
     gameLogic = new GameLogic(this);
+    QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataPath);
+    gameLogic->setDecisionLogPath(dataPath + "/ai-decisions.log");
+    gameLogic->setTablebaseDirectory(dataPath + "/tablebases");
+    latencyPath = dataPath + "/latency.json";
+    replayLogic = new GameLogic(this);
+
+    // Think on the player's time, but not while the window is in the background
+    gameLogic->setPonderingEnabled(true);
+    connect(qApp, &QGuiApplication::applicationStateChanged, this, [this](Qt::ApplicationState state) {
+        gameLogic->setPonderingPaused(state != Qt::ApplicationActive);
+    });
 
     // Create stacked widget for different pages
     stackedWidget = new QStackedWidget(this);
     setCentralWidget(stackedWidget);
 
-    // Setup all pages
+    // Only the login page is built up front, the others on first visit
     setupLoginPage();
-    setupSignupPage();
-    setupMenuPage();
-    setupGameModePage();
-    setupGamePage();
-    setupHistoryPage();
-
-    // Add pages to stacked widget
     stackedWidget->addWidget(loginPage);
-    stackedWidget->addWidget(signupPage);
-    stackedWidget->addWidget(menuPage);
-    stackedWidget->addWidget(gameModePage);
-    stackedWidget->addWidget(gamePage);
-    stackedWidget->addWidget(historyPage);
 
     // Connect signals from game logic
     connect(gameLogic, &GameLogic::boardChanged, this, &MainWindow::updateBoard);
     connect(gameLogic, &GameLogic::gameEnded, this, &MainWindow::handleGameEnd);
+    connect(gameLogic, &GameLogic::moveHintsReady, this, &MainWindow::showHints);
 
     // Show login page initially
     stackedWidget->setCurrentWidget(loginPage);
@@ -129,6 +142,30 @@ MainWindow::~MainWindow()
 {
 }
 
+void MainWindow::setStartupTimings(StartupTimings* timings)
+{
+    // The first paint of the login page is caught in eventFilter()
+    startupTimings = timings;
+    loginPage->installEventFilter(this);
+}
+
+bool MainWindow::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == loginPage && event->type() == QEvent::Paint && startupTimings &&
+        !startupTimings->reached(StartupTimings::FirstPaint)) {
+        startupTimings->mark(StartupTimings::FirstPaint);
+        loginPage->removeEventFilter(this);
+
+        // Interactive once the users are in and the frame has been handed over
+        QTimer::singleShot(0, this, [this]() {
+            userAuth->waitForLoad();
+            startupTimings->mark(StartupTimings::Interactive);
+            emit startupCompleted();
+        });
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
 void MainWindow::setupGamePage()
 {
     gamePage = new QWidget();
@@ -160,49 +197,70 @@ void MainWindow::setupGamePage()
         "border-radius: 20px;"
         "}"
     );
-    boardLayout = new QGridLayout(boardWidget);
-    boardLayout->setSpacing(8);
-
-    for (int row = 0; row < 3; ++row) {
-        for (int col = 0; col < 3; ++col) {
-            boardButtons[row][col] = new QPushButton("");
-            boardButtons[row][col]->setFixedSize(100, 100);
-            QFont buttonFont = boardButtons[row][col]->font();
-            buttonFont.setPointSize(32);
-            buttonFont.setBold(true);
-            boardButtons[row][col]->setFont(buttonFont);
-
-            // Special styling for game board buttons
-            boardButtons[row][col]->setStyleSheet(
-                "QPushButton {"
-                "background: qlineargradient(x1:0, y1:0, x2:1, y2:1, "
-                "stop:0 #ffffff, stop:0.5 #f8f9fa, stop:1 #e9ecef);"
-                "border: 4px solid #495057;"
-                "border-radius: 15px;"
-                "font-size: 32px;"
-                "font-weight: bold;"
-                "color: #495057;"
-                "}"
-                "QPushButton:hover {"
-                "background: qlineargradient(x1:0, y1:0, x2:1, y2:1, "
-                "stop:0 #74b9ff, stop:1 #0984e3);"
-                "color: #ffffff;"
-                "border: 4px solid #f1c40f;"
-                "transform: scale(1.1);"
-                "}"
-            );
+    QVBoxLayout* boardFrameLayout = new QVBoxLayout(boardWidget);
+    boardView = new BoardWidget(330);
+    boardFrameLayout->addWidget(boardView);
 
-            // Store row and col as properties for later identification
-            boardButtons[row][col]->setProperty("row", row);
-            boardButtons[row][col]->setProperty("col", col);
+    // The widget maps clicks to cells itself
+    connect(boardView, &BoardWidget::cellClicked, this, &MainWindow::handleCellClicked);
 
-            // Connect button to click handler
-            connect(boardButtons[row][col], &QPushButton::clicked,
-                this, &MainWindow::handleCellClicked);
-
-            boardLayout->addWidget(boardButtons[row][col], row, col);
+    // A click's sample ends with the first frame painted after its board change
+    connect(boardView, &BoardWidget::framePainted, this, [this]() {
+        if (!latency.isPending()) {
+            return;
         }
+        latency.mark(LatencyTracker::Painted);
+        if (!latency.isPending() && latencyOverlay->isVisible()) {
+            latencyOverlay->setText(latency.summary());
+        }
+    });
+
+    // Colors every empty cell by how good it is for the side to move
+    hintsButton = new QPushButton("💡 Hints");
+    hintsButton->setCheckable(true);
+    hintsButton->setStyleSheet(
+        "QPushButton {"
+        "background: qlineargradient(x1:0, y1:0, x2:0, y2:1, "
+        "stop:0 #636e72, stop:1 #2d3436);"
+        "color: #ffffff;"
+        "font-size: 14px;"
+        "padding: 8px;"
+        "}"
+        "QPushButton:checked {"
+        "background: qlineargradient(x1:0, y1:0, x2:0, y2:1, "
+        "stop:0 #f1c40f, stop:1 #e67e22);"
+        "}"
+    );
+    connect(hintsButton, &QPushButton::toggled, this, [this](bool checked) {
+        hintsEnabled = checked;
+        updateHints();
+    });
+
+    // Against the AI a step back takes its reply too
+    QHBoxLayout* gameControlsLayout = new QHBoxLayout();
+    undoButton = new QPushButton("↶ Undo");
+    redoButton = new QPushButton("Redo ↷");
+    for (QPushButton* button : {undoButton, redoButton}) {
+        button->setStyleSheet(
+            "QPushButton {"
+            "background: qlineargradient(x1:0, y1:0, x2:0, y2:1, "
+            "stop:0 #636e72, stop:1 #2d3436);"
+            "color: #ffffff;"
+            "font-size: 14px;"
+            "padding: 8px;"
+            "}"
+        );
+        button->setEnabled(false);
     }
+    connect(undoButton, &QPushButton::clicked, gameLogic, &GameLogic::undo);
+    connect(redoButton, &QPushButton::clicked, gameLogic, &GameLogic::redo);
+    QShortcut* undoShortcut = new QShortcut(QKeySequence::Undo, gamePage);
+    connect(undoShortcut, &QShortcut::activated, gameLogic, &GameLogic::undo);
+    QShortcut* redoShortcut = new QShortcut(QKeySequence::Redo, gamePage);
+    connect(redoShortcut, &QShortcut::activated, gameLogic, &GameLogic::redo);
+    gameControlsLayout->addWidget(undoButton);
+    gameControlsLayout->addWidget(hintsButton);
+    gameControlsLayout->addWidget(redoButton);
 
     backToMenuFromGameButton = new QPushButton("Return");
     backToMenuFromGameButton->setStyleSheet(
@@ -220,9 +278,31 @@ void MainWindow::setupGamePage()
     layout->addWidget(gameStatusLabel);
     layout->addSpacing(20);
     layout->addWidget(boardWidget, 0, Qt::AlignCenter);
-    layout->addSpacing(30);
+    layout->addSpacing(10);
+    layout->addLayout(gameControlsLayout);
+    layout->addSpacing(20);
     layout->addWidget(backToMenuFromGameButton);
 
+    // Debug overlay with the latency histograms, off by default
+    latencyOverlay = new QLabel();
+    latencyOverlay->setStyleSheet(
+        "color: #ffffff;"
+        "background: rgba(0, 0, 0, 0.6);"
+        "font-family: monospace;"
+        "font-size: 11px;"
+        "padding: 6px;"
+    );
+    latencyOverlay->hide();
+    layout->addWidget(latencyOverlay);
+
+    QShortcut* overlayShortcut = new QShortcut(QKeySequence("Ctrl+Shift+L"), gamePage);
+    connect(overlayShortcut, &QShortcut::activated, this, [this]() {
+        latencyOverlay->setText(latency.summary());
+        latencyOverlay->setVisible(!latencyOverlay->isVisible());
+    });
+    QShortcut* exportShortcut = new QShortcut(QKeySequence("Ctrl+Shift+E"), gamePage);
+    connect(exportShortcut, &QShortcut::activated, this, &MainWindow::exportLatency);
+
     // Connect back button
     connect(backToMenuFromGameButton, &QPushButton::clicked,
         this, &MainWindow::showMenuPage);
@@ -556,6 +636,20 @@ void MainWindow::setupGameModePage() {
                 "    color: white;"
                 "}"
         );
+    // Board shape for the next game; the data is size * 10 + win length, 0 for ultimate
+    QLabel* boardLabel = new QLabel("Board:");
+    boardLabel->setAlignment(Qt::AlignCenter);
+    boardLabel->setFont(difficultyFont);
+    boardLabel->setStyleSheet("color: #00ff88; text-shadow: 3px 3px 6px rgba(0,0,0,0.8);");
+
+    boardComboBox = new QComboBox();
+    boardComboBox->addItem("Classic 3 x 3", 33);
+    boardComboBox->addItem("4 x 4, four in a row", 44);
+    boardComboBox->addItem("5 x 5, four in a row", 54);
+    boardComboBox->addItem("7 x 7, five in a row", 75);
+    boardComboBox->addItem("Ultimate", 0);
+    boardComboBox->setStyleSheet(difficultyComboBox->styleSheet());
+
     difficultyConfirmButton = new QPushButton("Set AI Level");
     difficultyConfirmButton->setStyleSheet(
         "QPushButton {"
@@ -586,6 +680,9 @@ void MainWindow::setupGameModePage() {
     layout->addWidget(difficultyLabel);
     layout->addWidget(difficultyComboBox);
     layout->addWidget(difficultyConfirmButton);
+    layout->addSpacing(15);
+    layout->addWidget(boardLabel);
+    layout->addWidget(boardComboBox);
     layout->addSpacing(25);
     layout->addWidget(backToMenuFromGameModeButton);
     layout->addStretch();
@@ -605,6 +702,18 @@ void MainWindow::handleDifficultyChanged() {
     QMessageBox::information(this, "AI Level Set", "AI Level: " + difficultyName);
 }
 
+void MainWindow::applyBoardChoice()
+{
+    int choice = boardComboBox->currentData().toInt();
+    if (choice == 0) {
+        gameLogic->setVariant(GameVariant::Ultimate);
+    }
+    else {
+        gameLogic->setVariant(GameVariant::Classic);
+        gameLogic->setBoardSize(choice / 10, choice % 10);
+    }
+}
+
 void MainWindow::setupHistoryPage()
 {
     historyPage = new QWidget();
@@ -618,9 +727,51 @@ void MainWindow::setupHistoryPage()
     titleLabel->setFont(titleFont);
     titleLabel->setStyleSheet("color: #f1c40f; text-shadow: 4px 4px 8px rgba(0,0,0,0.9);");
 
-    // Game list
-    gamesList = new QListWidget();
+    // Game list, each row with a thumbnail of the final board drawn off the GUI thread
+    // and kept on disk between runs. Uniform rows spare the view a size hint per game.
+    thumbnails = new ThumbnailCache(40, this);
+    thumbnails->setByteBudget(4 * 1024 * 1024);
+    thumbnails->setDiskDirectory(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/thumbnails");
+    historyModel = new HistoryListModel(this);
+    gamesList = new QListView();
+    gamesList->setModel(historyModel);
     gamesList->setAlternatingRowColors(true);
+    gamesList->setUniformItemSizes(true);
+    gamesList->setIconSize(QSize(thumbnails->side(), thumbnails->side()));
+    gamesList->setItemDelegate(new ThumbnailDelegate(thumbnails, gamesList));
+    connect(thumbnails, &ThumbnailCache::thumbnailReady, gamesList->viewport(), [this]() {
+        gamesList->viewport()->update();
+    });
+
+    // Engine analysis of every game, kept between runs so each game is searched once
+    analyzer = new GameAnalyzer(this);
+    analyzer->setCacheFile(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/analysis.json");
+    analysisProgress = new QProgressBar();
+    analysisProgress->setFormat("Analyzing %v of %m games");
+    analysisProgress->hide();
+    connect(analyzer, &GameAnalyzer::progress, this, [this](int done, int total) {
+        analysisProgress->setRange(0, total);
+        analysisProgress->setValue(done);
+    });
+    connect(analyzer, &GameAnalyzer::finished, this, [this](bool cancelled) {
+        analysisProgress->hide();
+        analyzeButton->setText("Analyze");
+        if (cancelled) {
+            replayStatusLabel->setText("Analysis cancelled");
+            return;
+        }
+        int analyzed = 0;
+        QString summary = analysisSummary(userAuth->getGameHistory(), &analyzed);
+        replayStatusLabel->setText(QString("%1 games analyzed: %2").arg(analyzed).arg(summary));
+    });
+
+    // Filter bar, answered from the history indexes on every keystroke
+    historyFilterEdit = new QLineEdit();
+    historyFilterEdit->setPlaceholderText("Filter: 2024-05, 2024-01..2024-03, win, loss, tie, ai, pvp, hard");
+    historyFilterEdit->setClearButtonEnabled(true);
+    historyCountLabel = new QLabel();
+    historyCountLabel->setAlignment(Qt::AlignRight);
+    connect(historyFilterEdit, &QLineEdit::textChanged, this, &MainWindow::applyHistoryFilter);
 
     // Buttons for managing history
     QHBoxLayout* buttonsLayout = new QHBoxLayout();
@@ -643,7 +794,19 @@ void MainWindow::setupHistoryPage()
         "}"
     );
 
+    analyzeButton = new QPushButton("Analyze");
+    analyzeButton->setStyleSheet(
+        "QPushButton {"
+        "background: qlineargradient(x1:0, y1:0, x2:0, y2:1, "
+        "stop:0 #55efc4, stop:1 #00b894);"
+        "font-size: 16px;"
+        "padding: 12px;"
+        "}"
+    );
+    connect(analyzeButton, &QPushButton::clicked, this, &MainWindow::analyzeHistory);
+
     buttonsLayout->addWidget(loadGameButton);
+    buttonsLayout->addWidget(analyzeButton);
     buttonsLayout->addWidget(backToMenuFromHistoryButton);
 
     // Replay controls
@@ -672,39 +835,18 @@ void MainWindow::setupHistoryPage()
         "border-radius: 15px;"
         "}"
     );
-    replayBoardLayout = new QGridLayout(replayBoardWidget);
-    replayBoardLayout->setSpacing(5);
-
-    for (int row = 0; row < 3; ++row) {
-        for (int col = 0; col < 3; ++col) {
-            boardReplayButtons[row][col] = new QPushButton("");
-            boardReplayButtons[row][col]->setFixedSize(70, 70);
-            QFont buttonFont = boardReplayButtons[row][col]->font();
-            buttonFont.setPointSize(20);
-            buttonFont.setBold(true);
-            boardReplayButtons[row][col]->setFont(buttonFont);
-            boardReplayButtons[row][col]->setEnabled(false);
-
-            // Special styling for replay board buttons
-            boardReplayButtons[row][col]->setStyleSheet(
-                "QPushButton {"
-                "background: qlineargradient(x1:0, y1:0, x2:1, y2:1, "
-                "stop:0 #ffffff, stop:1 #f0f0f0);"
-                "border: 3px solid #495057;"
-                "border-radius: 10px;"
-                "font-size: 20px;"
-                "font-weight: bold;"
-                "}"
-            );
-
-            replayBoardLayout->addWidget(boardReplayButtons[row][col], row, col);
-        }
-    }
+    QVBoxLayout* replayFrameLayout = new QVBoxLayout(replayBoardWidget);
+    replayBoardView = new BoardWidget(230);
+    replayBoardView->setInteractive(false);
+    replayFrameLayout->addWidget(replayBoardView);
 
     layout->addWidget(titleLabel);
     layout->addSpacing(15);
+    layout->addWidget(historyFilterEdit);
+    layout->addWidget(historyCountLabel);
     layout->addWidget(gamesList);
     layout->addLayout(buttonsLayout);
+    layout->addWidget(analysisProgress);
     layout->addSpacing(25);
     layout->addWidget(replayStatusLabel);
     layout->addLayout(replayControlsLayout);
@@ -718,76 +860,83 @@ void MainWindow::setupHistoryPage()
     connect(nextMoveButton, &QPushButton::clicked, this, &MainWindow::playNextMove);
 }
 
-void MainWindow::handleCellClicked()
+void MainWindow::handleCellClicked(int row, int col)
 {
-    QPushButton* button = qobject_cast<QPushButton*>(sender());
-    if (button) {
-        int row = button->property("row").toInt();
-        int col = button->property("col").toInt();
+    latency.begin(latencyCategory());
+    if (gameLogic->makeMove(row, col)) {
+        latency.mark(LatencyTracker::MoveApplied);
+    } else {
+        latency.cancel();
+    }
+}
 
-        gameLogic->makeMove(row, col);
+QString MainWindow::latencyCategory() const
+{
+    if (!gameLogic->isVsAI()) {
+        return "Two player";
+    }
+    switch (gameLogic->getDifficulty()) {
+    case AIDifficulty::Easy:
+        return "Easy";
+    case AIDifficulty::Medium:
+        return "Medium";
+    case AIDifficulty::Hard:
+        return "Hard";
+    default:
+        return "Unbeatable";
     }
 }
 
-void MainWindow::updateBoard()
+void MainWindow::exportLatency()
 {
-    // Update the board with the current game state
-    for (int row = 0; row < 3; ++row) {
-        for (int col = 0; col < 3; ++col) {
-            Player cell = gameLogic->getCell(row, col);
-            QPushButton* button = boardButtons[row][col];
-
-            if (cell == Player::X) {
-                button->setText("❌");
-                button->setStyleSheet(
-                    "QPushButton {"
-                    "background: qlineargradient(x1:0, y1:0, x2:1, y2:1, "
-                    "stop:0 #ff7675, stop:1 #fd79a8);"
-                    "border: 4px solid #e84393;"
-                    "border-radius: 15px;"
-                    "font-size: 28px;"
-                    "color: #ffffff;"
-                    "text-shadow: 2px 2px 4px rgba(0,0,0,0.7);"
-                    "}"
-                );
-            }
-            else if (cell == Player::O) {
-                button->setText("⭕");
-                button->setStyleSheet(
-                    "QPushButton {"
-                    "background: qlineargradient(x1:0, y1:0, x2:1, y2:1, "
-                    "stop:0 #74b9ff, stop:1 #0984e3);"
-                    "border: 4px solid #00b894;"
-                    "border-radius: 15px;"
-                    "font-size: 28px;"
-                    "color: #ffffff;"
-                    "text-shadow: 2px 2px 4px rgba(0,0,0,0.7);"
-                    "}"
-                );
-            }
-            else {
-                button->setText("");
-                button->setStyleSheet(
-                    "QPushButton {"
-                    "background: qlineargradient(x1:0, y1:0, x2:1, y2:1, "
-                    "stop:0 #ffffff, stop:0.5 #f8f9fa, stop:1 #e9ecef);"
-                    "border: 4px solid #495057;"
-                    "border-radius: 15px;"
-                    "font-size: 32px;"
-                    "font-weight: bold;"
-                    "color: #495057;"
-                    "}"
-                    "QPushButton:hover {"
-                    "background: qlineargradient(x1:0, y1:0, x2:1, y2:1, "
-                    "stop:0 #74b9ff, stop:1 #0984e3);"
-                    "color: #ffffff;"
-                    "border: 4px solid #f1c40f;"
-                    "transform: scale(1.1);"
-                    "}"
-                );
+    QString message = latency.exportTo(latencyPath) ? "Saved to " + latencyPath
+                                                    : "Could not write " + latencyPath;
+    latencyOverlay->setText(latency.summary() + "\n" + message);
+    latencyOverlay->show();
+}
+
+void MainWindow::updateBoard(const BoardChange& change)
+{
+    TRACE_SCOPE("MainWindow::updateBoard");
+    // Changes delivered before the game page exists are drawn when it is built
+    if (!gamePage) {
+        return;
+    }
+
+    // Only what GameLogic reports as changed is pushed to the widget
+    int size = gameLogic->getBoardSize();
+    bool ultimate = (gameLogic->getVariant() == GameVariant::Ultimate);
+    if (change.reset) {
+        boardView->setBoardSize(size);
+        boardView->setSubBoards(ultimate);
+        for (int row = 0; row < size; ++row) {
+            for (int col = 0; col < size; ++col) {
+                boardView->setCell(row, col, gameLogic->getCell(row, col));
             }
         }
     }
+    for (int cell : change.cells) {
+        boardView->setCell(cell / size, cell % size, gameLogic->getCell(cell / size, cell % size));
+    }
+    if (!change.cells.isEmpty()) {
+        latency.mark(LatencyTracker::BoardNotified);
+    }
+
+    bool cellsChanged = change.reset || !change.cells.isEmpty();
+    if (ultimate && (cellsChanged || change.forcedBoardChanged || change.resultChanged)) {
+        boardView->setForcedBoard(gameLogic->isGameOver() ? -1 : gameLogic->getForcedBoard());
+        for (int board = 0; board < 9; ++board) {
+            boardView->setSubBoardWinner(board, gameLogic->getSubBoardWinner(board));
+        }
+    }
+    if (cellsChanged || change.playerChanged) {
+        updateHints();
+    }
+    undoButton->setEnabled(gameLogic->canUndo());
+    redoButton->setEnabled(gameLogic->canRedo());
+    if (!change.playerChanged && !change.resultChanged) {
+        return;
+    }
 
     // Update game status label with creative messages
     if (!gameLogic->isGameOver()) {
@@ -801,58 +950,60 @@ void MainWindow::updateBoard()
     }
 }
 
-void MainWindow::updateBoardButtons()
+void MainWindow::updateHints()
 {
-    updateBoard(); // Use the same logic
+    // Hints come from one search over all empty cells on a worker, so the board
+    // is cleared now and coloured when it answers; positions seen before answer at once.
+    // Not shown while the AI is about to reply.
+    showHints(QVector<RootScore>());
+    bool aiToMove = gameLogic->isVsAI() && gameLogic->getCurrentPlayer() == Player::O;
+    if (hintsEnabled && !aiToMove && !gameLogic->isGameOver()) {
+        gameLogic->requestMoveHints(100);
+    }
 }
 
-void MainWindow::updateReplayBoardButtons()
+void MainWindow::showHints(const QVector<RootScore>& scores)
 {
-    // Update the replay board with the current game state
-    for (int row = 0; row < 3; ++row) {
-        for (int col = 0; col < 3; ++col) {
-            Player cell = gameLogic->getCell(row, col);
-            QPushButton* button = boardReplayButtons[row][col];
-
-            if (cell == Player::X) {
-                button->setText("❌");
-                button->setStyleSheet(
-                    "QPushButton {"
-                    "background: qlineargradient(x1:0, y1:0, x2:1, y2:1, "
-                    "stop:0 #ff7675, stop:1 #fd79a8);"
-                    "border: 3px solid #e84393;"
-                    "border-radius: 10px;"
-                    "font-size: 18px;"
-                    "color: #ffffff;"
-                    "}"
-                );
-            }
-            else if (cell == Player::O) {
-                button->setText("⭕");
-                button->setStyleSheet(
-                    "QPushButton {"
-                    "background: qlineargradient(x1:0, y1:0, x2:1, y2:1, "
-                    "stop:0 #74b9ff, stop:1 #0984e3);"
-                    "border: 3px solid #00b894;"
-                    "border-radius: 10px;"
-                    "font-size: 18px;"
-                    "color: #ffffff;"
-                    "}"
-                );
-            }
-            else {
-                button->setText("");
-                button->setStyleSheet(
-                    "QPushButton {"
-                    "background: qlineargradient(x1:0, y1:0, x2:1, y2:1, "
-                    "stop:0 #ffffff, stop:1 #f0f0f0);"
-                    "border: 3px solid #495057;"
-                    "border-radius: 10px;"
-                    "font-size: 20px;"
-                    "font-weight: bold;"
-                    "}"
-                );
-            }
+    int size = gameLogic->getBoardSize();
+    QVector<QColor> hints(size * size);
+    if (hintsEnabled) {
+        for (const RootScore& hint : scores) {
+            hints[hint.cell] = hintColor(hint.score);
+        }
+    }
+    for (int index = 0; index < hints.size(); ++index) {
+        boardView->setHint(index / size, index % size, hints[index]);
+    }
+}
+
+QColor MainWindow::hintColor(int score) const
+{
+    // Red for a lost cell through yellow for a draw to green for a win
+    double value;
+    if (SearchEngine::isWinScore(score)) {
+        value = (score > 0) ? 1.0 : -1.0;
+    }
+    else {
+        value = qBound(-0.8, score / 100.0, 0.8);
+    }
+    return QColor::fromHsv(60 + static_cast<int>(value * 60), 140, 240);
+}
+
+void MainWindow::updateReplayBoard()
+{
+    int size = replayLogic->getBoardSize();
+    bool ultimate = (replayLogic->getVariant() == GameVariant::Ultimate);
+    replayBoardView->setBoardSize(size);
+    replayBoardView->setSubBoards(ultimate);
+    for (int row = 0; row < size; ++row) {
+        for (int col = 0; col < size; ++col) {
+            replayBoardView->setCell(row, col, replayLogic->getCell(row, col));
+        }
+    }
+    if (ultimate) {
+        replayBoardView->setForcedBoard(replayLogic->isGameOver() ? -1 : replayLogic->getForcedBoard());
+        for (int board = 0; board < 9; ++board) {
+            replayBoardView->setSubBoardWinner(board, replayLogic->getSubBoardWinner(board));
         }
     }
 }
@@ -893,6 +1044,10 @@ void MainWindow::showLoginPage()
 
 void MainWindow::showSignupPage()
 {
+    if (!signupPage) {
+        setupSignupPage();
+        stackedWidget->addWidget(signupPage);
+    }
     signupUsername->clear();
     signupPassword->clear();
     signupConfirmPassword->clear();
@@ -903,6 +1058,10 @@ void MainWindow::showSignupPage()
 void MainWindow::showMenuPage()
 {
     if (userAuth->isLoggedIn()) {
+        if (!menuPage) {
+            setupMenuPage();
+            stackedWidget->addWidget(menuPage);
+        }
         welcomeLabel->setText("🌟 Welcome back, " + userAuth->getCurrentUser() + "! 🌟");
         stackedWidget->setCurrentWidget(menuPage);
     }
@@ -913,17 +1072,33 @@ void MainWindow::showMenuPage()
 
 void MainWindow::showGamePage()
 {
-    updateBoardButtons();
+    // Otherwise the board is drawn by the reset newGame() queued
+    if (!gamePage) {
+        setupGamePage();
+        stackedWidget->addWidget(gamePage);
+        BoardChange everything;
+        everything.reset = true;
+        everything.playerChanged = true;
+        updateBoard(everything);
+    }
     stackedWidget->setCurrentWidget(gamePage);
 }
 
 void MainWindow::showGameModePage()
 {
+    if (!gameModePage) {
+        setupGameModePage();
+        stackedWidget->addWidget(gameModePage);
+    }
     stackedWidget->setCurrentWidget(gameModePage);
 }
 
 void MainWindow::showHistoryPage()
 {
+    if (!historyPage) {
+        setupHistoryPage();
+        stackedWidget->addWidget(historyPage);
+    }
     loadGameHistory();
     stackedWidget->setCurrentWidget(historyPage);
 }
@@ -1013,6 +1188,9 @@ void MainWindow::handleSignup() {
 
 void MainWindow::handleLogout()
 {
+    if (historyPage) {
+        analyzer->cancel();
+    }
     userAuth->signOut();
     showLoginPage();
 }
@@ -1022,7 +1200,9 @@ void MainWindow::startTwoPlayerGame()
     // Check which symbol the player chose
     playerIsX = true; // 0 for X, 1 for O
 
+    applyBoardChoice();
     gameLogic->newGame(false); // Start game with 2 players
+    AppMetrics::gamesStarted[0].add();
     showGamePage();
 }
 
@@ -1033,7 +1213,9 @@ void MainWindow::startAIGame() {
     // Check which symbol the player chose
     playerIsX = true; // 0 for X, 1 for O
 
+    applyBoardChoice();
     gameLogic->newGame(true); // Start game with AI
+    AppMetrics::gamesStarted[1].add();
 
     // FIXED: Only make AI move if player chose O and it's X's turn
     if (!playerIsX && gameLogic->getCurrentPlayer() == Player::X) {
@@ -1047,41 +1229,99 @@ void MainWindow::startAIGame() {
 
 void MainWindow::loadGameHistory()
 {
-    gamesList->clear();
+    TRACE_SCOPE("MainWindow::loadGameHistory");
+    thumbnails->cancelPending();
+    historyModel->setHistory(userAuth->isLoggedIn() ? userAuth->getGameHistory() : QJsonArray());
+    applyHistoryFilter();
+}
 
+void MainWindow::applyHistoryFilter()
+{
+    // The model is reset with the matching positions, no rows are rebuilt
+    HistoryFilter filter = HistoryFilter::parse(historyFilterEdit->text());
+    if (filter.isEmpty() || !userAuth->isLoggedIn()) {
+        historyModel->showAll();
+    }
+    else {
+        historyModel->setGames(userAuth->getHistoryIndex().query(filter));
+    }
+    historyCountLabel->setText(QString("%1 of %2 games").arg(historyModel->rowCount()).arg(historyModel->totalGames()));
+}
+
+void MainWindow::analyzeHistory()
+{
+    // The same button cancels a run in progress
+    if (analyzer->isRunning()) {
+        analyzer->cancel();
+        return;
+    }
     if (!userAuth->isLoggedIn()) {
         return;
     }
 
-    QJsonArray history = userAuth->getGameHistory();
-
-    for (int i = 0; i < history.size(); ++i) {
-        QJsonObject gameData = history[i].toObject();
-        QString date = gameData["date"].toString();
-        QString result = gameData["result"].toString();
-        QString vsAI = gameData["vsAI"].toBool() ? "player vs AI" : "player vs Player";
+    const QJsonArray history = userAuth->getGameHistory();
+    QVector<QJsonObject> games;
+    games.reserve(history.size());
+    for (const QJsonValue& game : history) {
+        games.append(game.toObject());
+    }
+    analyzeButton->setText("Cancel analysis");
+    analysisProgress->setRange(0, 0);
+    analysisProgress->show();
+    analyzer->analyze(games);
+}
 
-        QListWidgetItem* item = new QListWidgetItem(QString(" %1 - %2 (%3)").arg(date).arg(result).arg(vsAI));
-        item->setData(Qt::UserRole, i); // Store the game index
-        gamesList->addItem(item);
+QString MainWindow::analysisSummary(const QJsonArray& games, int* analyzedGames) const
+{
+    // The player is X against the AI and both sides in two-player games
+    int analyzed = 0;
+    int moves = 0;
+    int accurate = 0;
+    int blunders = 0;
+    int missedWins = 0;
+    for (const QJsonValue& value : games) {
+        QJsonObject game = value.toObject();
+        GameAnalysis analysis = analyzer->analysis(GameAnalyzer::gameKey(game));
+        if (!analysis.valid) {
+            continue;
+        }
+        ++analyzed;
+        int sides = game["vsAI"].toBool() ? 1 : 2;
+        for (int side = 0; side < sides; ++side) {
+            moves += analysis.moves[side];
+            accurate += analysis.accurate[side];
+            blunders += analysis.blunders[side];
+            missedWins += analysis.missedWins[side];
+        }
+    }
+    if (analyzedGames) {
+        *analyzedGames = analyzed;
+    }
+    if (moves == 0) {
+        return QString("no moves to score");
     }
+    return QString("%1% accuracy, %2 blunders, %3 missed wins").arg(accurate * 100 / moves).arg(blunders).arg(missedWins);
 }
 
 void MainWindow::loadSelectedGame()
 {
-    QListWidgetItem* selectedItem = gamesList->currentItem();
-    if (!selectedItem) {
+    QModelIndex selected = gamesList->currentIndex();
+    if (!selected.isValid()) {
         return;
     }
 
-    int gameIndex = selectedItem->data(Qt::UserRole).toInt();
+    int gameIndex = selected.data(HistoryListModel::GameIndexRole).toInt();
     QJsonArray history = userAuth->getGameHistory();
 
     if (gameIndex >= 0 && gameIndex < history.size()) {
         QJsonObject gameData = history[gameIndex].toObject();
 
-        // Load game into game logic
-        gameLogic->loadFromJson(gameData);
+        // Load game into the replay's own game logic
+        if (!replayLogic->loadFromJson(gameData)) {
+            replaySlider->setEnabled(false);
+            replayStatusLabel->setText("This saved game is damaged and cannot be replayed.");
+            return;
+        }
 
         // Setup replay controls
         QJsonArray movesArray = gameData["moves"].toArray();
@@ -1092,20 +1332,24 @@ void MainWindow::loadSelectedGame()
 
         // Update status
         QString vsAI = gameData["vsAI"].toBool() ? "player vs AI" : "player vs Player";
-        replayStatusLabel->setText(QString("Reliving game from %1 (%2)").arg(gameData["date"].toString()).arg(vsAI));
+        QString status = QString("Reliving game from %1 (%2)").arg(gameData["date"].toString()).arg(vsAI);
+        if (analyzer->analysis(GameAnalyzer::gameKey(gameData)).valid) {
+            status += "\n" + analysisSummary(QJsonArray{gameData});
+        }
+        replayStatusLabel->setText(status);
 
         // Update board
-        updateReplayBoardButtons();
+        updateReplayBoard();
     }
 }
 
 void MainWindow::updateReplay(int value)
 {
-    gameLogic->replayMove(value);
-    updateReplayBoardButtons();
+    replayLogic->replayMove(value);
+    updateReplayBoard();
 
     // Update status with epic messages
-    QVector<Move> moves = gameLogic->getMoves();
+    QVector<Move> moves = replayLogic->getMoves();
     if (value == 0) {
         replayStatusLabel->setText("Game starts...");
     }
@@ -0,0 +1,219 @@
+// matchmaker.cpp - Matchmaking queue implementation
+#include "matchmaker.h"
+#include <algorithm>
+
+Matchmaker::Matchmaker(QObject* parent, int queueCapacity) : QObject(parent),
+baseRatingWindow(100), ratingWindowGrowth(50), aiFallbackMs(10000) {
+    // One lock-free queue per (mode, difficulty) bucket
+    for (int i = 0; i < BucketCount; ++i) {
+        buckets[i].queue.reset(new MpmcQueue<MatchRequest>(queueCapacity));
+    }
+    for (int i = 0; i < HistogramSize; ++i) {
+        histogram[i].store(0, std::memory_order_relaxed);
+    }
+
+    clock.start();
+
+    tickTimer = new QTimer(this);
+    connect(tickTimer, &QTimer::timeout, this, &Matchmaker::processQueues);
+}
+
+int Matchmaker::bucketIndex(MatchMode mode, AIDifficulty difficulty) {
+    int modeIndex = (mode == MatchMode::TwoPlayer) ? 0 : 1;
+    return modeIndex * 4 + static_cast<int>(difficulty);
+}
+
+bool Matchmaker::enqueue(const QString& username, int rating, MatchMode mode, AIDifficulty difficulty) {
+    MatchRequest request;
+    request.username = username;
+    request.rating = rating;
+    request.mode = mode;
+    request.difficulty = difficulty;
+    request.enqueuedAt = clock.elapsed();
+
+    Bucket& bucket = buckets[bucketIndex(mode, difficulty)];
+    if (!bucket.queue->tryEnqueue(request)) {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    bucket.depth.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void Matchmaker::start(int tickMs) {
+    tickTimer->start(tickMs);
+}
+
+void Matchmaker::stop() {
+    tickTimer->stop();
+}
+
+void Matchmaker::setRatingWindow(int baseWindow, int growthPerSecond) {
+    baseRatingWindow = baseWindow;
+    ratingWindowGrowth = growthPerSecond;
+}
+
+void Matchmaker::setAIFallbackTimeout(int ms) {
+    aiFallbackMs = ms;
+}
+
+int Matchmaker::ratingWindow(qint64 waitMs) const {
+    // The longer someone waits, the wider the rating gap we accept
+    return baseRatingWindow + static_cast<int>(ratingWindowGrowth * waitMs / 1000);
+}
+
+int Matchmaker::processQueues() {
+    qint64 now = clock.elapsed();
+    int matches = 0;
+
+    for (int i = 0; i < BucketCount; ++i) {
+        Bucket& bucket = buckets[i];
+
+        // Drain new arrivals into the waiting pool
+        MatchRequest request;
+        while (bucket.queue->tryDequeue(request)) {
+            bucket.depth.fetch_sub(1, std::memory_order_relaxed);
+            bucket.waiting.append(request);
+        }
+
+        if (bucket.waiting.isEmpty()) {
+            continue;
+        }
+
+        // AI buckets never wait for a partner
+        if (bucket.waiting.first().mode == MatchMode::VsAI) {
+            for (const MatchRequest& waiting : bucket.waiting) {
+                emitAIMatch(waiting, now);
+                ++matches;
+            }
+            bucket.waiting.clear();
+            bucket.waitingCount.store(0, std::memory_order_relaxed);
+            continue;
+        }
+
+        // Pair neighbours in rating order when they fall inside the window
+        std::stable_sort(bucket.waiting.begin(), bucket.waiting.end(),
+                         [](const MatchRequest& a, const MatchRequest& b) {
+                             return a.rating < b.rating;
+                         });
+
+        QVector<MatchRequest> stillWaiting;
+        int index = 0;
+        while (index < bucket.waiting.size()) {
+            const MatchRequest& current = bucket.waiting[index];
+            qint64 currentWait = now - current.enqueuedAt;
+
+            if (index + 1 < bucket.waiting.size()) {
+                const MatchRequest& next = bucket.waiting[index + 1];
+                qint64 longestWait = qMax(currentWait, now - next.enqueuedAt);
+                if (next.rating - current.rating <= ratingWindow(longestWait)) {
+                    emitPair(current, next, now);
+                    ++matches;
+                    index += 2;
+                    continue;
+                }
+            }
+
+            // Nobody close enough: give up on a human after the timeout
+            if (currentWait >= aiFallbackMs) {
+                emitAIMatch(current, now);
+                ++matches;
+            } else {
+                stillWaiting.append(current);
+            }
+            ++index;
+        }
+        bucket.waiting = stillWaiting;
+        bucket.waitingCount.store(stillWaiting.size(), std::memory_order_relaxed);
+    }
+
+    return matches;
+}
+
+void Matchmaker::recordWait(qint64 waitMs) {
+    playersMatched.fetch_add(1, std::memory_order_relaxed);
+    totalWaitMs.fetch_add(waitMs, std::memory_order_relaxed);
+
+    qint64 previous = maxWaitMs.load(std::memory_order_relaxed);
+    while (waitMs > previous && !maxWaitMs.compare_exchange_weak(previous, waitMs, std::memory_order_relaxed)) {
+    }
+
+    static const QVector<qint64> bounds = histogramBounds();
+    int slot = 0;
+    while (slot < bounds.size() && waitMs > bounds[slot]) {
+        ++slot;
+    }
+    histogram[slot].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Matchmaker::emitPair(const MatchRequest& a, const MatchRequest& b, qint64 now) {
+    qint64 waitA = now - a.enqueuedAt;
+    qint64 waitB = now - b.enqueuedAt;
+    recordWait(waitA);
+    recordWait(waitB);
+    matchesMade.fetch_add(1, std::memory_order_relaxed);
+
+    // Whoever waited longer gets the first move
+    MatchResult match;
+    match.playerX = (waitA >= waitB) ? a.username : b.username;
+    match.playerO = (waitA >= waitB) ? b.username : a.username;
+    match.vsAI = false;
+    match.difficulty = a.difficulty;
+    match.waitMs = qMax(waitA, waitB);
+
+    emit matchFound(match);
+}
+
+void Matchmaker::emitAIMatch(const MatchRequest& request, qint64 now) {
+    qint64 wait = now - request.enqueuedAt;
+    recordWait(wait);
+    matchesMade.fetch_add(1, std::memory_order_relaxed);
+    if (request.mode == MatchMode::TwoPlayer) {
+        aiFallbacks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    MatchResult match;
+    match.playerX = request.username;
+    match.vsAI = true;
+    match.difficulty = request.difficulty;
+    match.waitMs = wait;
+
+    emit matchFound(match);
+}
+
+QVector<qint64> Matchmaker::histogramBounds() {
+    // Upper bounds in milliseconds; the last histogram slot counts everything above
+    return QVector<qint64>{ 10, 50, 100, 500, 1000, 5000, 30000 };
+}
+
+MatchmakerMetrics Matchmaker::getMetrics() const {
+    MatchmakerMetrics metrics;
+
+    for (int i = 0; i < BucketCount; ++i) {
+        metrics.queueDepth += buckets[i].depth.load(std::memory_order_relaxed);
+        metrics.waitingPlayers += buckets[i].waitingCount.load(std::memory_order_relaxed);
+    }
+
+    metrics.matchesMade = matchesMade.load(std::memory_order_relaxed);
+    metrics.aiFallbacks = aiFallbacks.load(std::memory_order_relaxed);
+    metrics.rejected = rejected.load(std::memory_order_relaxed);
+    metrics.playersMatched = playersMatched.load(std::memory_order_relaxed);
+    metrics.maxTimeToMatchMs = maxWaitMs.load(std::memory_order_relaxed);
+    if (metrics.playersMatched > 0) {
+        metrics.averageTimeToMatchMs = static_cast<double>(totalWaitMs.load(std::memory_order_relaxed)) / metrics.playersMatched;
+    }
+
+    for (int i = 0; i < HistogramSize; ++i) {
+        metrics.timeToMatchHistogram.append(histogram[i].load(std::memory_order_relaxed));
+    }
+
+    return metrics;
+}
+
+GameLogic* Matchmaker::createSession(const MatchResult& match, QObject* parent) const {
+    GameLogic* session = new GameLogic(parent);
+    session->setDifficulty(match.difficulty);
+    session->newGame(match.vsAI);
+    return session;
+}
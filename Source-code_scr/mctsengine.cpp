@@ -0,0 +1,422 @@
+// mctsengine.cpp - Monte Carlo tree search for boards too large to solve
+#include "mctsengine.h"
+#include "tracing.h"
+#include <QRandomGenerator>
+#include <QtConcurrent>
+#include <QtMath>
+
+MctsEngine::MctsEngine() : exploration(1.4), maxNodes(1 << 19), deadlineMs(0), countIterations(false), iterationsLeft(0) {
+}
+
+void MctsEngine::setExploration(double c) {
+    exploration = c;
+}
+
+void MctsEngine::setMaxNodesPerTree(int count) {
+    maxNodes = qMax(1, count);
+}
+
+void MctsEngine::reset() {
+    trees.clear();
+}
+
+quint64 MctsEngine::nextRandom(quint64& state) {
+    // xorshift64, one generator per tree so workers never share state
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+quint64 MctsEngine::neighbours(const BoardState& state, quint64 cells) {
+    // Grow the set by one cell in all eight directions, without wrapping rows
+    int n = state.size();
+    quint64 full = (n == 8) ? ~0ULL : ((1ULL << (n * n)) - 1);
+    quint64 leftColumn = 0;
+    for (int row = 0; row < n; ++row) {
+        leftColumn |= 1ULL << (row * n);
+    }
+    quint64 rightColumn = leftColumn << (n - 1);
+
+    quint64 horizontal = cells | ((cells & ~rightColumn) << 1) | ((cells & ~leftColumn) >> 1);
+    quint64 grown = horizontal | (horizontal << n) | (horizontal >> n);
+    return grown & full;
+}
+
+quint64 MctsEngine::candidateMoves(const BoardState& state) {
+    // On big boards only cells within two steps of a stone are worth trying
+    quint64 empty = state.emptyCells();
+    quint64 stones = state.stones(Player::X) | state.stones(Player::O);
+    if (state.size() <= 4 || !stones) {
+        return empty;
+    }
+    quint64 near = neighbours(state, neighbours(state, stones)) & empty;
+    return near ? near : empty;
+}
+
+int MctsEngine::tacticalMove(const BoardState& state) {
+    Player me = state.toMove();
+    Player them = (me == Player::X) ? Player::O : Player::X;
+    quint64 empty = state.emptyCells();
+
+    // Win now if we can, otherwise block the opponent's immediate win
+    int block = -1;
+    for (quint64 cells = empty; cells; cells &= cells - 1) {
+        int cell = qCountTrailingZeroBits(cells);
+        if (state.winsFor(cell, me)) {
+            return cell;
+        }
+        if (block < 0 && state.winsFor(cell, them)) {
+            block = cell;
+        }
+    }
+    return block;
+}
+
+bool MctsEngine::reroot(Tree& tree, const BoardState& newRoot) {
+    const BoardState& oldRoot = tree.root;
+    if (tree.nodes.isEmpty() || oldRoot.size() != newRoot.size() || oldRoot.winLength() != newRoot.winLength()) {
+        return false;
+    }
+
+    int played = newRoot.moveCount() - oldRoot.moveCount();
+    quint64 oldX = oldRoot.stones(Player::X);
+    quint64 oldO = oldRoot.stones(Player::O);
+    quint64 newX = newRoot.stones(Player::X);
+    quint64 newO = newRoot.stones(Player::O);
+    if (played < 0 || played > 2 || (oldX & ~newX) || (oldO & ~newO)) {
+        return false;
+    }
+
+    // Replay the new stones in turn order, starting with the old side to move
+    quint64 first = (oldRoot.toMove() == Player::X) ? (newX & ~oldX) : (newO & ~oldO);
+    quint64 second = (oldRoot.toMove() == Player::X) ? (newO & ~oldO) : (newX & ~oldX);
+    int path[2];
+    int steps = 0;
+    if (played >= 1) {
+        path[steps++] = qCountTrailingZeroBits(first);
+    }
+    if (played == 2) {
+        path[steps++] = qCountTrailingZeroBits(second);
+    }
+
+    int node = 0;
+    for (int i = 0; i < steps; ++i) {
+        const Node& parent = tree.nodes[node];
+        int next = -1;
+        for (int c = 0; c < parent.childCount; ++c) {
+            if (tree.nodes[parent.firstChild + c].cell == path[i]) {
+                next = parent.firstChild + c;
+                break;
+            }
+        }
+        if (next < 0) {
+            return false;
+        }
+        node = next;
+    }
+
+    // Copy the surviving subtree into a fresh arena, breadth first so that
+    // every node's children stay contiguous
+    if (node != 0) {
+        QVector<Node> fresh;
+        fresh.reserve(tree.nodes.size());
+        fresh.append(tree.nodes[node]);
+        QVector<QPair<int, int>> queue;
+        queue.append(qMakePair(node, 0));
+        for (int head = 0; head < queue.size(); ++head) {
+            int oldIndex = queue[head].first;
+            int newIndex = queue[head].second;
+            const Node& source = tree.nodes[oldIndex];
+            if (source.firstChild < 0) {
+                continue;
+            }
+            int newFirst = fresh.size();
+            for (int c = 0; c < source.childCount; ++c) {
+                fresh.append(tree.nodes[source.firstChild + c]);
+                queue.append(qMakePair(source.firstChild + c, newFirst + c));
+            }
+            fresh[newIndex].firstChild = newFirst;
+        }
+        tree.nodes = fresh;
+    }
+
+    tree.root = newRoot;
+    return true;
+}
+
+MctsResult MctsEngine::search(const BoardState& root, const MctsLimits& limits) {
+    TRACE_SCOPE("MctsEngine::search");
+    MctsResult result;
+    timer.start();
+
+    if (root.emptyCells() == 0 || root.findWinner() != Player::None) {
+        return result;
+    }
+
+    int tactical = tacticalMove(root);
+    if (tactical >= 0) {
+        result.cell = tactical;
+        result.tactical = true;
+        result.elapsedMs = timer.elapsed();
+        return result;
+    }
+
+    // Keep one tree per thread, re-rooting old trees where possible
+    int threadCount = qMax(1, limits.threads);
+    trees.resize(threadCount);
+    for (int i = 0; i < threadCount; ++i) {
+        Tree& tree = trees[i];
+        if (reroot(tree, root)) {
+            result.reusedTrees++;
+        } else {
+            tree.nodes.clear();
+            tree.nodes.reserve(qMin(maxNodes, 4096));
+            tree.nodes.append(Node());
+            tree.root = root;
+        }
+        tree.iterations = 0;
+        tree.rng = QRandomGenerator::global()->generate64() | 1;
+    }
+
+    // Without any budget fall back to a fixed number of playouts
+    int iterations = limits.iterations;
+    if (iterations <= 0 && limits.timeBudgetMs <= 0) {
+        iterations = 20000;
+    }
+    countIterations = iterations > 0;
+    iterationsLeft.store(iterations);
+    deadlineMs = limits.timeBudgetMs;
+
+    // Root parallelism: every tree is searched on its own thread
+    QVector<int> workers;
+    for (int i = 0; i < threadCount; ++i) {
+        workers.append(i);
+    }
+    Tree* treeData = trees.data();
+    if (threadCount == 1) {
+        runWorker(treeData[0]);
+    } else {
+        QtConcurrent::blockingMap(workers, [this, treeData](const int& index) {
+            runWorker(treeData[index]);
+        });
+    }
+
+    // Merge the root statistics of all trees and pick the most visited move
+    qint64 visits[MaxCells] = {};
+    double scores[MaxCells] = {};
+    for (const Tree& tree : trees) {
+        result.iterations += tree.iterations;
+        result.treeNodes += tree.nodes.size();
+        const Node& rootNode = tree.nodes[0];
+        for (int c = 0; c < rootNode.childCount; ++c) {
+            const Node& child = tree.nodes[rootNode.firstChild + c];
+            visits[child.cell] += child.visits;
+            scores[child.cell] += child.score;
+        }
+    }
+    for (int cell = 0; cell < root.cellCount(); ++cell) {
+        if (visits[cell] > 0) {
+            MctsMove move;
+            move.cell = cell;
+            move.visits = visits[cell];
+            move.winRate = scores[cell] / visits[cell];
+            result.moves.append(move);
+        }
+        if ((root.emptyCells() & (1ULL << cell)) && (result.cell < 0 || visits[cell] > result.visits)) {
+            result.cell = cell;
+            result.visits = visits[cell];
+        }
+    }
+    if (result.visits > 0) {
+        result.winRate = scores[result.cell] / result.visits;
+    }
+
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+void MctsEngine::runWorker(Tree& tree) {
+    for (;;) {
+        // Claim one iteration from the shared budget, unless only time limits us
+        if (countIterations && iterationsLeft.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+            break;
+        }
+        if (deadlineMs > 0 && (tree.iterations & 63) == 0 && timer.elapsed() >= deadlineMs) {
+            break;
+        }
+        iterate(tree);
+        ++tree.iterations;
+    }
+}
+
+void MctsEngine::expand(Tree& tree, int node, const BoardState& state) {
+    quint64 empty = candidateMoves(state);
+    int count = qPopulationCount(empty);
+    if (count == 0 || tree.nodes.size() + count > maxNodes) {
+        return; // Arena full, keep playing out from the leaf
+    }
+
+    int first = tree.nodes.size();
+    Player mover = state.toMove();
+    bool fills = (qPopulationCount(state.emptyCells()) == 1);
+    for (quint64 cells = empty; cells; cells &= cells - 1) {
+        int cell = qCountTrailingZeroBits(cells);
+        Node child;
+        child.cell = static_cast<qint8>(cell);
+        if (state.winsFor(cell, mover)) {
+            child.terminal = 1;
+        } else if (fills) {
+            child.terminal = 2;
+        }
+        tree.nodes.append(child);
+    }
+    tree.nodes[node].firstChild = first;
+    tree.nodes[node].childCount = static_cast<qint16>(count);
+}
+
+int MctsEngine::selectChild(const Tree& tree, int node) const {
+    const Node& parent = tree.nodes[node];
+    double logVisits = qLn(qMax(1, parent.visits));
+    int best = parent.firstChild;
+    double bestValue = -1.0;
+
+    for (int c = 0; c < parent.childCount; ++c) {
+        int index = parent.firstChild + c;
+        const Node& child = tree.nodes[index];
+        if (child.terminal == 1) {
+            return index; // A winning move needs no statistics
+        }
+
+        if (child.visits == 0) {
+            return index; // Try every move once before trusting the averages
+        }
+        double value = child.score / child.visits + exploration * qSqrt(logVisits / child.visits);
+        if (value > bestValue) {
+            bestValue = value;
+            best = index;
+        }
+    }
+    return best;
+}
+
+int MctsEngine::lineWin(const BoardState& state, int anchor, Player player) {
+    if (anchor < 0) {
+        return -1;
+    }
+
+    // A new winning cell can only appear on a line through the player's last stone
+    int n = state.size();
+    int reach = state.winLength() - 1;
+    int row = anchor / n;
+    int col = anchor % n;
+    quint64 empty = state.emptyCells();
+    const int directions[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+    for (const auto& d : directions) {
+        for (int step = -reach; step <= reach; ++step) {
+            int r = row + step * d[0];
+            int c = col + step * d[1];
+            if (step == 0 || r < 0 || r >= n || c < 0 || c >= n) {
+                continue;
+            }
+            int cell = r * n + c;
+            if ((empty & (1ULL << cell)) && state.winsFor(cell, player)) {
+                return cell;
+            }
+        }
+    }
+    return -1;
+}
+
+Player MctsEngine::playout(BoardState& state, int lastMine, int lastTheirs, quint64& rng) const {
+    for (;;) {
+        quint64 empty = state.emptyCells();
+        if (!empty) {
+            return Player::None;
+        }
+
+        // Take a win, else block one, else play a random empty cell
+        Player mover = state.toMove();
+        Player other = (mover == Player::X) ? Player::O : Player::X;
+        int cell = lineWin(state, lastMine, mover);
+        if (cell < 0) {
+            cell = lineWin(state, lastTheirs, other);
+        }
+        if (cell < 0) {
+            quint64 stones = state.stones(Player::X) | state.stones(Player::O);
+            quint64 near = neighbours(state, stones) & empty;
+            if (near && state.size() > 4) {
+                empty = near;
+            }
+            int skip = static_cast<int>(nextRandom(rng) % quint64(qPopulationCount(empty)));
+            for (int i = 0; i < skip; ++i) {
+                empty &= empty - 1;
+            }
+            cell = qCountTrailingZeroBits(empty);
+        }
+
+        state.play(cell);
+        if (state.wins(cell)) {
+            return mover;
+        }
+        lastMine = lastTheirs;
+        lastTheirs = cell;
+    }
+}
+
+void MctsEngine::iterate(Tree& tree) {
+    BoardState state = tree.root;
+    Player rootMover = state.toMove();
+    int path[MaxCells + 1];
+    int depth = 0;
+    int node = 0;
+    path[depth++] = node;
+
+    // Selection and expansion
+    Player winner = Player::None;
+    bool finished = false;
+    for (;;) {
+        const Node& current = tree.nodes[node];
+        if (current.terminal) {
+            // The player who made this move either won or filled the board
+            Player mover = (depth % 2 == 0) ? rootMover : (rootMover == Player::X ? Player::O : Player::X);
+            winner = (current.terminal == 1) ? mover : Player::None;
+            finished = true;
+            break;
+        }
+        if (current.firstChild < 0) {
+            if (current.visits == 0) {
+                break;
+            }
+            expand(tree, node, state);
+            if (tree.nodes[node].firstChild < 0) {
+                break;
+            }
+        }
+        node = selectChild(tree, node);
+        state.play(tree.nodes[node].cell);
+        path[depth++] = node;
+    }
+
+    // Simulation, seeded with the last stone of each side
+    if (!finished) {
+        int lastTheirs = (depth > 1) ? tree.nodes[path[depth - 1]].cell : -1;
+        int lastMine = (depth > 2) ? tree.nodes[path[depth - 2]].cell : -1;
+        winner = playout(state, lastMine, lastTheirs, tree.rng);
+    }
+
+    // Backpropagation, scored for the player who made each move
+    for (int i = 0; i < depth; ++i) {
+        Node& visited = tree.nodes[path[i]];
+        visited.visits++;
+        if (i == 0) {
+            continue;
+        }
+        Player mover = (i % 2 == 1) ? rootMover : (rootMover == Player::X ? Player::O : Player::X);
+        if (winner == mover) {
+            visited.score += 1.0f;
+        } else if (winner == Player::None) {
+            visited.score += 0.5f;
+        }
+    }
+}
@@ -0,0 +1,267 @@
+// metrics.cpp - Runtime counters, gauges and histograms in Prometheus text format
+#include "metrics.h"
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+std::atomic<bool> Metrics::enabled(false);
+
+namespace {
+const double HistogramBounds[Histogram::Bounds] = {
+    0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+};
+
+struct Registry {
+    QMutex mutex;
+    QVector<Metric*> metrics;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+QString formatValue(double value) {
+    return QString::number(value, 'g', 12);
+}
+
+QString escapeLabel(QString value) {
+    return value.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+}
+}
+
+namespace AppMetrics {
+Counter gamesStarted[2] = {
+    Counter("tictactoe_games_started_total", "Games started from the game mode page.", "mode=\"pvp\""),
+    Counter("tictactoe_games_started_total", "Games started from the game mode page.", "mode=\"ai\"")
+};
+Counter gamesFinished[3] = {
+    Counter("tictactoe_games_finished_total", "Games played to a result.", "result=\"x_wins\""),
+    Counter("tictactoe_games_finished_total", "Games played to a result.", "result=\"o_wins\""),
+    Counter("tictactoe_games_finished_total", "Games played to a result.", "result=\"tie\"")
+};
+Histogram aiMoveSeconds[4] = {
+    Histogram("tictactoe_ai_move_seconds", "Time the AI took to choose a move.", "difficulty=\"easy\""),
+    Histogram("tictactoe_ai_move_seconds", "Time the AI took to choose a move.", "difficulty=\"medium\""),
+    Histogram("tictactoe_ai_move_seconds", "Time the AI took to choose a move.", "difficulty=\"hard\""),
+    Histogram("tictactoe_ai_move_seconds", "Time the AI took to choose a move.", "difficulty=\"unbeatable\"")
+};
+Histogram usersSaveSeconds("tictactoe_users_save_seconds", "Time taken to write users.json.");
+Counter usersSaveBytes("tictactoe_users_save_bytes_total", "Bytes written to users.json.");
+Histogram signInSeconds("tictactoe_sign_in_seconds", "Time taken to check a sign-in, waiting for users.json included.");
+LabeledGauge historyGames("tictactoe_history_games", "Games in each signed-in user's history.", "user");
+}
+
+void Metrics::setEnabled(bool on) {
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+int Metrics::shardIndex() {
+    // Threads take shards in turn as they first update a metric
+    static std::atomic<int> nextShard(0);
+    thread_local int shard = nextShard.fetch_add(1, std::memory_order_relaxed) % Shards;
+    return shard;
+}
+
+void Metrics::add(Metric* metric) {
+    Registry& reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    reg.metrics.append(metric);
+}
+
+void Metrics::remove(Metric* metric) {
+    Registry& reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    reg.metrics.removeOne(metric);
+}
+
+QString Metrics::prometheusText() {
+    Registry& reg = registry();
+    QMutexLocker locker(&reg.mutex);
+
+    // Series of one name are written together, under a single HELP and TYPE
+    QVector<Metric*> sorted = reg.metrics;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Metric* a, const Metric* b) {
+        return std::strcmp(a->name(), b->name()) < 0;
+    });
+
+    static const char* typeNames[] = {"counter", "gauge", "histogram"};
+    QString out;
+    const char* family = nullptr;
+    for (const Metric* metric : std::as_const(sorted)) {
+        if (!family || std::strcmp(family, metric->name()) != 0) {
+            family = metric->name();
+            out += QString("# HELP %1 %2\n").arg(family, metric->help());
+            out += QString("# TYPE %1 %2\n").arg(family, typeNames[metric->type()]);
+        }
+        metric->writeSamples(out);
+    }
+    return out;
+}
+
+bool Metrics::writePrometheus(const QString& path) {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(prometheusText().toUtf8());
+    return file.commit();
+}
+
+void Metrics::reset() {
+    Registry& reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (Metric* metric : std::as_const(reg.metrics)) {
+        metric->reset();
+    }
+}
+
+Metric::Metric(Type type, const char* name, const char* help, const char* labels) : metricType(type),
+metricName(name), metricHelp(help), metricLabels(labels) {
+    Metrics::add(this);
+}
+
+Metric::~Metric() {
+    Metrics::remove(this);
+}
+
+Metric::Type Metric::type() const {
+    return metricType;
+}
+
+const char* Metric::name() const {
+    return metricName;
+}
+
+const char* Metric::help() const {
+    return metricHelp;
+}
+
+QString Metric::series(const char* suffix, const QString& extraLabel) const {
+    QString labels = QString::fromLatin1(metricLabels);
+    if (!extraLabel.isEmpty()) {
+        labels = labels.isEmpty() ? extraLabel : labels + "," + extraLabel;
+    }
+    QString name = QString::fromLatin1(metricName) + suffix;
+    return labels.isEmpty() ? name : QString("%1{%2}").arg(name, labels);
+}
+
+Counter::Counter(const char* name, const char* help, const char* labels) : Metric(CounterType, name, help, labels) {
+}
+
+qint64 Counter::value() const {
+    qint64 total = 0;
+    for (const Shard& shard : shards) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Counter::writeSamples(QString& out) const {
+    out += QString("%1 %2\n").arg(series("")).arg(value());
+}
+
+void Counter::reset() {
+    for (Shard& shard : shards) {
+        shard.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+Histogram::Shard::Shard() : sumNs(0) {
+    for (std::atomic<qint64>& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+Histogram::Histogram(const char* name, const char* help, const char* labels) : Metric(HistogramType, name, help, labels) {
+}
+
+double Histogram::bound(int bucket) {
+    return HistogramBounds[bucket];
+}
+
+void Histogram::record(qint64 nsecs) {
+    double seconds = nsecs / 1e9;
+    int bucket = std::lower_bound(HistogramBounds, HistogramBounds + Bounds, seconds) - HistogramBounds;
+    Shard& shard = shards[Metrics::shardIndex()];
+    shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.sumNs.fetch_add(nsecs, std::memory_order_relaxed);
+}
+
+qint64 Histogram::count() const {
+    qint64 total = 0;
+    for (const Shard& shard : shards) {
+        for (const std::atomic<qint64>& bucket : shard.buckets) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+double Histogram::sumSeconds() const {
+    qint64 total = 0;
+    for (const Shard& shard : shards) {
+        total += shard.sumNs.load(std::memory_order_relaxed);
+    }
+    return total / 1e9;
+}
+
+void Histogram::writeSamples(QString& out) const {
+    qint64 counts[Bounds + 1] = {};
+    for (const Shard& shard : shards) {
+        for (int bucket = 0; bucket <= Bounds; ++bucket) {
+            counts[bucket] += shard.buckets[bucket].load(std::memory_order_relaxed);
+        }
+    }
+
+    // Prometheus buckets are cumulative
+    qint64 cumulative = 0;
+    for (int bucket = 0; bucket <= Bounds; ++bucket) {
+        cumulative += counts[bucket];
+        QString le = bucket < Bounds ? formatValue(HistogramBounds[bucket]) : QString("+Inf");
+        out += QString("%1 %2\n").arg(series("_bucket", QString("le=\"%1\"").arg(le))).arg(cumulative);
+    }
+    out += QString("%1 %2\n").arg(series("_sum"), formatValue(sumSeconds()));
+    out += QString("%1 %2\n").arg(series("_count")).arg(cumulative);
+}
+
+void Histogram::reset() {
+    for (Shard& shard : shards) {
+        for (std::atomic<qint64>& bucket : shard.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        shard.sumNs.store(0, std::memory_order_relaxed);
+    }
+}
+
+LabeledGauge::LabeledGauge(const char* name, const char* help, const char* label) : Metric(GaugeType, name, help, ""),
+labelName(label) {
+}
+
+void LabeledGauge::set(const QString& label, double value) {
+    if (!Metrics::isEnabled()) {
+        return;
+    }
+    QMutexLocker locker(&mutex);
+    values[label] = value;
+}
+
+double LabeledGauge::value(const QString& label) const {
+    QMutexLocker locker(&mutex);
+    return values.value(label);
+}
+
+void LabeledGauge::writeSamples(QString& out) const {
+    QMutexLocker locker(&mutex);
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        QString label = QString("%1=\"%2\"").arg(QString::fromLatin1(labelName), escapeLabel(it.key()));
+        out += QString("%1 %2\n").arg(series("", label), formatValue(it.value()));
+    }
+}
+
+void LabeledGauge::reset() {
+    QMutexLocker locker(&mutex);
+    values.clear();
+}
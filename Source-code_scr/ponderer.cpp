@@ -0,0 +1,106 @@
+// ponderer.cpp - Background search during the opponent's turn
+#include "ponderer.h"
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include <algorithm>
+
+Ponderer::Ponderer() : stopRequested(false), predicted(-1) {
+    engine.setStopFlag(&stopRequested);
+}
+
+Ponderer::~Ponderer() {
+    stop();
+}
+
+void Ponderer::setTablebase(const Tablebase* tablebase) {
+    engine.setTablebase(tablebase);
+}
+
+void Ponderer::start(const BoardState& position, const SearchLimits& limits, int predictedReply) {
+    stop();
+    if (position.hash() != root.hash() || position.size() != root.size() || position.winLength() != root.winLength()) {
+        clear();
+    }
+    root = position;
+    rootLimits = limits;
+    predicted = predictedReply;
+    worker = QtConcurrent::run([this]() { run(); });
+}
+
+void Ponderer::stop() {
+    stopRequested.store(true);
+    worker.waitForFinished();
+    stopRequested.store(false);
+}
+
+void Ponderer::clear() {
+    QMutexLocker locker(&mutex);
+    results.clear();
+}
+
+void Ponderer::waitForFinished() {
+    worker.waitForFinished();
+}
+
+bool Ponderer::isRunning() const {
+    return worker.isRunning();
+}
+
+int Ponderer::cachedReplies() const {
+    QMutexLocker locker(&mutex);
+    return results.size();
+}
+
+bool Ponderer::take(const BoardState& position, SearchResult* result) {
+    stop();
+    QMutexLocker locker(&mutex);
+    auto found = results.constFind(position.hash());
+    bool hit = (found != results.constEnd());
+    if (hit) {
+        *result = found.value();
+    }
+    results.clear();
+    return hit;
+}
+
+void Ponderer::run() {
+    // A shallow full-window search ranks the replies, the predicted one goes first
+    SearchLimits ranking;
+    ranking.maxDepth = 2;
+    ranking.scoreAllMoves = true;
+    QVector<RootScore> replies = engine.search(root, ranking).rootScores;
+    std::stable_sort(replies.begin(), replies.end(), [](const RootScore& a, const RootScore& b) {
+        return a.score > b.score;
+    });
+    for (int i = 1; i < replies.size(); ++i) {
+        if (replies[i].cell == predicted) {
+            std::rotate(replies.begin(), replies.begin() + i, replies.begin() + i + 1);
+        }
+    }
+
+    for (const RootScore& reply : replies) {
+        if (stopRequested.load()) {
+            return;
+        }
+
+        // Replies that end the game leave nothing to answer
+        BoardState next = root;
+        next.play(reply.cell);
+        if (next.wins(reply.cell) || next.isFull()) {
+            continue;
+        }
+        {
+            QMutexLocker locker(&mutex);
+            if (results.contains(next.hash())) {
+                continue;
+            }
+        }
+
+        SearchResult result = engine.search(next, rootLimits);
+        if (stopRequested.load()) {
+            return; // Cut short, not worth keeping
+        }
+        QMutexLocker locker(&mutex);
+        results.insert(next.hash(), result);
+    }
+}
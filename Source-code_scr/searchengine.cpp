@@ -0,0 +1,395 @@
+// searchengine.cpp - Time-budgeted iterative-deepening alpha-beta search
+#include "searchengine.h"
+#include "tracing.h"
+
+namespace {
+const int Infinity = SearchEngine::WinScore + 1;
+const int HeuristicLimit = SearchEngine::WinScore / 2;
+const qint8 SolvedDepth = 127;
+
+// Win scores are stored relative to the node so they stay valid at any ply
+int toTable(int score, int ply) {
+    if (SearchEngine::isWinScore(score)) {
+        return score > 0 ? score + ply : score - ply;
+    }
+    return score;
+}
+
+int fromTable(int score, int ply) {
+    if (SearchEngine::isWinScore(score)) {
+        return score > 0 ? score - ply : score + ply;
+    }
+    return score;
+}
+}
+
+SearchEngine::SearchEngine() : table(1 << TableBits), tableSize(0), tableWinLength(0),
+orderingFlags(OrderAll), endgame(nullptr), stopFlag(nullptr), deadlineMs(0), aborted(false), hitHorizon(false) {
+    clearTables();
+}
+
+void SearchEngine::setMoveOrdering(int flags) {
+    orderingFlags = flags;
+}
+
+int SearchEngine::moveOrdering() const {
+    return orderingFlags;
+}
+
+void SearchEngine::setTablebase(const Tablebase* tablebase) {
+    endgame = tablebase;
+}
+
+void SearchEngine::setStopFlag(const std::atomic<bool>* flag) {
+    stopFlag = flag;
+}
+
+void SearchEngine::clearTables() {
+    table.fill(TTEntry());
+    for (int side = 0; side < 2; ++side) {
+        for (int cell = 0; cell < MaxCells; ++cell) {
+            history[side][cell] = 0;
+        }
+    }
+    for (int ply = 0; ply <= MaxCells; ++ply) {
+        killers[ply][0] = -1;
+        killers[ply][1] = -1;
+    }
+    tableSize = 0;
+    tableWinLength = 0;
+}
+
+void SearchEngine::prepareTables(const BoardState& root) {
+    // Hashes do not encode the board shape, so a new shape starts clean
+    if (root.size() != tableSize || root.winLength() != tableWinLength) {
+        clearTables();
+        tableSize = root.size();
+        tableWinLength = root.winLength();
+
+        // Static prior: how many winning windows pass through each cell
+        for (int cell = 0; cell < MaxCells; ++cell) {
+            prior[cell] = 0;
+        }
+        for (quint64 window : BoardState::windows(root.size(), root.winLength())) {
+            for (int cell = 0; cell < root.cellCount(); ++cell) {
+                if (window & (1ULL << cell)) {
+                    prior[cell]++;
+                }
+            }
+        }
+    }
+
+    // Killers only make sense within one search; history fades so old cutoffs give way
+    for (int ply = 0; ply <= MaxCells; ++ply) {
+        killers[ply][0] = -1;
+        killers[ply][1] = -1;
+    }
+    for (int side = 0; side < 2; ++side) {
+        for (int cell = 0; cell < MaxCells; ++cell) {
+            history[side][cell] /= 2;
+        }
+    }
+}
+
+int SearchEngine::evaluate(const BoardState& state) {
+    // Windows still open for one side score by the cube of their stones
+    quint64 x = state.stones(Player::X);
+    quint64 o = state.stones(Player::O);
+    int score = 0;
+    for (quint64 window : BoardState::windows(state.size(), state.winLength())) {
+        bool hasX = x & window;
+        bool hasO = o & window;
+        if (hasX == hasO) {
+            continue;
+        }
+        int count = qPopulationCount(hasX ? (x & window) : (o & window));
+        int weight = count * count * count;
+        score += hasX ? weight : -weight;
+    }
+
+    score = qBound(-HeuristicLimit, score, HeuristicLimit);
+    return (state.toMove() == Player::X) ? score : -score;
+}
+
+bool SearchEngine::outOfTime() {
+    if (stopFlag && stopFlag->load(std::memory_order_relaxed)) {
+        return true;
+    }
+    return deadlineMs > 0 && timer.elapsed() >= deadlineMs;
+}
+
+SearchResult SearchEngine::search(const BoardState& root, const SearchLimits& limits) {
+    TRACE_SCOPE("SearchEngine::search");
+    SearchResult result;
+    timer.start();
+    stats = SearchStats();
+
+    int emptyCount = qPopulationCount(root.emptyCells());
+    if (emptyCount == 0) {
+        return result;
+    }
+
+    prepareTables(root);
+    int maxDepth = (limits.maxDepth > 0) ? qMin(limits.maxDepth, emptyCount) : emptyCount;
+    BoardState state = root;
+
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        // The first iteration ignores the deadline so there is always a move
+        deadlineMs = (depth > 1) ? limits.timeBudgetMs : 0;
+        aborted = false;
+        hitHorizon = false;
+
+        int bestCell = -1;
+        int score = rootSearch(state, depth, result.cell, limits.scoreAllMoves, &bestCell);
+        if (aborted) {
+            result.timedOut = true;
+            break;
+        }
+
+        result.cell = bestCell;
+        result.score = score;
+        result.depthCompleted = depth;
+        result.rootScores = iterationScores;
+
+        // Read the line back now, before a deeper iteration overwrites the table
+        result.principalVariation = principalVariation(root, bestCell, depth);
+
+        // Nothing left to learn once the tree is solved or a forced result is known,
+        // unless the other root moves still need their own scores
+        if (!hitHorizon || (isWinScore(score) && !limits.scoreAllMoves)) {
+            result.exact = true;
+            break;
+        }
+    }
+
+    result.stats = stats;
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+QVector<int> SearchEngine::principalVariation(const BoardState& root, int cell, int maxLength) const {
+    // Follow the stored best moves; entries may have been replaced, so check each one
+    QVector<int> line;
+    BoardState state = root;
+    while (cell >= 0 && line.size() < maxLength && (state.emptyCells() & (1ULL << cell))) {
+        line.append(cell);
+        state.play(cell);
+        if (state.wins(cell) || state.isFull()) {
+            break;
+        }
+        const TTEntry& entry = table[state.hash() & ((1 << TableBits) - 1)];
+        cell = (entry.key == state.hash()) ? entry.bestCell : -1;
+    }
+    return line;
+}
+
+int SearchEngine::orderMoves(const BoardState& state, int ply, int ttCell, int* moves) const {
+    int scores[MaxCells];
+    int count = 0;
+    int side = (state.toMove() == Player::X) ? 0 : 1;
+    quint64 empty = state.emptyCells();
+
+    for (int cell = 0; cell < state.cellCount(); ++cell) {
+        if (!(empty & (1ULL << cell))) {
+            continue;
+        }
+
+        int score = 0;
+        if ((orderingFlags & OrderTTMove) && cell == ttCell) {
+            score = 1 << 30;
+        } else if ((orderingFlags & OrderKillers) && cell == killers[ply][0]) {
+            score = 1 << 29;
+        } else if ((orderingFlags & OrderKillers) && cell == killers[ply][1]) {
+            score = 1 << 28;
+        } else {
+            if (orderingFlags & OrderHistory) {
+                score += history[side][cell] * 8;
+            }
+            if (orderingFlags & OrderStaticPrior) {
+                score += prior[cell];
+            }
+        }
+
+        // Insertion sort, stable so equal scores keep board order
+        int i = count++;
+        while (i > 0 && scores[i - 1] < score) {
+            scores[i] = scores[i - 1];
+            moves[i] = moves[i - 1];
+            --i;
+        }
+        scores[i] = score;
+        moves[i] = cell;
+    }
+    return count;
+}
+
+void SearchEngine::recordCutoff(const BoardState& state, int cell, int depth, int ply) {
+    if (killers[ply][0] != cell) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = cell;
+    }
+    // Saturates, so however long a session runs the score cannot overflow
+    int side = (state.toMove() == Player::X) ? 0 : 1;
+    history[side][cell] = qMin(history[side][cell] + depth * depth, int(HistoryLimit));
+}
+
+int SearchEngine::rootSearch(BoardState& state, int depth, int preferredCell, bool scoreAll, int* bestCell) {
+    TRACE_SCOPE("SearchEngine::rootSearch"); // One span per iteration
+    // Previous iteration's best move always goes first at the root
+    int moves[MaxCells];
+    int count = orderMoves(state, 0, preferredCell, moves);
+    if (preferredCell >= 0 && !(orderingFlags & OrderTTMove)) {
+        for (int i = 0; i < count; ++i) {
+            if (moves[i] == preferredCell) {
+                qSwap(moves[0], moves[i]);
+                break;
+            }
+        }
+    }
+
+    int alpha = -Infinity;
+    *bestCell = moves[0];
+    iterationScores.clear();
+    for (int i = 0; i < count; ++i) {
+        int cell = moves[i];
+        state.play(cell);
+        int score;
+        if (state.wins(cell)) {
+            score = WinScore - 1;
+        } else {
+            // Siblings share the table, so a full window mostly costs re-probes
+            int window = scoreAll ? -Infinity : alpha;
+            score = -negamax(state, depth - 1, 1, -Infinity, -window);
+        }
+        state.undo(cell);
+
+        if (aborted) {
+            return 0;
+        }
+
+        // Moves that fail low only have an upper bound
+        RootScore rootScore;
+        rootScore.cell = cell;
+        rootScore.score = score;
+        rootScore.upperBound = !scoreAll && score <= alpha;
+        iterationScores.append(rootScore);
+
+        if (score > alpha) {
+            alpha = score;
+            *bestCell = cell;
+        }
+    }
+    return alpha;
+}
+
+int SearchEngine::negamax(BoardState& state, int depth, int ply, int alpha, int beta) {
+    ++stats.nodes;
+    if ((stats.nodes & 1023) == 0 && outOfTime()) {
+        aborted = true;
+    }
+    if (aborted) {
+        return 0;
+    }
+
+    if (state.isFull()) {
+        return 0; // Tie, wins are caught when the move is played
+    }
+
+    // A covered position is solved, whatever depth is left
+    if (endgame && endgame->covers(state)) {
+        TablebaseEntry known = endgame->probe(state);
+        if (known.isValid()) {
+            ++stats.tablebaseHits;
+            if (known.result == TablebaseEntry::Draw) {
+                return 0;
+            }
+            int score = WinScore - (ply + known.distance);
+            return (known.result == TablebaseEntry::Win) ? score : -score;
+        }
+    }
+
+    if (depth == 0) {
+        hitHorizon = true;
+        return evaluate(state);
+    }
+
+    // Probe the transposition table
+    TTEntry& entry = table[state.hash() & ((1 << TableBits) - 1)];
+    int ttCell = -1;
+    if (entry.key == state.hash()) {
+        ttCell = entry.bestCell;
+        if (entry.depth >= depth) {
+            int score = fromTable(entry.score, ply);
+            if (entry.bound == BoundExact ||
+                (entry.bound == BoundLower && score >= beta) ||
+                (entry.bound == BoundUpper && score <= alpha)) {
+                ++stats.ttHits;
+                if (entry.depth != SolvedDepth) {
+                    hitHorizon = true;
+                }
+                return score;
+            }
+        }
+    }
+
+    // Track whether this subtree reaches the horizon on its own
+    bool outerHorizon = hitHorizon;
+    hitHorizon = false;
+
+    int moves[MaxCells];
+    int count = orderMoves(state, ply, ttCell, moves);
+    int originalAlpha = alpha;
+    int best = -Infinity;
+    int bestCell = moves[0];
+
+    for (int i = 0; i < count; ++i) {
+        int cell = moves[i];
+        state.play(cell);
+        int score;
+        if (state.wins(cell)) {
+            score = WinScore - (ply + 1); // Faster wins score higher
+        } else {
+            score = -negamax(state, depth - 1, ply + 1, -beta, -alpha);
+        }
+        state.undo(cell);
+
+        if (aborted) {
+            return 0;
+        }
+        if (score > best) {
+            best = score;
+            bestCell = cell;
+        }
+        if (best > alpha) {
+            alpha = best;
+        }
+        if (alpha >= beta) {
+            ++stats.cutoffs;
+            if (i == 0) {
+                ++stats.firstMoveCutoffs;
+            }
+            recordCutoff(state, cell, depth, ply);
+            break;
+        }
+    }
+
+    // Store the result, replacing shallower entries
+    bool subtreeHorizon = hitHorizon;
+    hitHorizon = outerHorizon || subtreeHorizon;
+    qint8 storedDepth = subtreeHorizon ? static_cast<qint8>(depth) : SolvedDepth;
+    if (entry.key != state.hash() || storedDepth >= entry.depth) {
+        entry.key = state.hash();
+        entry.score = toTable(best, ply);
+        entry.depth = storedDepth;
+        entry.bestCell = static_cast<qint8>(bestCell);
+        if (best <= originalAlpha) {
+            entry.bound = BoundUpper;
+        } else if (best >= beta) {
+            entry.bound = BoundLower;
+        } else {
+            entry.bound = BoundExact;
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,61 @@
+// startuptimings.cpp - Cold-start phase timings, printed with --startup-timings
+#include "startuptimings.h"
+#include <QStringList>
+
+StartupTimings::StartupTimings() {
+    clock.start();
+    for (int phase = 0; phase < PhaseCount; ++phase) {
+        stamps[phase] = -1;
+    }
+    stamps[MainEntered] = 0;
+}
+
+void StartupTimings::mark(Phase phase) {
+    if (phase < 0 || phase >= PhaseCount || stamps[phase] >= 0) {
+        return;
+    }
+    stamps[phase] = clock.nsecsElapsed();
+}
+
+bool StartupTimings::reached(Phase phase) const {
+    return phase >= 0 && phase < PhaseCount && stamps[phase] >= 0;
+}
+
+qint64 StartupTimings::elapsedNs(Phase phase) const {
+    return reached(phase) ? stamps[phase] : -1;
+}
+
+QString StartupTimings::phaseName(Phase phase) {
+    switch (phase) {
+    case MainEntered:
+        return "main";
+    case AppCreated:
+        return "application";
+    case WindowBuilt:
+        return "window built";
+    case FirstPaint:
+        return "first paint";
+    case Interactive:
+        return "interactive";
+    default:
+        return QString();
+    }
+}
+
+QString StartupTimings::report() const {
+    QStringList lines;
+    lines << "Startup timings (ms since main):";
+    qint64 previous = 0;
+    for (int phase = 0; phase < PhaseCount; ++phase) {
+        if (stamps[phase] < 0) {
+            lines << QString("  %1  not reached").arg(phaseName(static_cast<Phase>(phase)), -13);
+            continue;
+        }
+        lines << QString("  %1 %2  (+%3)")
+                     .arg(phaseName(static_cast<Phase>(phase)), -13)
+                     .arg(stamps[phase] / 1000000.0, 8, 'f', 2)
+                     .arg((stamps[phase] - previous) / 1000000.0, 0, 'f', 2);
+        previous = stamps[phase];
+    }
+    return lines.join('\n');
+}
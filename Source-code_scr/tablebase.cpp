@@ -0,0 +1,243 @@
+// tablebase.cpp - Memory-mapped endgame tablebase for N x N, k-in-a-row boards
+#include "tablebase.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+struct BinomialTable {
+    quint64 values[65][65];
+
+    BinomialTable() {
+        for (int n = 0; n <= 64; ++n) {
+            values[n][0] = 1;
+            for (int k = 1; k <= 64; ++k) {
+                values[n][k] = (n == 0) ? 0 : values[n - 1][k - 1] + values[n - 1][k];
+            }
+        }
+    }
+};
+}
+
+Tablebase::Tablebase() : data(nullptr), boardSize(0), boardWinLength(0), completeLayers(0) {
+}
+
+Tablebase::~Tablebase() {
+    close();
+}
+
+bool Tablebase::open(const QString& path) {
+    close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < headerSize(0)) {
+        file.close();
+        return false;
+    }
+
+    // The whole table is mapped, pages are only read when a probe touches them
+    const uchar* mapped = file.map(0, file.size());
+    if (!mapped || memcmp(mapped, "TTTB", 4) != 0 || mapped[4] != Version) {
+        close();
+        return false;
+    }
+
+    int size = mapped[5];
+    int length = mapped[6];
+    int maxEmpty = mapped[7];
+    int layers = mapped[8];
+    if (size < 1 || size > BoardState::MaxSize || length < 1 || length > size ||
+        maxEmpty > MaxEmpty || layers > maxEmpty + 1 || file.size() < headerSize(maxEmpty)) {
+        close();
+        return false;
+    }
+
+    offsets.resize(maxEmpty + 1);
+    for (int empty = 0; empty <= maxEmpty; ++empty) {
+        offsets[empty] = qFromLittleEndian<quint64>(mapped + 16 + empty * 8);
+    }
+
+    // Never trust a completed layer that does not fit in the file
+    for (int empty = 0; empty < layers; ++empty) {
+        if (offsets[empty] + layerSize(size * size, empty) > static_cast<quint64>(file.size())) {
+            close();
+            return false;
+        }
+    }
+
+    data = mapped;
+    boardSize = size;
+    boardWinLength = length;
+    completeLayers = layers;
+    return true;
+}
+
+void Tablebase::close() {
+    if (data) {
+        file.unmap(const_cast<uchar*>(data));
+        data = nullptr;
+    }
+    if (file.isOpen()) {
+        file.close();
+    }
+    boardSize = 0;
+    boardWinLength = 0;
+    completeLayers = 0;
+    offsets.clear();
+}
+
+bool Tablebase::isOpen() const {
+    return data != nullptr;
+}
+
+int Tablebase::size() const {
+    return boardSize;
+}
+
+int Tablebase::winLength() const {
+    return boardWinLength;
+}
+
+int Tablebase::layersComplete() const {
+    return completeLayers;
+}
+
+bool Tablebase::covers(const BoardState& state) const {
+    return data && state.size() == boardSize && state.winLength() == boardWinLength &&
+           qPopulationCount(state.emptyCells()) < completeLayers;
+}
+
+TablebaseEntry Tablebase::probe(const BoardState& state) const {
+    if (!covers(state)) {
+        return TablebaseEntry();
+    }
+
+    quint64 empty = state.emptyCells();
+    quint64 fullMask = empty | state.stones(Player::X) | state.stones(Player::O);
+    quint64 index = indexOf(empty, state.stones(Player::X), fullMask);
+    return decode(data[offsets[qPopulationCount(empty)] + index]);
+}
+
+int Tablebase::bestMove(const BoardState& state, TablebaseEntry* value) const {
+    if (!covers(state) || !probe(state).isValid()) {
+        return -1;
+    }
+
+    int bestCell = -1;
+    TablebaseEntry best;
+    quint64 empty = state.emptyCells();
+    BoardState child = state;
+    for (int cell = 0; cell < state.cellCount(); ++cell) {
+        if (!(empty & (1ULL << cell))) {
+            continue;
+        }
+
+        TablebaseEntry entry;
+        if (state.winsFor(cell, state.toMove())) {
+            entry.result = TablebaseEntry::Win;
+            entry.distance = 1;
+        } else {
+            child.play(cell);
+            entry = afterMove(probe(child));
+            child.undo(cell);
+        }
+
+        if (bestCell < 0 || isBetter(entry, best)) {
+            best = entry;
+            bestCell = cell;
+        }
+    }
+
+    if (value) {
+        *value = best;
+    }
+    return bestCell;
+}
+
+QString Tablebase::fileName(int size, int winLength) {
+    return QString("tablebase-%1x%1-k%2.ttb").arg(size).arg(winLength);
+}
+
+quint64 Tablebase::binomial(int n, int k) {
+    static const BinomialTable table;
+    if (n < 0 || k < 0 || k > n || n > 64) {
+        return 0;
+    }
+    return table.values[n][k];
+}
+
+quint64 Tablebase::layerSize(int cells, int empty) {
+    // X moves first, so X holds the extra stone when the filled count is odd
+    int filled = cells - empty;
+    return binomial(cells, empty) * binomial(filled, (filled + 1) / 2);
+}
+
+quint64 Tablebase::indexOf(quint64 empty, quint64 x, quint64 fullMask) {
+    // Colexicographic rank of the empty cells among all cells...
+    quint64 emptyRank = 0;
+    int k = 0;
+    for (quint64 bits = empty; bits; bits &= bits - 1) {
+        emptyRank += binomial(qCountTrailingZeroBits(bits), ++k);
+    }
+
+    // ...then of X's stones among the filled cells
+    quint64 filled = fullMask & ~empty;
+    quint64 xRank = 0;
+    int position = 0;
+    k = 0;
+    for (quint64 bits = filled; bits; bits &= bits - 1, ++position) {
+        if (x & bits & (~bits + 1)) {
+            xRank += binomial(position, ++k);
+        }
+    }
+
+    int filledCount = qPopulationCount(filled);
+    return emptyRank * binomial(filledCount, (filledCount + 1) / 2) + xRank;
+}
+
+quint8 Tablebase::encode(TablebaseEntry::Result result, int distance) {
+    return static_cast<quint8>((result << 6) | qBound(0, distance, 63));
+}
+
+TablebaseEntry Tablebase::decode(quint8 value) {
+    TablebaseEntry entry;
+    entry.result = static_cast<TablebaseEntry::Result>(value >> 6);
+    entry.distance = value & 63;
+    return entry;
+}
+
+TablebaseEntry Tablebase::afterMove(const TablebaseEntry& child) {
+    TablebaseEntry entry;
+    switch (child.result) {
+    case TablebaseEntry::Win:
+        entry.result = TablebaseEntry::Loss;
+        break;
+    case TablebaseEntry::Loss:
+        entry.result = TablebaseEntry::Win;
+        break;
+    case TablebaseEntry::Draw:
+        entry.result = TablebaseEntry::Draw;
+        break;
+    default:
+        return entry;
+    }
+    entry.distance = child.distance + 1;
+    return entry;
+}
+
+bool Tablebase::isBetter(const TablebaseEntry& a, const TablebaseEntry& b) {
+    // Win fast, otherwise draw, otherwise lose as slowly as possible
+    if (a.result != b.result) {
+        return a.result > b.result;
+    }
+    if (a.result == TablebaseEntry::Win) {
+        return a.distance < b.distance;
+    }
+    if (a.result == TablebaseEntry::Loss) {
+        return a.distance > b.distance;
+    }
+    return false;
+}
+
+int Tablebase::headerSize(int maxEmpty) {
+    return 16 + 8 * (maxEmpty + 1);
+}
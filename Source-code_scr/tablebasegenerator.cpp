@@ -0,0 +1,243 @@
+// tablebasegenerator.cpp - Offline retrograde solver that writes tablebase files
+#include "tablebasegenerator.h"
+#include <QFile>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+// Next larger number with the same count of set bits (Gosper's hack). Walking
+// k-subsets this way visits them in colexicographic order, the order of their rank.
+quint64 nextCombination(quint64 bits) {
+    if (bits == 0) {
+        return 0;
+    }
+    quint64 t = bits | (bits - 1);
+    return (t + 1) | (((~t & (t + 1)) - 1) >> (qCountTrailingZeroBits(bits) + 1));
+}
+
+// The k-subset of n cells with the given colexicographic rank
+quint64 unrankCombination(quint64 rank, int k, int n) {
+    quint64 bits = 0;
+    int position = n - 1;
+    for (int i = k; i >= 1; --i) {
+        while (Tablebase::binomial(position, i) > rank) {
+            --position;
+        }
+        bits |= 1ULL << position;
+        rank -= Tablebase::binomial(position, i);
+        --position;
+    }
+    return bits;
+}
+}
+
+TablebaseGenerator::TablebaseGenerator(QObject* parent) : QObject(parent),
+boardSize(3), boardWinLength(3), emptyLimit(9), threadCount(0), stopRequested(false) {
+}
+
+void TablebaseGenerator::setBoard(int size, int winLength) {
+    boardSize = qBound(1, size, int(BoardState::MaxSize));
+    boardWinLength = qBound(1, winLength, boardSize);
+}
+
+void TablebaseGenerator::setMaxEmpty(int empty) {
+    emptyLimit = empty;
+}
+
+void TablebaseGenerator::setThreads(int count) {
+    threadCount = qMax(0, count);
+}
+
+int TablebaseGenerator::maxEmpty() const {
+    return qBound(0, emptyLimit, qMin(boardSize * boardSize, static_cast<int>(Tablebase::MaxEmpty)));
+}
+
+quint64 TablebaseGenerator::fileSize() const {
+    quint64 bytes = Tablebase::headerSize(maxEmpty());
+    for (int empty = 0; empty <= maxEmpty(); ++empty) {
+        bytes += Tablebase::layerSize(boardSize * boardSize, empty);
+    }
+    return bytes;
+}
+
+void TablebaseGenerator::requestStop() {
+    stopRequested.store(true);
+}
+
+bool TablebaseGenerator::generate(const QString& path, QString* error) {
+    auto fail = [error](const QString& message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+
+    stopRequested.store(false);
+    int cells = boardSize * boardSize;
+    int top = maxEmpty();
+
+    // Layer offsets only depend on the board, so a resumed run agrees with the file
+    QVector<quint64> offsets(top + 1);
+    quint64 offset = Tablebase::headerSize(top);
+    for (int empty = 0; empty <= top; ++empty) {
+        offsets[empty] = offset;
+        offset += Tablebase::layerSize(cells, empty);
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        return fail("Could not open " + path);
+    }
+
+    int done = 0;
+    if (file.size() > 0) {
+        QByteArray header = file.read(16);
+        if (header.size() < 16 || !header.startsWith("TTTB") || header[4] != Tablebase::Version ||
+            header[5] != boardSize || header[6] != boardWinLength || header[7] != top) {
+            return fail(path + " holds a different tablebase");
+        }
+        done = static_cast<quint8>(header[8]);
+    } else {
+        QByteArray header(Tablebase::headerSize(top), '\0');
+        memcpy(header.data(), "TTTB", 4);
+        header[4] = static_cast<char>(Tablebase::Version);
+        header[5] = static_cast<char>(boardSize);
+        header[6] = static_cast<char>(boardWinLength);
+        header[7] = static_cast<char>(top);
+        for (int empty = 0; empty <= top; ++empty) {
+            qToLittleEndian<quint64>(offsets[empty], header.data() + 16 + empty * 8);
+        }
+        if (file.write(header) != header.size() || !file.resize(offset) || !file.flush()) {
+            return fail("Could not write " + path);
+        }
+    }
+
+    // A resumed run only needs the last finished layer
+    QByteArray below;
+    if (done > 0) {
+        qint64 size = static_cast<qint64>(Tablebase::layerSize(cells, done - 1));
+        if (!file.seek(offsets[done - 1]) || (below = file.read(size)).size() != size) {
+            return fail("Could not read " + path);
+        }
+    }
+
+    for (int empty = done; empty <= top; ++empty) {
+        if (stopRequested.load()) {
+            return fail(QString("Stopped with %1 of %2 layers done").arg(empty).arg(top + 1));
+        }
+
+        QByteArray layer(static_cast<qsizetype>(Tablebase::layerSize(cells, empty)), '\0');
+        solveLayer(empty, below, layer);
+        if (!file.seek(offsets[empty]) || file.write(layer) != layer.size() || !file.flush()) {
+            return fail("Could not write " + path);
+        }
+
+        // The layer only counts once its data is on disk
+        char count = static_cast<char>(empty + 1);
+        if (!file.seek(8) || file.write(&count, 1) != 1 || !file.flush()) {
+            return fail("Could not write " + path);
+        }
+
+        emit layerFinished(empty, top, static_cast<quint64>(layer.size()));
+        below = layer;
+    }
+
+    return true;
+}
+
+void TablebaseGenerator::solveLayer(int empty, const QByteArray& below, QByteArray& layer) const {
+    int cells = boardSize * boardSize;
+    quint64 fullMask = (cells == 64) ? ~0ULL : (1ULL << cells) - 1;
+    int filled = cells - empty;
+    int xCount = (filled + 1) / 2;
+    Player mover = (filled % 2 == 0) ? Player::X : Player::O;
+    quint64 perEmptySet = Tablebase::binomial(filled, xCount);
+    quint64 emptySets = Tablebase::binomial(cells, empty);
+
+    // Windows through each cell, for spotting winning moves
+    const QVector<quint64>& windows = BoardState::windows(boardSize, boardWinLength);
+    QVector<QVector<quint64>> cellWindows(cells);
+    for (quint64 window : windows) {
+        for (quint64 bits = window; bits; bits &= bits - 1) {
+            cellWindows[qCountTrailingZeroBits(bits)].append(window);
+        }
+    }
+
+    auto solvePosition = [&](quint64 emptyMask, quint64 xMask, quint64 oMask) -> quint8 {
+        // Positions where the game is already over are never probed
+        for (quint64 window : windows) {
+            if ((xMask & window) == window || (oMask & window) == window) {
+                return 0;
+            }
+        }
+        if (emptyMask == 0) {
+            return Tablebase::encode(TablebaseEntry::Draw, 0);
+        }
+
+        const uchar* childLayer = reinterpret_cast<const uchar*>(below.constData());
+        quint64 moverBits = (mover == Player::X) ? xMask : oMask;
+        TablebaseEntry best;
+        bool found = false;
+        for (quint64 bits = emptyMask; bits; bits &= bits - 1) {
+            int cell = qCountTrailingZeroBits(bits);
+            quint64 bit = 1ULL << cell;
+            for (quint64 window : cellWindows[cell]) {
+                if (((moverBits | bit) & window) == window) {
+                    return Tablebase::encode(TablebaseEntry::Win, 1);
+                }
+            }
+
+            quint64 childX = (mover == Player::X) ? (xMask | bit) : xMask;
+            quint64 index = Tablebase::indexOf(emptyMask & ~bit, childX, fullMask);
+            TablebaseEntry entry = Tablebase::afterMove(Tablebase::decode(childLayer[index]));
+            if (!found || Tablebase::isBetter(entry, best)) {
+                best = entry;
+                found = true;
+            }
+        }
+        return Tablebase::encode(best.result, best.distance);
+    };
+
+    // Each task solves a run of empty-cell sets and writes only their slots
+    quint64 chunkSets = qMax<quint64>(1, (emptySets + 255) / 256);
+    QVector<quint64> chunkStarts;
+    for (quint64 start = 0; start < emptySets; start += chunkSets) {
+        chunkStarts.append(start);
+    }
+
+    uchar* out = reinterpret_cast<uchar*>(layer.data());
+    auto solveChunk = [&](const quint64& start) {
+        quint64 end = qMin(start + chunkSets, emptySets);
+        quint64 emptyMask = unrankCombination(start, empty, cells);
+        int filledCells[64];
+        for (quint64 rank = start; rank < end; ++rank) {
+            quint64 filledMask = fullMask & ~emptyMask;
+            int count = 0;
+            for (quint64 bits = filledMask; bits; bits &= bits - 1) {
+                filledCells[count++] = qCountTrailingZeroBits(bits);
+            }
+
+            // X's stones walk the filled cells in rank order too
+            quint64 subset = (1ULL << xCount) - 1;
+            for (quint64 i = 0; i < perEmptySet; ++i) {
+                quint64 xMask = 0;
+                for (quint64 bits = subset; bits; bits &= bits - 1) {
+                    xMask |= 1ULL << filledCells[qCountTrailingZeroBits(bits)];
+                }
+                out[rank * perEmptySet + i] = solvePosition(emptyMask, xMask, filledMask & ~xMask);
+                subset = nextCombination(subset);
+            }
+            emptyMask = nextCombination(emptyMask);
+        }
+    };
+
+    if (threadCount > 0) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threadCount);
+        QtConcurrent::blockingMap(&pool, chunkStarts, solveChunk);
+    } else {
+        QtConcurrent::blockingMap(chunkStarts, solveChunk);
+    }
+}
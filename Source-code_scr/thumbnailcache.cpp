@@ -0,0 +1,212 @@
+// thumbnailcache.cpp - Final-board thumbnails for the history list
+#include "thumbnailcache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QIcon>
+#include <QThread>
+
+namespace {
+// Bump when the drawing changes so files from older builds are not reused
+const int RenderVersion = 1;
+
+// Queued requests this far behind the newest are moved back to the front
+const int StalePriority = 64;
+}
+
+ThumbnailCache::ThumbnailCache(int side, QObject* parent) : QObject(parent),
+thumbSide(side), pixmaps(4 * 1024 * 1024), nextPriority(0), renderCount(0) {
+    // Leave a core for the GUI thread
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    cancelPending();
+    pool.waitForDone();
+}
+
+void ThumbnailCache::setByteBudget(qint64 bytes) {
+    pixmaps.setMaxCost(qMax<qint64>(1, bytes));
+}
+
+void ThumbnailCache::setDiskDirectory(const QString& path) {
+    diskPath = path;
+    if (!diskPath.isEmpty()) {
+        QDir().mkpath(diskPath);
+    }
+}
+
+int ThumbnailCache::side() const {
+    return thumbSide;
+}
+
+QString ThumbnailCache::gameKey(const QJsonObject& record) {
+    QJsonObject identity;
+    identity["date"] = record["date"];
+    identity["variant"] = record["variant"];
+    identity["boardSize"] = record["boardSize"];
+    identity["winLength"] = record["winLength"];
+    identity["moves"] = record["moves"];
+    QByteArray bytes = QJsonDocument(identity).toJson(QJsonDocument::Compact);
+    bytes.append(QByteArray::number(RenderVersion));
+    return QString(QCryptographicHash::hash(bytes, QCryptographicHash::Sha1).toHex());
+}
+
+QImage ThumbnailCache::render(const QJsonObject& record, int side) {
+    // Only QImage and QPainter on an image, both safe off the GUI thread
+    bool ultimate = (record["variant"].toString() == "ultimate");
+    int size = ultimate ? 9 : qBound(3, record["boardSize"].toInt(3), 16);
+
+    QImage image(side, side, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    qreal margin = qMax(1.0, side / 16.0);
+    QRectF frame(margin / 2, margin / 2, side - margin, side - margin);
+    painter.setPen(QPen(QColor("#495057"), 1));
+    painter.setBrush(QColor("#f8f9fa"));
+    painter.drawRoundedRect(frame, side / 8.0, side / 8.0);
+
+    qreal cell = (side - 2 * margin) / size;
+    for (int line = 1; line < size; ++line) {
+        bool boardEdge = ultimate && line % 3 == 0;
+        painter.setPen(QPen(boardEdge ? QColor("#495057") : QColor("#ced4da"), boardEdge ? 1.5 : 1));
+        qreal offset = margin + line * cell;
+        painter.drawLine(QPointF(offset, margin), QPointF(offset, side - margin));
+        painter.drawLine(QPointF(margin, offset), QPointF(side - margin, offset));
+    }
+
+    painter.setBrush(Qt::NoBrush);
+    qreal inset = cell / 5.0;
+    const QJsonArray moves = record["moves"].toArray();
+    for (const QJsonValue& value : moves) {
+        QJsonObject move = value.toObject();
+        int row = move["row"].toInt(-1);
+        int col = move["col"].toInt(-1);
+        if (row < 0 || row >= size || col < 0 || col >= size) {
+            continue;
+        }
+        QRectF mark(margin + col * cell + inset, margin + row * cell + inset, cell - 2 * inset, cell - 2 * inset);
+        if (move["player"].toString() == "X") {
+            painter.setPen(QPen(QColor("#e84393"), qMax(1.0, cell / 6.0), Qt::SolidLine, Qt::RoundCap));
+            painter.drawLine(mark.topLeft(), mark.bottomRight());
+            painter.drawLine(mark.topRight(), mark.bottomLeft());
+        } else {
+            painter.setPen(QPen(QColor("#0984e3"), qMax(1.0, cell / 6.0)));
+            painter.drawEllipse(mark);
+        }
+    }
+    painter.end();
+    return image;
+}
+
+QPixmap ThumbnailCache::thumbnail(const QString& key) const {
+    QPixmap* pixmap = pixmaps.object(key);
+    return pixmap ? *pixmap : QPixmap();
+}
+
+void ThumbnailCache::request(const QString& key, const QJsonObject& record) {
+    if (pixmaps.contains(key)) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    if (running.contains(key)) {
+        return;
+    }
+    auto it = queued.find(key);
+    if (it != queued.end()) {
+        // Still waiting; if newer requests have piled up in front, move it back ahead of them
+        if (it->priority < nextPriority - StalePriority && pool.tryTake(it->job)) {
+            it->priority = ++nextPriority;
+            pool.start(it->job, it->priority);
+        }
+        return;
+    }
+
+    QueuedJob entry;
+    entry.job = QRunnable::create([this, key, record]() { load(key, record); });
+    entry.priority = ++nextPriority;
+    queued.insert(key, entry);
+    pool.start(entry.job, entry.priority);
+}
+
+void ThumbnailCache::cancelPending() {
+    QMutexLocker locker(&mutex);
+    for (const QueuedJob& entry : std::as_const(queued)) {
+        // Taken jobs are ours to delete; the rest have just started and finish normally
+        if (pool.tryTake(entry.job)) {
+            delete entry.job;
+        }
+    }
+    queued.clear();
+}
+
+qint64 ThumbnailCache::rendered() const {
+    return renderCount.load();
+}
+
+qint64 ThumbnailCache::cachedBytes() const {
+    return pixmaps.totalCost();
+}
+
+void ThumbnailCache::load(const QString& key, const QJsonObject& record) {
+    {
+        QMutexLocker locker(&mutex);
+        queued.remove(key);
+        running.insert(key);
+    }
+
+    // A file from an earlier run is cheaper to decode than the board is to draw
+    QString file = diskPath.isEmpty() ? QString()
+                                      : QString("%1/%2-%3.png").arg(diskPath, key).arg(thumbSide);
+    QImage image;
+    if (!file.isEmpty()) {
+        image.load(file);
+    }
+    if (image.size() != QSize(thumbSide, thumbSide)) {
+        image = render(record, thumbSide);
+        ++renderCount;
+        if (!file.isEmpty()) {
+            image.save(file, "PNG");
+        }
+    }
+
+    QMetaObject::invokeMethod(this, [this, key, image]() { deliver(key, image); }, Qt::QueuedConnection);
+}
+
+void ThumbnailCache::deliver(const QString& key, const QImage& image) {
+    {
+        QMutexLocker locker(&mutex);
+        running.remove(key);
+    }
+    pixmaps.insert(key, new QPixmap(QPixmap::fromImage(image)), qMax<qint64>(1, image.sizeInBytes()));
+    emit thumbnailReady(key);
+}
+
+ThumbnailDelegate::ThumbnailDelegate(ThumbnailCache* thumbnailCache, QObject* parent) : QStyledItemDelegate(parent),
+cache(thumbnailCache), placeholder(thumbnailCache->side(), thumbnailCache->side()) {
+    placeholder.fill(Qt::transparent);
+}
+
+void ThumbnailDelegate::initStyleOption(QStyleOptionViewItem* option, const QModelIndex& index) const {
+    QStyledItemDelegate::initStyleOption(option, index);
+    QString key = index.data(KeyRole).toString();
+    if (key.isEmpty()) {
+        return;
+    }
+
+    // Only rows being drawn ask for their thumbnail, so the visible ones come first
+    QPixmap pixmap = cache->thumbnail(key);
+    if (pixmap.isNull()) {
+        cache->request(key, index.data(RecordRole).toJsonObject());
+        pixmap = placeholder;
+    }
+    option->features |= QStyleOptionViewItem::HasDecoration;
+    option->icon = QIcon(pixmap);
+    option->decorationSize = pixmap.size();
+}
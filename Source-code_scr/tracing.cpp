@@ -0,0 +1,234 @@
+// tracing.cpp - Scoped spans on hot paths, exported as Chrome trace events
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QVector>
+#include <memory>
+
+std::atomic<bool> Tracer::enabled(false);
+
+namespace {
+const quint64 Mask = Tracer::BufferEvents - 1;
+
+// A slot's sequence is odd while its owner writes it and 2 * (position + 1)
+// once written, so a reader can tell a finished span from a half-written one
+struct Slot {
+    std::atomic<quint64> sequence{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<qint64> start{0};
+    std::atomic<qint64> duration{0};
+};
+
+struct ThreadBuffer {
+    std::unique_ptr<Slot[]> spans{new Slot[Tracer::BufferEvents]};
+    std::atomic<quint64> head{0};    // Spans ever written; only the owner stores it
+    std::atomic<quint64> cleared{0}; // Spans before this were dropped by clear()
+    std::atomic<bool> retired{false}; // Its thread has ended
+    quint64 exported = 0;            // head at the last export; under the registry mutex
+    int threadId = 0;
+    QString threadName;
+
+    // Nothing of an ended thread would be lost by handing the buffer on
+    bool drained() const {
+        quint64 written = head.load(std::memory_order_acquire);
+        return cleared.load(std::memory_order_relaxed) >= written || exported >= written;
+    }
+};
+
+struct Registry {
+    QMutex mutex;
+    QVector<ThreadBuffer*> buffers; // Kept after their thread ends until a new thread takes them over
+    int nextThreadId = 1;
+    QElapsedTimer clock;
+
+    Registry() {
+        clock.start();
+    }
+};
+
+Registry& registry() {
+    // Never destroyed, so threads still tracing during shutdown have somewhere to write
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+// Retires the thread's buffer when the thread ends
+struct LocalBuffer {
+    ThreadBuffer* buffer = nullptr;
+
+    ~LocalBuffer() {
+        if (buffer) {
+            buffer->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local LocalBuffer localBuffer;
+
+// An ended thread's buffer, drained first, or the oldest one when the registry is full
+ThreadBuffer* reusableBuffer(const Registry& reg) {
+    ThreadBuffer* oldest = nullptr;
+    for (ThreadBuffer* buffer : reg.buffers) {
+        if (!buffer->retired.load(std::memory_order_acquire)) {
+            continue;
+        }
+        if (buffer->drained()) {
+            return buffer;
+        }
+        if (!oldest) {
+            oldest = buffer;
+        }
+    }
+    return (reg.buffers.size() >= Tracer::MaxThreadBuffers) ? oldest : nullptr;
+}
+
+ThreadBuffer* threadBuffer() {
+    if (!localBuffer.buffer) {
+        QThread* thread = QThread::currentThread();
+        Registry& reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        ThreadBuffer* buffer = reusableBuffer(reg);
+        if (buffer) {
+            // head keeps counting, so slot sequences stay unique; the old spans are dropped
+            buffer->cleared.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+            buffer->retired.store(false, std::memory_order_relaxed);
+        } else {
+            buffer = new ThreadBuffer;
+            reg.buffers.append(buffer);
+        }
+        buffer->threadId = reg.nextThreadId++;
+        if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+            buffer->threadName = "Main";
+        } else if (thread && !thread->objectName().isEmpty()) {
+            buffer->threadName = thread->objectName();
+        } else {
+            buffer->threadName = QString("Worker %1").arg(buffer->threadId);
+        }
+        localBuffer.buffer = buffer;
+    }
+    return localBuffer.buffer;
+}
+
+// Visits each finished span still in the buffer, oldest first
+template <typename Visitor>
+void forEachSpan(const ThreadBuffer& buffer, Visitor visit) {
+    quint64 head = buffer.head.load(std::memory_order_acquire);
+    quint64 first = qMax(buffer.cleared.load(std::memory_order_relaxed),
+                         head > quint64(Tracer::BufferEvents) ? head - Tracer::BufferEvents : 0);
+    for (quint64 position = first; position < head; ++position) {
+        const Slot& slot = buffer.spans[position & Mask];
+        quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * (position + 1)) {
+            continue; // Overwritten by a newer span since head was read
+        }
+        const char* name = slot.name.load(std::memory_order_relaxed);
+        qint64 start = slot.start.load(std::memory_order_relaxed);
+        qint64 duration = slot.duration.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+            visit(name, start, duration);
+        }
+    }
+}
+}
+
+void Tracer::setEnabled(bool on) {
+    if (on) {
+        registry(); // Start the clock before the first span
+    }
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+qint64 Tracer::now() {
+    return registry().clock.nsecsElapsed();
+}
+
+void Tracer::record(const char* name, qint64 startNs, qint64 endNs) {
+    ThreadBuffer* buffer = threadBuffer();
+    quint64 position = buffer->head.load(std::memory_order_relaxed);
+    Slot& slot = buffer->spans[position & Mask];
+
+    slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(startNs, std::memory_order_relaxed);
+    slot.duration.store(endNs - startNs, std::memory_order_relaxed);
+    slot.sequence.store(2 * (position + 1), std::memory_order_release);
+    buffer->head.store(position + 1, std::memory_order_release);
+}
+
+void Tracer::clear() {
+    Registry& reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (ThreadBuffer* buffer : std::as_const(reg.buffers)) {
+        buffer->cleared.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+int Tracer::eventCount() {
+    Registry& reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    int count = 0;
+    for (ThreadBuffer* buffer : std::as_const(reg.buffers)) {
+        forEachSpan(*buffer, [&count](const char*, qint64, qint64) { ++count; });
+    }
+    return count;
+}
+
+int Tracer::threadBufferCount() {
+    Registry& reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    return reg.buffers.size();
+}
+
+QJsonObject Tracer::toChromeTrace() {
+    Registry& reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray events;
+    for (ThreadBuffer* buffer : std::as_const(reg.buffers)) {
+        // Metadata event so the viewer labels the track
+        QJsonObject threadName;
+        threadName["name"] = "thread_name";
+        threadName["ph"] = "M";
+        threadName["pid"] = pid;
+        threadName["tid"] = buffer->threadId;
+        threadName["args"] = QJsonObject{{"name", buffer->threadName}};
+        events.append(threadName);
+
+        quint64 head = buffer->head.load(std::memory_order_acquire);
+        forEachSpan(*buffer, [&](const char* name, qint64 start, qint64 duration) {
+            // Complete events, timestamps in microseconds
+            QJsonObject event;
+            event["name"] = QString::fromLatin1(name);
+            event["cat"] = "app";
+            event["ph"] = "X";
+            event["ts"] = start / 1000.0;
+            event["dur"] = duration / 1000.0;
+            event["pid"] = pid;
+            event["tid"] = buffer->threadId;
+            events.append(event);
+        });
+        buffer->exported = head; // Spans written since were not in this export
+    }
+
+    QJsonObject trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ms";
+    return trace;
+}
+
+bool Tracer::writeChromeTrace(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(QJsonDocument(toChromeTrace()).toJson(QJsonDocument::Compact)) >= 0;
+}
@@ -0,0 +1,199 @@
+// ultimateboard.cpp - Bitboard state for ultimate tic-tac-toe
+#include "ultimateboard.h"
+
+namespace {
+
+const quint16 AllSquares = 0x1FF;
+
+struct UltimateTables {
+    bool line[512];                       // Indexed by a 9-bit mask
+    quint64 cellKeys[2][UltimateBoard::Cells];
+    quint64 forcedKeys[10];               // AnyBoard, then boards 0-8
+
+    UltimateTables() {
+        const quint16 lines[8] = { 0007, 0070, 0700, 0111, 0222, 0444, 0421, 0124 };
+        for (int mask = 0; mask < 512; ++mask) {
+            line[mask] = false;
+            for (quint16 winning : lines) {
+                if ((mask & winning) == winning) {
+                    line[mask] = true;
+                }
+            }
+        }
+
+        // Fixed splitmix64 sequence so hashes are stable between runs
+        quint64 state = 0x7A3C1E5D2B4F6081ULL;
+        auto next = [&state]() {
+            state += 0x9E3779B97F4A7C15ULL;
+            quint64 z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        };
+        for (int side = 0; side < 2; ++side) {
+            for (int cell = 0; cell < UltimateBoard::Cells; ++cell) {
+                cellKeys[side][cell] = next();
+            }
+        }
+        for (int board = 0; board < 10; ++board) {
+            forcedKeys[board] = next();
+        }
+    }
+};
+
+const UltimateTables& tables() {
+    static const UltimateTables table;
+    return table;
+}
+
+} // namespace
+
+UltimateBoard::UltimateBoard() : macro{ 0, 0 }, closed(0), forced(AnyBoard), plies(0),
+result(Player::None), over(false) {
+    for (int board = 0; board < 9; ++board) {
+        local[0][board] = 0;
+        local[1][board] = 0;
+    }
+    zobrist = tables().forcedKeys[0];
+}
+
+Player UltimateBoard::at(int cell) const {
+    if (cell < 0 || cell >= Cells) {
+        return Player::None;
+    }
+    quint16 bit = 1 << (cell % 9);
+    if (local[0][cell / 9] & bit) {
+        return Player::X;
+    }
+    if (local[1][cell / 9] & bit) {
+        return Player::O;
+    }
+    return Player::None;
+}
+
+quint16 UltimateBoard::localStones(int board, Player player) const {
+    return local[player == Player::X ? 0 : 1][board];
+}
+
+quint16 UltimateBoard::boardsWon(Player player) const {
+    return macro[player == Player::X ? 0 : 1];
+}
+
+Player UltimateBoard::boardWinner(int board) const {
+    if (macro[0] & (1 << board)) {
+        return Player::X;
+    }
+    if (macro[1] & (1 << board)) {
+        return Player::O;
+    }
+    return Player::None;
+}
+
+bool UltimateBoard::isLegal(int cell) const {
+    if (over || cell < 0 || cell >= Cells) {
+        return false;
+    }
+    int board = cell / 9;
+    if ((closed & (1 << board)) || (forced != AnyBoard && board != forced)) {
+        return false;
+    }
+    return !((local[0][board] | local[1][board]) & (1 << (cell % 9)));
+}
+
+int UltimateBoard::legalMoves(int* out) const {
+    if (over) {
+        return 0;
+    }
+
+    int count = 0;
+    int first = (forced == AnyBoard) ? 0 : forced;
+    int last = (forced == AnyBoard) ? 8 : forced;
+    for (int board = first; board <= last; ++board) {
+        if (closed & (1 << board)) {
+            continue;
+        }
+        quint16 empty = AllSquares & ~(local[0][board] | local[1][board]);
+        for (int square = 0; square < 9; ++square) {
+            if (empty & (1 << square)) {
+                out[count++] = board * 9 + square;
+            }
+        }
+    }
+    return count;
+}
+
+void UltimateBoard::play(int cell) {
+    const UltimateTables& t = tables();
+    int board = cell / 9;
+    int square = cell % 9;
+    int side = plies % 2;
+
+    history[plies] = static_cast<qint8>(cell);
+    forcedBefore[plies] = static_cast<qint8>(forced);
+
+    local[side][board] |= 1 << square;
+    zobrist ^= t.cellKeys[side][cell];
+    if (t.line[local[side][board]]) {
+        macro[side] |= 1 << board;
+        closed |= 1 << board;
+    } else if ((local[0][board] | local[1][board]) == AllSquares) {
+        closed |= 1 << board;
+    }
+
+    // The square played sends the opponent to the matching board
+    zobrist ^= t.forcedKeys[forced + 1];
+    forced = (closed & (1 << square)) ? AnyBoard : square;
+    zobrist ^= t.forcedKeys[forced + 1];
+
+    ++plies;
+    updateResult();
+}
+
+void UltimateBoard::undo() {
+    const UltimateTables& t = tables();
+    --plies;
+    int cell = history[plies];
+    int board = cell / 9;
+    int side = plies % 2;
+
+    // The board was open before the move, whatever the move did to it
+    local[side][board] &= ~(1 << (cell % 9));
+    zobrist ^= t.cellKeys[side][cell];
+    macro[side] &= ~(1 << board);
+    closed &= ~(1 << board);
+
+    zobrist ^= t.forcedKeys[forced + 1];
+    forced = forcedBefore[plies];
+    zobrist ^= t.forcedKeys[forced + 1];
+
+    result = Player::None;
+    over = false;
+}
+
+void UltimateBoard::updateResult() {
+    if (tables().line[macro[0]]) {
+        result = Player::X;
+        over = true;
+    } else if (tables().line[macro[1]]) {
+        result = Player::O;
+        over = true;
+    } else if (closed == AllSquares) {
+        over = true;
+    }
+}
+
+int UltimateBoard::cellAt(int row, int col) {
+    return ((row / 3) * 3 + col / 3) * 9 + (row % 3) * 3 + col % 3;
+}
+
+int UltimateBoard::rowOf(int cell) {
+    return (cell / 9 / 3) * 3 + (cell % 9) / 3;
+}
+
+int UltimateBoard::colOf(int cell) {
+    return (cell / 9 % 3) * 3 + (cell % 9) % 3;
+}
+
+bool UltimateBoard::isLine(quint16 squares) {
+    return tables().line[squares & AllSquares];
+}
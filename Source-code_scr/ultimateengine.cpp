@@ -0,0 +1,368 @@
+// ultimateengine.cpp - Alpha-beta search for ultimate tic-tac-toe
+#include "ultimateengine.h"
+#include "tracing.h"
+
+namespace {
+const int Infinity = UltimateEngine::WinScore + 1;
+const int HeuristicLimit = UltimateEngine::WinScore / 2;
+const quint16 Lines[8] = { 0007, 0070, 0700, 0111, 0222, 0444, 0421, 0124 };
+
+// Win scores are stored relative to the node so they stay valid at any ply
+int toTable(int score, int ply) {
+    if (SearchEngine::isWinScore(score)) {
+        return score > 0 ? score + ply : score - ply;
+    }
+    return score;
+}
+
+int fromTable(int score, int ply) {
+    if (SearchEngine::isWinScore(score)) {
+        return score > 0 ? score - ply : score + ply;
+    }
+    return score;
+}
+
+// Squares of a board by how many lines run through them
+int squareWeight(int square) {
+    if (square == 4) {
+        return 3;
+    }
+    return (square % 2 == 0) ? 2 : 1;
+}
+}
+
+UltimateEngine::UltimateEngine() : table(1 << TableBits), stopFlag(nullptr), deadlineMs(0), aborted(false) {
+    clearTables();
+}
+
+void UltimateEngine::clearTables() {
+    table.fill(TTEntry());
+    for (int side = 0; side < 2; ++side) {
+        for (int cell = 0; cell < UltimateBoard::Cells; ++cell) {
+            history[side][cell] = 0;
+        }
+    }
+    for (int ply = 0; ply < MaxPly; ++ply) {
+        killers[ply][0] = -1;
+        killers[ply][1] = -1;
+    }
+}
+
+int UltimateEngine::evaluate(const UltimateBoard& board) {
+    static const int macroWeight[3] = { 0, 60, 600 };
+    static const int localWeight[3] = { 0, 1, 10 };
+
+    quint16 xWon = board.boardsWon(Player::X);
+    quint16 oWon = board.boardsWon(Player::O);
+    quint16 closed = board.closedBoards();
+    quint16 drawn = closed & ~(xWon | oWon);
+    int score = 0;
+
+    // Lines on the big board still open for one side
+    for (quint16 line : Lines) {
+        if (line & drawn) {
+            continue;
+        }
+        int x = qPopulationCount(static_cast<quint32>(xWon & line));
+        int o = qPopulationCount(static_cast<quint32>(oWon & line));
+        if (x > 0 && o == 0) {
+            score += macroWeight[x];
+        } else if (o > 0 && x == 0) {
+            score -= macroWeight[o];
+        }
+    }
+
+    for (int b = 0; b < 9; ++b) {
+        int weight = squareWeight(b);
+        if (xWon & (1 << b)) {
+            score += 50 * weight;
+            continue;
+        }
+        if (oWon & (1 << b)) {
+            score -= 50 * weight;
+            continue;
+        }
+        if (closed & (1 << b)) {
+            continue;
+        }
+
+        // Lines inside the boards still in play, weighted like the board itself
+        quint16 x = board.localStones(b, Player::X);
+        quint16 o = board.localStones(b, Player::O);
+        for (quint16 line : Lines) {
+            int xCount = qPopulationCount(static_cast<quint32>(x & line));
+            int oCount = qPopulationCount(static_cast<quint32>(o & line));
+            if (xCount > 0 && oCount == 0) {
+                score += localWeight[xCount] * weight;
+            } else if (oCount > 0 && xCount == 0) {
+                score -= localWeight[oCount] * weight;
+            }
+        }
+    }
+
+    score = qBound(-HeuristicLimit, score, HeuristicLimit);
+    return (board.toMove() == Player::X) ? score : -score;
+}
+
+void UltimateEngine::setStopFlag(const std::atomic<bool>* flag) {
+    stopFlag = flag;
+}
+
+bool UltimateEngine::outOfTime() {
+    if (stopFlag && stopFlag->load(std::memory_order_relaxed)) {
+        return true;
+    }
+    return deadlineMs > 0 && timer.elapsed() >= deadlineMs;
+}
+
+SearchResult UltimateEngine::search(const UltimateBoard& root, const SearchLimits& limits) {
+    TRACE_SCOPE("UltimateEngine::search");
+    SearchResult result;
+    timer.start();
+    stats = SearchStats();
+
+    int moves[UltimateBoard::Cells];
+    if (root.legalMoves(moves) == 0) {
+        return result;
+    }
+
+    // Killers only make sense within one search; history fades so old cutoffs give way
+    for (int ply = 0; ply < MaxPly; ++ply) {
+        killers[ply][0] = -1;
+        killers[ply][1] = -1;
+    }
+    for (int side = 0; side < 2; ++side) {
+        for (int cell = 0; cell < UltimateBoard::Cells; ++cell) {
+            history[side][cell] /= 2;
+        }
+    }
+
+    int remaining = UltimateBoard::Cells - root.moveCount();
+    int maxDepth = (limits.maxDepth > 0) ? qMin(limits.maxDepth, remaining) : remaining;
+    UltimateBoard board = root;
+
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        // The first iteration ignores the deadline so there is always a move
+        deadlineMs = (depth > 1) ? limits.timeBudgetMs : 0;
+        aborted = false;
+
+        int bestCell = -1;
+        int score = rootSearch(board, depth, result.cell, limits.scoreAllMoves, &bestCell);
+        if (aborted) {
+            result.timedOut = true;
+            break;
+        }
+
+        result.cell = bestCell;
+        result.score = score;
+        result.depthCompleted = depth;
+        result.rootScores = iterationScores;
+
+        // Read the line back now, before a deeper iteration overwrites the table
+        result.principalVariation = principalVariation(root, bestCell, depth);
+
+        // A forced result will not change with more depth, though other moves' scores may
+        if (SearchEngine::isWinScore(score) && !limits.scoreAllMoves) {
+            result.exact = true;
+            break;
+        }
+    }
+
+    result.stats = stats;
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+QVector<int> UltimateEngine::principalVariation(const UltimateBoard& root, int cell, int maxLength) const {
+    // Follow the stored best moves; entries may have been replaced, so check each one
+    QVector<int> line;
+    UltimateBoard board = root;
+    while (line.size() < maxLength && board.isLegal(cell)) {
+        line.append(cell);
+        board.play(cell);
+        const TTEntry& entry = table[board.hash() & ((1 << TableBits) - 1)];
+        cell = (entry.key == board.hash()) ? entry.bestCell : -1;
+    }
+    return line;
+}
+
+int UltimateEngine::orderMoves(const UltimateBoard& board, int ply, int ttCell, int* moves) const {
+    int scores[UltimateBoard::Cells];
+    int legal[UltimateBoard::Cells];
+    int count = board.legalMoves(legal);
+    Player me = board.toMove();
+    Player them = (me == Player::X) ? Player::O : Player::X;
+    int side = (me == Player::X) ? 0 : 1;
+
+    for (int n = 0; n < count; ++n) {
+        int cell = legal[n];
+        int b = cell / 9;
+        int square = cell % 9;
+        quint16 bit = 1 << square;
+
+        int score;
+        if (cell == ttCell) {
+            score = 1 << 30;
+        } else if (cell == killers[ply][0]) {
+            score = 1 << 29;
+        } else if (cell == killers[ply][1]) {
+            score = 1 << 28;
+        } else {
+            // Taking a board beats blocking one; a free choice for the opponent is a gift
+            score = history[side][cell] * 8 + squareWeight(square);
+            if (UltimateBoard::isLine(board.localStones(b, me) | bit)) {
+                score += 1 << 27;
+            } else if (UltimateBoard::isLine(board.localStones(b, them) | bit)) {
+                score += 1 << 26;
+            }
+            if (square != b && (board.closedBoards() & (1 << square))) {
+                score -= 1 << 25;
+            }
+        }
+
+        // Insertion sort, stable so equal scores keep board order
+        int i = n;
+        while (i > 0 && scores[i - 1] < score) {
+            scores[i] = scores[i - 1];
+            moves[i] = moves[i - 1];
+            --i;
+        }
+        scores[i] = score;
+        moves[i] = cell;
+    }
+    return count;
+}
+
+int UltimateEngine::rootSearch(UltimateBoard& board, int depth, int preferredCell, bool scoreAll, int* bestCell) {
+    // Previous iteration's best move goes first through the TT slot
+    int moves[UltimateBoard::Cells];
+    int count = orderMoves(board, 0, preferredCell, moves);
+    Player mover = board.toMove();
+
+    int alpha = -Infinity;
+    *bestCell = moves[0];
+    iterationScores.clear();
+    for (int i = 0; i < count; ++i) {
+        int cell = moves[i];
+        board.play(cell);
+        int score;
+        if (board.winner() == mover) {
+            score = WinScore - 1;
+        } else if (board.isOver()) {
+            score = 0;
+        } else {
+            int window = scoreAll ? -Infinity : alpha;
+            score = -negamax(board, depth - 1, 1, -Infinity, -window);
+        }
+        board.undo();
+
+        if (aborted) {
+            return 0;
+        }
+
+        // Moves that fail low only have an upper bound
+        RootScore rootScore;
+        rootScore.cell = cell;
+        rootScore.score = score;
+        rootScore.upperBound = !scoreAll && score <= alpha;
+        iterationScores.append(rootScore);
+
+        if (score > alpha) {
+            alpha = score;
+            *bestCell = cell;
+        }
+    }
+    return alpha;
+}
+
+int UltimateEngine::negamax(UltimateBoard& board, int depth, int ply, int alpha, int beta) {
+    ++stats.nodes;
+    if ((stats.nodes & 1023) == 0 && outOfTime()) {
+        aborted = true;
+    }
+    if (aborted) {
+        return 0;
+    }
+
+    if (depth == 0) {
+        return evaluate(board);
+    }
+
+    // Probe the transposition table
+    TTEntry& entry = table[board.hash() & ((1 << TableBits) - 1)];
+    int ttCell = -1;
+    if (entry.key == board.hash()) {
+        ttCell = entry.bestCell;
+        if (entry.depth >= depth) {
+            int score = fromTable(entry.score, ply);
+            if (entry.bound == BoundExact ||
+                (entry.bound == BoundLower && score >= beta) ||
+                (entry.bound == BoundUpper && score <= alpha)) {
+                ++stats.ttHits;
+                return score;
+            }
+        }
+    }
+
+    int moves[UltimateBoard::Cells];
+    int count = orderMoves(board, ply, ttCell, moves);
+    Player mover = board.toMove();
+    int side = (mover == Player::X) ? 0 : 1;
+    int originalAlpha = alpha;
+    int best = -Infinity;
+    int bestCell = moves[0];
+
+    for (int i = 0; i < count; ++i) {
+        int cell = moves[i];
+        board.play(cell);
+        int score;
+        if (board.winner() == mover) {
+            score = WinScore - (ply + 1); // Faster wins score higher
+        } else if (board.isOver()) {
+            score = 0;
+        } else {
+            score = -negamax(board, depth - 1, ply + 1, -beta, -alpha);
+        }
+        board.undo();
+
+        if (aborted) {
+            return 0;
+        }
+        if (score > best) {
+            best = score;
+            bestCell = cell;
+        }
+        if (best > alpha) {
+            alpha = best;
+        }
+        if (alpha >= beta) {
+            ++stats.cutoffs;
+            if (i == 0) {
+                ++stats.firstMoveCutoffs;
+            }
+            if (killers[ply][0] != cell) {
+                killers[ply][1] = killers[ply][0];
+                killers[ply][0] = cell;
+            }
+            history[side][cell] = qMin(history[side][cell] + depth * depth, int(HistoryLimit));
+            break;
+        }
+    }
+
+    // Store the result, replacing shallower entries
+    if (entry.key != board.hash() || depth >= entry.depth) {
+        entry.key = board.hash();
+        entry.score = toTable(best, ply);
+        entry.depth = static_cast<qint8>(depth);
+        entry.bestCell = static_cast<qint8>(bestCell);
+        if (best <= originalAlpha) {
+            entry.bound = BoundUpper;
+        } else if (best >= beta) {
+            entry.bound = BoundLower;
+        } else {
+            entry.bound = BoundExact;
+        }
+    }
+
+    return best;
+}
@@ -1,23 +1,48 @@
 // userauth.cpp - Implementation of User Authentication
 #include "userauth.h"
+#include "tracing.h"
+#include "metrics.h"
+#include <QElapsedTimer>
 #include <QDir>
+#include <QFileInfo>
 #include <QStandardPaths>
+#include <QtConcurrent>
 
-UserAuth::UserAuth() : loggedIn(false) {
+UserAuth::UserAuth(bool loadInBackground) : loggedIn(false), loadPending(false), historyLoaded(false), historySize(-1),
+historyIndexBuilt(false) {
     // Set up file path for user data
     QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QDir().mkpath(dataPath);
     usersFilePath = dataPath + "/users.json";
 
     // Load existing users
-    loadUsersFromFile();
+    if (loadInBackground) {
+        pendingLoad = QtConcurrent::run(&UserAuth::readUsersFile, usersFilePath);
+        loadPending = true;
+    } else {
+        adoptUsers(readUsersFile(usersFilePath));
+    }
 }
 
 UserAuth::~UserAuth() {
-    // Save users when the program exits
+    // Save users when the program exits, never over a file that was not read yet
+    waitForLoad();
     saveUsersToFile();
 }
 
+void UserAuth::waitForLoad() const {
+    if (!loadPending) {
+        return;
+    }
+    // The first caller takes over what the background parse read
+    loadPending = false;
+    adoptUsers(pendingLoad.result());
+}
+
+bool UserAuth::isLoadPending() const {
+    return loadPending && !pendingLoad.isFinished();
+}
+
 QString UserAuth::hashPassword(const QString& password) {
     QByteArray passwordBytes = password.toUtf8();
     QByteArray hash = QCryptographicHash::hash(passwordBytes, QCryptographicHash::Sha256);
@@ -25,6 +50,8 @@ QString UserAuth::hashPassword(const QString& password) {
 }
 
 bool UserAuth::signUp(const QString& username, const QString& password) {
+    waitForLoad();
+
     // Check if username already exists
     if (users.contains(username)) {
         return false;
@@ -39,6 +66,9 @@ bool UserAuth::signUp(const QString& username, const QString& password) {
         return false;
     }
 
+    // A history left behind by a users.json that was since removed is not theirs
+    QFile::remove(historyFilePath(usersFilePath, username));
+
     // Create new user
     User newUser;
     newUser.username = username;
@@ -51,19 +81,29 @@ bool UserAuth::signUp(const QString& username, const QString& password) {
     return saveUsersToFile();
 }
 bool UserAuth::signIn(const QString& username, const QString& password) {
+    QElapsedTimer timer;
+    timer.start();
+    waitForLoad();
+
     // Check if user exists
     if (!users.contains(username)) {
+        AppMetrics::signInSeconds.observeNs(timer.nsecsElapsed());
         return false;
     }
 
     // Verify password
-    if (users[username].passwordHash == hashPassword(password)) {
+    bool valid = (users[username].passwordHash == hashPassword(password));
+    if (valid) {
         currentUser = username;
         loggedIn = true;
-        return true;
+        history = QJsonArray();
+        historyLoaded = false;
+        historySize = -1;
+        historyIndexBuilt = false;
+        AppMetrics::historyGames.set(username, getHistorySize());
     }
-
-    return false;
+    AppMetrics::signInSeconds.observeNs(timer.nsecsElapsed());
+    return valid;
 }
 
 bool UserAuth::isLoggedIn() const {
@@ -77,36 +117,170 @@ QString UserAuth::getCurrentUser() const {
 void UserAuth::signOut() {
     currentUser = "";
     loggedIn = false;
+    history = QJsonArray();
+    historyLoaded = false;
+    historySize = -1;
+    historyIndex.clear();
+    historyIndexBuilt = false;
 }
 
 bool UserAuth::saveGameToHistory(const QJsonObject& gameData) {
+    waitForLoad();
+
     if (!loggedIn) {
         return false;
     }
 
-    // Add game to user's history
-    users[currentUser].gameHistory.append(gameData);
+    // Add game to user's history, appended to its file rather than rewriting it
+    int size = getHistorySize();
+    bool appended = appendToHistoryFile(historyFilePath(usersFilePath, currentUser), QJsonArray{gameData});
+    if (historyLoaded) {
+        history.append(gameData);
+    }
+    if (historyIndexBuilt) {
+        historyIndex.append(gameData);
+    }
+    historySize = size + 1;
+    updateRatings(gameData);
+    AppMetrics::historyGames.set(currentUser, historySize);
 
-    // Save updated users to file
-    return saveUsersToFile();
+    // The rating changed; users.json holds accounts only, so it stays small
+    return saveUsersToFile() && appended;
+}
+
+bool UserAuth::saveGamesToHistory(const QJsonArray& games) {
+    waitForLoad();
+
+    if (!loggedIn) {
+        return false;
+    }
+
+    // Imported games were already rated where they were played, so they
+    // only extend the history. Only the file, the count and the indexes grow;
+    // a history already read in is dropped and read again when next wanted.
+    int size = getHistorySize();
+    bool appended = appendToHistoryFile(historyFilePath(usersFilePath, currentUser), games);
+    history = QJsonArray();
+    historyLoaded = false;
+    if (historyIndexBuilt) {
+        for (const QJsonValue& game : games) {
+            historyIndex.append(game.toObject());
+        }
+    }
+    historySize = size + games.size();
+    AppMetrics::historyGames.set(currentUser, historySize);
+    return appended;
 }
 
 QJsonArray UserAuth::getGameHistory() const {
+    waitForLoad();
+
     if (!loggedIn || !users.contains(currentUser)) {
         return QJsonArray();
     }
+    if (!historyLoaded) {
+        history = readHistoryFile(historyFilePath(usersFilePath, currentUser));
+        historyLoaded = true;
+        historySize = history.size();
+    }
+    return history;
+}
 
-    return users[currentUser].gameHistory;
+int UserAuth::getHistorySize() const {
+    waitForLoad();
+
+    if (!loggedIn || !users.contains(currentUser)) {
+        return 0;
+    }
+    if (historySize < 0) {
+        historySize = countHistoryFile(historyFilePath(usersFilePath, currentUser));
+    }
+    return historySize;
 }
 
-bool UserAuth::loadUsersFromFile() {
-    QFile file(usersFilePath);
-    if (!file.exists()) {
-        return true; // No file yet, that's okay
+const HistoryIndex& UserAuth::getHistoryIndex() const {
+    // Built once per sign-in, then kept current by the save functions
+    if (!historyIndexBuilt) {
+        historyIndex.rebuild(getGameHistory());
+        historyIndexBuilt = true;
     }
+    return historyIndex;
+}
 
-    if (!file.open(QIODevice::ReadOnly)) {
-        return false;
+QString UserAuth::getHistoryFilePath() const {
+    if (!loggedIn) {
+        return QString();
+    }
+    return historyFilePath(usersFilePath, currentUser);
+}
+
+int UserAuth::aiRating(const QString& difficulty) {
+    // Fixed ratings so AI games move players on the same scale as human games
+    if (difficulty == "Easy") {
+        return 800;
+    } else if (difficulty == "Medium") {
+        return 1100;
+    } else if (difficulty == "Hard") {
+        return 1400;
+    } else if (difficulty == "Unbeatable") {
+        return 1800;
+    }
+    return 1100;
+}
+
+void UserAuth::updateRatings(const QJsonObject& gameData) {
+    QString result = gameData["result"].toString();
+    double scoreX;
+    if (result == "X wins") {
+        scoreX = 1.0;
+    } else if (result == "O wins") {
+        scoreX = 0.0;
+    } else if (result == "Tie") {
+        scoreX = 0.5;
+    } else {
+        return; // Incomplete games are not rated
+    }
+
+    // Only games against the AI are rated; a local two-player game has no
+    // second account to rate against
+    if (!gameData["vsAI"].toBool()) {
+        return;
+    }
+
+    // The signed-in player always plays X
+    User& player = users[currentUser];
+    int opponentRating = aiRating(gameData["difficulty"].toString());
+    player.rating = Leaderboard::updatedRating(player.rating, opponentRating, scoreX, player.ratedGames);
+    player.ratedGames++;
+    leaderboard.setRating(currentUser, player.rating);
+}
+
+int UserAuth::getRating(const QString& username) const {
+    waitForLoad();
+
+    if (!users.contains(username)) {
+        return 0;
+    }
+    return users[username].rating;
+}
+
+int UserAuth::getRank(const QString& username) const {
+    waitForLoad();
+    return leaderboard.rankOf(username);
+}
+
+QVector<LeaderboardEntry> UserAuth::getTopPlayers(int count) const {
+    waitForLoad();
+    return leaderboard.topK(count);
+}
+
+QMap<QString, User> UserAuth::readUsersFile(const QString& path) {
+    TRACE_SCOPE("UserAuth::readUsersFile");
+    // Touches nothing but the file, so it can run on any thread
+    QMap<QString, User> loaded;
+    QFile file(path);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return loaded; // No file yet, that's okay
     }
 
     QByteArray jsonData = file.readAll();
@@ -122,17 +296,89 @@ bool UserAuth::loadUsersFromFile() {
             User user;
             user.username = username;
             user.passwordHash = userObj["passwordHash"].toString();
-            user.gameHistory = userObj["gameHistory"].toArray();
-
-            users[username] = user;
+            // Histories live in their own files and are read at sign-in; one
+            // still inside an older users.json is moved out the first time it is read
+            QString historyPath = historyFilePath(path, username);
+            QJsonArray legacyHistory = userObj["gameHistory"].toArray();
+            if (!legacyHistory.isEmpty() && !QFile::exists(historyPath)) {
+                appendToHistoryFile(historyPath, legacyHistory);
+            }
+            user.rating = userObj["rating"].toInt(1200);
+            user.ratedGames = userObj["ratedGames"].toInt(0);
+
+            loaded[username] = user;
         }
     }
 
     file.close();
-    return true;
+    return loaded;
+}
+
+QString UserAuth::historyFilePath(const QString& usersPath, const QString& username) {
+    // Usernames are letters, digits and underscores, so they are safe as file names
+    return QFileInfo(usersPath).absolutePath() + "/history/" + username + ".ndjson";
+}
+
+QJsonArray UserAuth::readHistoryFile(const QString& path) {
+    QJsonArray history;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return history;
+    }
+    while (!file.atEnd()) {
+        // A line cut short by a crash mid-append is skipped
+        QJsonDocument doc = QJsonDocument::fromJson(file.readLine().trimmed());
+        if (doc.isObject()) {
+            history.append(doc.object());
+        }
+    }
+    return history;
+}
+
+int UserAuth::countHistoryFile(const QString& path) {
+    // The games readHistoryFile() would return, one line at a time
+    int count = 0;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return count;
+    }
+    while (!file.atEnd()) {
+        if (QJsonDocument::fromJson(file.readLine().trimmed()).isObject()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool UserAuth::appendToHistoryFile(const QString& path, const QJsonArray& games) {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+    QByteArray lines;
+    for (const QJsonValue& game : games) {
+        lines.append(QJsonDocument(game.toObject()).toJson(QJsonDocument::Compact));
+        lines.append('\n');
+    }
+    return file.write(lines) == lines.size();
+}
+
+void UserAuth::adoptUsers(const QMap<QString, User>& loaded) const {
+    users = loaded;
+
+    // Ratings are persisted, so the leaderboard never replays history
+    for (auto it = users.constBegin(); it != users.constEnd(); ++it) {
+        if (it->ratedGames > 0) {
+            leaderboard.setRating(it.key(), it->rating);
+        }
+    }
 }
 
 bool UserAuth::saveUsersToFile() {
+    TRACE_SCOPE("UserAuth::saveUsersToFile");
+    QElapsedTimer timer;
+    timer.start();
     QFile file(usersFilePath);
     if (!file.open(QIODevice::WriteOnly)) {
         return false;
@@ -143,14 +389,17 @@ bool UserAuth::saveUsersToFile() {
     for (auto it = users.begin(); it != users.end(); ++it) {
         QJsonObject userObj;
         userObj["passwordHash"] = it.value().passwordHash;
-        userObj["gameHistory"] = it.value().gameHistory;
+        userObj["rating"] = it.value().rating;
+        userObj["ratedGames"] = it.value().ratedGames;
 
         usersObj[it.key()] = userObj;
     }
 
     QJsonDocument doc(usersObj);
-    file.write(doc.toJson());
+    qint64 written = file.write(doc.toJson());
     file.close();
+    AppMetrics::usersSaveBytes.add(qMax<qint64>(0, written));
+    AppMetrics::usersSaveSeconds.observeNs(timer.nsecsElapsed());
 
     return true;
 }
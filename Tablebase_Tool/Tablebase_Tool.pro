@@ -0,0 +1,30 @@
+QT       += core
+QT       += concurrent
+QT       -= gui
+
+CONFIG += c++17
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD/../Header-files_include
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    $$PWD/../Source-code_scr/boardstate.cpp \
+    $$PWD/../Source-code_scr/tablebase.cpp \
+    $$PWD/../Source-code_scr/tablebasegenerator.cpp \
+    tablebase_tool.cpp
+
+HEADERS += \
+    $$PWD/../Header-files_include/boardstate.h \
+    $$PWD/../Header-files_include/gametypes.h \
+    $$PWD/../Header-files_include/tablebase.h \
+    $$PWD/../Header-files_include/tablebasegenerator.h
+
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,78 @@
+// tablebase_tool.cpp - Command line generator for endgame tablebases
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include "tablebasegenerator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("Tablebase_Tool");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Solves every position with up to --empty empty cells and writes "
+                                     "a tablebase the game maps at run time. Re-running the same "
+                                     "command resumes an interrupted file.");
+    parser.addHelpOption();
+    QCommandLineOption sizeOption("size", "Board size (3-8).", "n", "3");
+    QCommandLineOption winOption("win", "Stones in a row needed to win.", "k", "3");
+    QCommandLineOption emptyOption("empty", "Deepest layer, in empty cells.", "cells", "9");
+    QCommandLineOption threadsOption("threads", "Worker threads, 0 for one per core.", "count", "0");
+    QCommandLineOption outputOption("output", "Directory the tablebase is written to.", "dir", ".");
+    QCommandLineOption maxBytesOption("max-mb", "Refuse to build files larger than this.", "mb", "4096");
+    parser.addOption(sizeOption);
+    parser.addOption(winOption);
+    parser.addOption(emptyOption);
+    parser.addOption(threadsOption);
+    parser.addOption(outputOption);
+    parser.addOption(maxBytesOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    int size = parser.value(sizeOption).toInt();
+    int winLength = parser.value(winOption).toInt();
+    if (size < 3 || size > BoardState::MaxSize || winLength < 3 || winLength > size) {
+        err << "Board must be 3x3 to 8x8 with 3 <= k <= size\n";
+        return 1;
+    }
+
+    TablebaseGenerator generator;
+    generator.setBoard(size, winLength);
+    generator.setMaxEmpty(parser.value(emptyOption).toInt());
+    generator.setThreads(parser.value(threadsOption).toInt());
+
+    // Layers grow combinatorially, so check the size before starting
+    quint64 bytes = generator.fileSize();
+    quint64 limit = parser.value(maxBytesOption).toULongLong() * 1024 * 1024;
+    if (bytes > limit) {
+        err << "The tablebase would take " << bytes / (1024 * 1024) << " MB, lower --empty or raise --max-mb\n";
+        return 1;
+    }
+
+    QDir().mkpath(parser.value(outputOption));
+    QString path = QDir(parser.value(outputOption)).filePath(Tablebase::fileName(size, winLength));
+    out << "Writing " << path << " (" << bytes << " bytes)\n";
+    out.flush();
+
+    QElapsedTimer timer;
+    timer.start();
+    QObject::connect(&generator, &TablebaseGenerator::layerFinished,
+                     [&out, &timer](int empty, int maxEmpty, quint64 positions) {
+        out << "Layer " << empty << "/" << maxEmpty << ": " << positions << " positions, "
+            << timer.elapsed() << " ms\n";
+        out.flush();
+    });
+
+    QString error;
+    if (!generator.generate(path, &error)) {
+        err << error << "\n";
+        return 1;
+    }
+
+    out << "Done in " << timer.elapsed() << " ms\n";
+    return 0;
+}
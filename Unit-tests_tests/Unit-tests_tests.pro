@@ -1,4 +1,4 @@
-QT += testlib
+QT += testlib concurrent
 QT -= gui
 
 CONFIG += qt console warn_on depend_includepath testcase
@@ -10,8 +10,46 @@ TEMPLATE = app
 
 SOURCES +=  \
     test_gamelogic.cpp \
-    $$PWD/../Source-code_scr/gamelogic.cpp
+    $$PWD/../Source-code_scr/aidecisionlog.cpp \
+    $$PWD/../Source-code_scr/boardstate.cpp \
+    $$PWD/../Source-code_scr/gameanalyzer.cpp \
+    $$PWD/../Source-code_scr/gamelogic.cpp \
+    $$PWD/../Source-code_scr/gamerecord.cpp \
+    $$PWD/../Source-code_scr/searchengine.cpp \
+    $$PWD/../Source-code_scr/tablebase.cpp \
+    $$PWD/../Source-code_scr/ultimateboard.cpp \
+    $$PWD/../Source-code_scr/ultimateengine.cpp \
+    $$PWD/../Source-code_scr/tablebasegenerator.cpp \
+    $$PWD/../Source-code_scr/gametreeenumerator.cpp \
+    $$PWD/../Source-code_scr/mctsengine.cpp \
+    $$PWD/../Source-code_scr/ponderer.cpp \
+    $$PWD/../Source-code_scr/latencytracker.cpp \
+    $$PWD/../Source-code_scr/historyindex.cpp \
+    $$PWD/../Source-code_scr/tracing.cpp \
+    $$PWD/../Source-code_scr/metrics.cpp \
+    $$PWD/../Source-code_scr/leaderboard.cpp \
+    $$PWD/../Source-code_scr/matchmaker.cpp
 
 HEADERS += \
     test_gamelogic.h \
-    $$PWD/../Header-files_include/gamelogic.h
+    $$PWD/../Header-files_include/aidecisionlog.h \
+    $$PWD/../Header-files_include/boardstate.h \
+    $$PWD/../Header-files_include/gameanalyzer.h \
+    $$PWD/../Header-files_include/gamelogic.h \
+    $$PWD/../Header-files_include/gamerecord.h \
+    $$PWD/../Header-files_include/gametypes.h \
+    $$PWD/../Header-files_include/searchengine.h \
+    $$PWD/../Header-files_include/tablebase.h \
+    $$PWD/../Header-files_include/ultimateboard.h \
+    $$PWD/../Header-files_include/ultimateengine.h \
+    $$PWD/../Header-files_include/tablebasegenerator.h \
+    $$PWD/../Header-files_include/gametreeenumerator.h \
+    $$PWD/../Header-files_include/mctsengine.h \
+    $$PWD/../Header-files_include/ponderer.h \
+    $$PWD/../Header-files_include/latencytracker.h \
+    $$PWD/../Header-files_include/historyindex.h \
+    $$PWD/../Header-files_include/tracing.h \
+    $$PWD/../Header-files_include/metrics.h \
+    $$PWD/../Header-files_include/leaderboard.h \
+    $$PWD/../Header-files_include/matchmaker.h \
+    $$PWD/../Header-files_include/mpmcqueue.h
@@ -1,5 +1,11 @@
 #include "test_gamelogic.h"
 #include <QSignalSpy>
+#include <QThread>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <thread>
 
 void TestGameLogic::initTestCase()
 {
@@ -184,6 +190,10 @@ void TestGameLogic::testReplay()
     QCOMPARE(gameLogic->getCell(1, 1), Player::None);
     QCOMPARE(gameLogic->getCell(0, 1), Player::None);
 
+    QCOMPARE(gameLogic->toBoardState().moveCount(), 1);
+    QCOMPARE(gameLogic->getCurrentPlayer(), Player::O);
+    QVERIFY(!gameLogic->makeMove(2, 2)); // Nothing is played onto an earlier step
+
     // Reset replay
     gameLogic->resetReplay();
     for (int i = 0; i < 3; ++i) {
@@ -191,6 +201,22 @@ void TestGameLogic::testReplay()
             QCOMPARE(gameLogic->getCell(i, j), Player::None);
         }
     }
+    QCOMPARE(gameLogic->toBoardState().hash(), BoardState(3, 3).hash());
+
+    // Back at the last move a finished game is finished again, without ending twice
+    QSignalSpy ended(gameLogic, &GameLogic::gameEnded);
+    gameLogic->replayMove(3);
+    QVERIFY(gameLogic->makeMove(2, 2)); // O
+    QVERIFY(gameLogic->makeMove(0, 2)); // X wins the top row
+    QCOMPARE(ended.count(), 1);
+    gameLogic->replayMove(2);
+    QVERIFY(!gameLogic->isGameOver());
+    QCOMPARE(gameLogic->getWinner(), Player::None);
+    gameLogic->replayMove(5);
+    QVERIFY(gameLogic->isGameOver());
+    QCOMPARE(gameLogic->getWinner(), Player::X);
+    QCOMPARE(gameLogic->toBoardState().moveCount(), 5);
+    QCOMPARE(ended.count(), 1);
 }
 
 void TestGameLogic::testJsonSerialization()
@@ -230,6 +256,1009 @@ void TestGameLogic::testDifficulty()
     QCOMPARE(gameLogic->getDifficulty(), AIDifficulty::Unbeatable);
 }
 
+void TestGameLogic::testMatchmakerConcurrentEnqueue()
+{
+    Matchmaker matchmaker(nullptr, 8192);
+    QSet<QString> matchedPlayers;
+    int duplicates = 0;
+    connect(&matchmaker, &Matchmaker::matchFound, this, [&](const MatchResult& match) {
+        QStringList players;
+        players << match.playerX;
+        if (!match.vsAI) {
+            players << match.playerO;
+        }
+        for (const QString& player : players) {
+            if (matchedPlayers.contains(player)) {
+                duplicates++;
+            }
+            matchedPlayers.insert(player);
+        }
+    });
+
+    // Thousands of players join from several threads at once
+    const int threadCount = 8;
+    const int perThread = 500;
+    QVector<QThread*> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.append(QThread::create([&matchmaker, t, perThread]() {
+            for (int i = 0; i < perThread; ++i) {
+                QString name = QString("player_%1_%2").arg(t).arg(i);
+                matchmaker.enqueue(name, 1000 + (i % 200), MatchMode::TwoPlayer, AIDifficulty::Medium);
+            }
+        }));
+    }
+    for (QThread* thread : threads) {
+        thread->start();
+    }
+    for (QThread* thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    QCOMPARE(matchmaker.getMetrics().queueDepth, qint64(threadCount * perThread));
+
+    // Anyone left without a partner goes to the AI straight away
+    matchmaker.setAIFallbackTimeout(0);
+    matchmaker.processQueues();
+
+    MatchmakerMetrics metrics = matchmaker.getMetrics();
+    QCOMPARE(metrics.queueDepth, qint64(0));
+    QCOMPARE(metrics.waitingPlayers, qint64(0));
+    QCOMPARE(metrics.rejected, qint64(0));
+    QCOMPARE(metrics.playersMatched, qint64(threadCount * perThread));
+    QCOMPARE(matchedPlayers.size(), threadCount * perThread);
+    QCOMPARE(duplicates, 0);
+}
+
+void TestGameLogic::testMatchmakerAIFallback()
+{
+    Matchmaker matchmaker;
+    QVector<MatchResult> matches;
+    connect(&matchmaker, &Matchmaker::matchFound, this, [&](const MatchResult& match) {
+        matches.append(match);
+    });
+
+    // A lone player keeps waiting until the timeout expires
+    QVERIFY(matchmaker.enqueue("lonely", 1200, MatchMode::TwoPlayer, AIDifficulty::Hard));
+    matchmaker.processQueues();
+    QCOMPARE(matches.size(), 0);
+    QCOMPARE(matchmaker.getMetrics().waitingPlayers, qint64(1));
+
+    matchmaker.setAIFallbackTimeout(0);
+    matchmaker.processQueues();
+    QCOMPARE(matches.size(), 1);
+    QCOMPARE(matches[0].playerX, QString("lonely"));
+    QVERIFY(matches[0].vsAI);
+    QCOMPARE(matches[0].difficulty, AIDifficulty::Hard);
+    QCOMPARE(matchmaker.getMetrics().aiFallbacks, qint64(1));
+
+    GameLogic* session = matchmaker.createSession(matches[0], this);
+    QVERIFY(session->isVsAI());
+    QCOMPARE(session->getDifficulty(), AIDifficulty::Hard);
+    delete session;
+}
+
+void TestGameLogic::testLeaderboardRankAndTopK()
+{
+    Leaderboard board;
+    for (int i = 0; i < 200; ++i) {
+        board.setRating(QString("player%1").arg(i), 1000 + (i * 37) % 500);
+    }
+    QCOMPARE(board.size(), 200);
+
+    // Ranks must agree with the order topK walks
+    QVector<LeaderboardEntry> top = board.topK(200);
+    QCOMPARE(top.size(), 200);
+    for (int i = 0; i < top.size(); ++i) {
+        QCOMPARE(top[i].rank, i + 1);
+        QCOMPARE(board.rankOf(top[i].username), i + 1);
+        QCOMPARE(board.entryAt(i + 1).username, top[i].username);
+        if (i > 0) {
+            QVERIFY(top[i - 1].rating >= top[i].rating);
+        }
+    }
+
+    // Updating a rating moves the player without disturbing the count
+    board.setRating("player0", 5000);
+    QCOMPARE(board.size(), 200);
+    QCOMPARE(board.rankOf("player0"), 1);
+    QCOMPARE(board.topK(1).first().username, QString("player0"));
+
+    QVERIFY(board.remove("player0"));
+    QVERIFY(!board.contains("player0"));
+    QCOMPARE(board.rankOf("player0"), 0);
+    QCOMPARE(board.size(), 199);
+
+    // Beating a stronger opponent gains more than beating a weaker one
+    int upset = Leaderboard::updatedRating(1200, 1800, 1.0, 0) - 1200;
+    int expected = Leaderboard::updatedRating(1200, 800, 1.0, 0) - 1200;
+    QVERIFY(upset > expected);
+    QCOMPARE(Leaderboard::updatedRating(1500, 1500, 0.5, 100), 1500);
+}
+
+void TestGameLogic::testRecordValidation()
+{
+    // X takes the top row
+    QJsonArray movesArray;
+    const int cells[5][2] = { {0, 0}, {1, 0}, {0, 1}, {1, 1}, {0, 2} };
+    for (int i = 0; i < 5; ++i) {
+        QJsonObject moveObj;
+        moveObj["row"] = cells[i][0];
+        moveObj["col"] = cells[i][1];
+        moveObj["player"] = (i % 2 == 0) ? "X" : "O";
+        movesArray.append(moveObj);
+    }
+    QJsonObject record;
+    record["vsAI"] = false;
+    record["moves"] = movesArray;
+    record["result"] = "X wins";
+
+    RecordCheck check = GameRecordValidator::check(record);
+    QVERIFY(check.valid);
+    QCOMPARE(check.winner, Player::X);
+
+    // A wrong result is flagged but the moves are still usable
+    record["result"] = "Tie";
+    check = GameRecordValidator::check(record);
+    QVERIFY(!check.valid);
+    QVERIFY(check.resultMismatch);
+    QCOMPARE(check.derivedResult, QString("X wins"));
+    QVERIFY(gameLogic->loadFromJson(record));
+    QCOMPARE(gameLogic->getWinner(), Player::X);
+
+    // Playing an occupied cell is rejected and leaves the game untouched
+    QJsonArray badMoves = movesArray;
+    QJsonObject repeat = badMoves[1].toObject();
+    repeat["row"] = 0;
+    repeat["col"] = 0;
+    badMoves[1] = repeat;
+    record["moves"] = badMoves;
+    record.remove("result");
+    check = GameRecordValidator::check(record);
+    QVERIFY(!check.valid);
+    QVERIFY(!check.resultMismatch);
+    QVERIFY(!gameLogic->loadFromJson(record));
+    QCOMPARE(gameLogic->getMoves().size(), 5);
+
+    // Out of range coordinates and wrong turn order
+    QJsonObject offBoard;
+    offBoard["row"] = 3;
+    offBoard["col"] = 0;
+    offBoard["player"] = "X";
+    record["moves"] = QJsonArray{ offBoard };
+    QVERIFY(!GameRecordValidator::check(record).valid);
+
+    QJsonObject wrongTurn;
+    wrongTurn["row"] = 0;
+    wrongTurn["col"] = 0;
+    wrongTurn["player"] = "O";
+    record["moves"] = QJsonArray{ wrongTurn };
+    QVERIFY(!GameRecordValidator::check(record).valid);
+}
+
+void TestGameLogic::testSearchTimeBudget()
+{
+    SearchEngine engine;
+
+    // O to move with a win on the top row and a loss to block in the middle
+    BoardState state(3, 3);
+    state.play(4); // X
+    state.play(0); // O
+    state.play(3); // X
+    state.play(1); // O
+    state.play(8); // X
+    SearchResult result = engine.search(state, SearchLimits());
+    QCOMPARE(result.cell, 2);
+    QVERIFY(result.exact);
+    QVERIFY(SearchEngine::isWinScore(result.score));
+
+    // The empty 3x3 board is a draw with perfect play
+    result = engine.search(BoardState(3, 3), SearchLimits());
+    QVERIFY(result.exact);
+    QCOMPARE(result.score, 0);
+
+    // A large board cannot be solved, but the budget still yields a move
+    SearchLimits limits;
+    limits.timeBudgetMs = 30;
+    result = engine.search(BoardState(8, 5), limits);
+    QVERIFY(result.cell >= 0 && result.cell < 64);
+    QVERIFY(result.depthCompleted >= 1);
+    QVERIFY(result.timedOut);
+    QVERIFY(!result.exact);
+    QVERIFY(result.depthCompleted < 60);
+
+    // A depth limit stops the deepening early
+    limits.timeBudgetMs = 0;
+    limits.maxDepth = 2;
+    result = engine.search(BoardState(4, 4), limits);
+    QCOMPARE(result.depthCompleted, 2);
+    QVERIFY(!result.exact);
+}
+
+void TestGameLogic::testMoveOrderingReducesNodes()
+{
+    SearchEngine plain;
+    plain.setMoveOrdering(OrderNone);
+    SearchResult unordered = plain.search(BoardState(3, 3), SearchLimits());
+
+    SearchEngine ordered;
+    QCOMPARE(ordered.moveOrdering(), int(OrderAll));
+    SearchResult result = ordered.search(BoardState(3, 3), SearchLimits());
+
+    // Same answer, fewer nodes, and most cutoffs come from the first move
+    QCOMPARE(result.score, unordered.score);
+    QVERIFY(result.stats.nodes < unordered.stats.nodes);
+    QVERIFY(result.stats.cutoffs > 0);
+    QVERIFY(result.stats.firstMoveCutoffRate() > unordered.stats.firstMoveCutoffRate());
+
+    // The gain grows with the board
+    SearchLimits limits;
+    limits.maxDepth = 4;
+    unordered = plain.search(BoardState(6, 4), limits);
+    result = ordered.search(BoardState(6, 4), limits);
+    QVERIFY(result.stats.nodes * 4 < unordered.stats.nodes);
+}
+
+void TestGameLogic::testLargerBoards()
+{
+    gameLogic->setBoardSize(5, 4);
+    QCOMPARE(gameLogic->getBoardSize(), 3); // Only applied by newGame
+    gameLogic->newGame(false);
+    QCOMPARE(gameLogic->getBoardSize(), 5);
+    QCOMPARE(gameLogic->getWinLength(), 4);
+
+    // X builds four in a row on the bottom row while O plays above
+    for (int col = 0; col < 3; ++col) {
+        QVERIFY(gameLogic->makeMove(4, col));
+        QVERIFY(gameLogic->makeMove(0, col));
+    }
+    QVERIFY(!gameLogic->isGameOver());
+    QVERIFY(gameLogic->makeMove(4, 3));
+    QVERIFY(gameLogic->isGameOver());
+    QCOMPARE(gameLogic->getWinner(), Player::X);
+
+    QJsonObject json = gameLogic->getGameAsJson();
+    QCOMPARE(json["boardSize"].toInt(), 5);
+    QCOMPARE(json["winLength"].toInt(), 4);
+    QVERIFY(GameRecordValidator::check(json).valid);
+
+    GameLogic replay;
+    QVERIFY(replay.loadFromJson(json));
+    QCOMPARE(replay.getBoardSize(), 5);
+    QCOMPARE(replay.getCell(4, 3), Player::X);
+    QCOMPARE(replay.getWinner(), Player::X);
+
+    // Loading a replay does not change the size of the next game
+    replay.newGame(false);
+    QCOMPARE(replay.getBoardSize(), 3);
+}
+
+void TestGameLogic::testMonteCarloEngine()
+{
+    MctsEngine engine;
+
+    // Blocking an immediate threat needs no search
+    BoardState state(6, 4);
+    state.play(14); // X
+    state.play(0);  // O
+    state.play(15); // X
+    state.play(35); // O
+    state.play(16); // X threatens 13 and 17
+    MctsResult result = engine.search(state, MctsLimits());
+    QVERIFY(result.tactical);
+    QVERIFY(result.cell == 13 || result.cell == 17);
+
+    // The iteration budget is shared by all threads
+    MctsLimits limits;
+    limits.iterations = 4000;
+    limits.threads = 2;
+    BoardState open(7, 5);
+    open.play(24);
+    result = engine.search(open, limits);
+    QCOMPARE(result.iterations, qint64(4000));
+    QVERIFY(result.cell >= 0 && open.at(result.cell) == Player::None);
+    QCOMPARE(result.reusedTrees, 0);
+
+    // Two moves later the trees are re-rooted instead of rebuilt
+    open.play(result.cell);
+    open.play(open.at(23) == Player::None ? 23 : 25);
+    result = engine.search(open, limits);
+    QVERIFY(result.reusedTrees > 0);
+
+    // A time budget alone bounds the search
+    limits.iterations = 0;
+    limits.timeBudgetMs = 30;
+    result = engine.search(BoardState(8, 5), limits);
+    QVERIFY(result.cell >= 0);
+    QVERIFY(result.iterations > 0);
+
+    // GameLogic can use it as its backend
+    gameLogic->setAIBackend(AIBackend::MonteCarlo);
+    gameLogic->setDifficulty(AIDifficulty::Easy);
+    gameLogic->setBoardSize(6, 4);
+    gameLogic->newGame(true);
+    QVERIFY(gameLogic->makeMove(2, 2));
+    QCOMPARE(gameLogic->getMoves().size(), 2);
+    QVERIFY(gameLogic->getLastMctsSearch().iterations > 0);
+}
+
+void TestGameLogic::testAIDecisionStats()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString logPath = dir.filePath("ai.log");
+
+    // Every AI move reports its search through the signal and the log
+    QSignalSpy spy(gameLogic, &GameLogic::aiDecision);
+    gameLogic->setDecisionLogPath(logPath);
+    gameLogic->setDifficulty(AIDifficulty::Unbeatable);
+    gameLogic->newGame(true);
+    QVERIFY(gameLogic->makeMove(0, 0));
+    QCOMPARE(spy.count(), 1);
+
+    AIDecisionStats stats = gameLogic->getLastDecision();
+    QCOMPARE(stats.backend, QString("alphabeta"));
+    QVERIFY(!stats.randomMove);
+    QCOMPARE(stats.moveNumber, 1);
+    QCOMPARE(stats.cell, gameLogic->getMoves().last().row * 3 + gameLogic->getMoves().last().col);
+    QVERIFY(stats.nodes > 0);
+    QVERIFY(stats.depth > 0);
+    QCOMPARE(stats.candidates.size(), 8);
+    QVERIFY(!stats.principalVariation.isEmpty());
+    QCOMPARE(stats.principalVariation.first(), stats.cell);
+
+    QFile file(logPath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll().count('\n'), 1);
+    file.close();
+
+    // The log rolls over instead of growing without bound
+    AIDecisionLog log;
+    log.setPath(logPath);
+    log.setMaxBytes(1);
+    log.setMaxFiles(2);
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(log.append(stats));
+    }
+    QVERIFY(QFile::exists(logPath + ".1"));
+    QVERIFY(QFile::exists(logPath + ".2"));
+    QVERIFY(!QFile::exists(logPath + ".3"));
+}
+
+void TestGameLogic::testTablebase()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.filePath(Tablebase::fileName(3, 3));
+
+    // Stop half way, then resume from the layers already on disk
+    TablebaseGenerator generator;
+    generator.setBoard(3, 3);
+    generator.setMaxEmpty(9);
+    connect(&generator, &TablebaseGenerator::layerFinished, this, [&generator](int empty) {
+        if (empty == 4) {
+            generator.requestStop();
+        }
+    });
+    QVERIFY(!generator.generate(path));
+    {
+        Tablebase partial;
+        QVERIFY(partial.open(path));
+        QCOMPARE(partial.layersComplete(), 5);
+    }
+    generator.disconnect();
+    QVERIFY(generator.generate(path));
+
+    Tablebase tablebase;
+    QVERIFY(tablebase.open(path));
+    QCOMPARE(tablebase.layersComplete(), 10);
+
+    // The empty board is a draw that lasts all nine plies
+    BoardState state(3, 3);
+    TablebaseEntry value = tablebase.probe(state);
+    QCOMPARE(value.result, TablebaseEntry::Draw);
+    QCOMPARE(value.distance, 9);
+
+    // X to move wins at once on the top row
+    for (int cell : { 0, 3, 1, 4 }) {
+        state.play(cell);
+    }
+    value = tablebase.probe(state);
+    QCOMPARE(value.result, TablebaseEntry::Win);
+    QCOMPARE(value.distance, 1);
+    QCOMPARE(tablebase.bestMove(state), 2);
+
+    // The search agrees with the table on who wins
+    SearchEngine engine;
+    BoardState midgame(3, 3);
+    midgame.play(0);
+    midgame.play(1);
+    SearchResult result = engine.search(midgame, SearchLimits());
+    QCOMPARE(tablebase.probe(midgame).result, TablebaseEntry::Win);
+    QVERIFY(result.score > 0 && SearchEngine::isWinScore(result.score));
+
+    // GameLogic answers covered positions without searching
+    QSignalSpy spy(gameLogic, &GameLogic::aiDecision);
+    gameLogic->setTablebaseDirectory(dir.path());
+    gameLogic->setDifficulty(AIDifficulty::Unbeatable);
+    gameLogic->newGame(true);
+    QVERIFY(gameLogic->hasTablebase());
+    QVERIFY(gameLogic->makeMove(0, 0));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(gameLogic->getLastDecision().backend, QString("tablebase"));
+    QCOMPARE(gameLogic->getLastDecision().cell, 4);
+}
+
+void TestGameLogic::testUltimateVariant()
+{
+    // The square played picks the opponent's board
+    UltimateBoard board;
+    quint64 emptyHash = board.hash();
+    board.play(0);
+    QCOMPARE(board.forcedBoard(), 0);
+    QVERIFY(!board.isLegal(9));
+    QVERIFY(board.isLegal(1));
+
+    // O takes board 0 on its middle row; sending X back there frees the choice
+    for (int cell : { 4, 36, 5, 45, 8, 72, 3, 27 }) {
+        QVERIFY(board.isLegal(cell));
+        board.play(cell);
+    }
+    QCOMPARE(board.boardWinner(0), Player::O);
+    QCOMPARE(board.forcedBoard(), int(UltimateBoard::AnyBoard));
+
+    // Undo restores the hash along with the forced board
+    while (board.moveCount() > 0) {
+        board.undo();
+    }
+    QCOMPARE(board.hash(), emptyHash);
+    QCOMPARE(board.forcedBoard(), int(UltimateBoard::AnyBoard));
+
+    // The engine finishes the game when it can
+    UltimateBoard endgame;
+    for (int cell : { 30, 27, 3, 28, 15, 61, 63, 8, 78, 62, 75, 29, 18, 6, 54, 7, 68, 50, 45 }) {
+        endgame.play(cell);
+    }
+    UltimateEngine engine;
+    SearchResult result = engine.search(endgame, SearchLimits());
+    QCOMPARE(result.cell, 60);
+    QVERIFY(result.exact);
+
+    // GameLogic plays the variant on a 9x9 grid, never without a deadline
+    gameLogic->setDifficulty(AIDifficulty::Unbeatable);
+    gameLogic->setAITimeBudget(0);
+    QCOMPARE(gameLogic->getAITimeBudget(), 1);
+    gameLogic->setAITimeBudget(50);
+    gameLogic->newGame(true, GameVariant::Ultimate);
+    QCOMPARE(gameLogic->getVariant(), GameVariant::Ultimate);
+    QCOMPARE(gameLogic->getBoardSize(), 9);
+    QVERIFY(gameLogic->makeMove(4, 4));
+    QCOMPARE(gameLogic->getMoves().size(), 2);
+    QCOMPARE(gameLogic->getLastDecision().backend, QString("ultimate"));
+
+    // The reply lands in the centre board and picks the next one
+    Move reply = gameLogic->getMoves().last();
+    QVERIFY(reply.row >= 3 && reply.row <= 5 && reply.col >= 3 && reply.col <= 5);
+    QCOMPARE(gameLogic->getForcedBoard(), (reply.row % 3) * 3 + reply.col % 3);
+
+    QJsonObject json = gameLogic->getGameAsJson();
+    QCOMPARE(json["variant"].toString(), QString("ultimate"));
+    QVERIFY(GameRecordValidator::check(json).valid);
+    GameLogic loaded;
+    QVERIFY(loaded.loadFromJson(json));
+    QCOMPARE(loaded.getVariant(), GameVariant::Ultimate);
+    QCOMPARE(loaded.getForcedBoard(), gameLogic->getForcedBoard());
+
+    // A move outside the board the opponent was sent to is rejected
+    int elsewhere = (gameLogic->getForcedBoard() + 1) % 9;
+    QJsonObject move;
+    move["row"] = (elsewhere / 3) * 3;
+    move["col"] = (elsewhere % 3) * 3;
+    move["player"] = "X";
+    QJsonArray moves = json["moves"].toArray();
+    moves.append(move);
+    json["moves"] = moves;
+    json.remove("result");
+    RecordCheck check = GameRecordValidator::check(json);
+    QVERIFY(!check.valid);
+    QCOMPARE(check.error, QString("Move 3 is outside the board it was sent to"));
+}
+
+void TestGameLogic::testMoveHints()
+{
+    // Every opening cell is a draw, and all nine come from one search
+    gameLogic->newGame(false);
+    QVector<RootScore> hints = gameLogic->getMoveHints(12);
+    QCOMPARE(hints.size(), 9);
+    for (const RootScore& hint : hints) {
+        QVERIFY(!hint.upperBound);
+        QCOMPARE(hint.score, 0);
+    }
+
+    // X in opposite corners, O in the centre: O loses only by taking a corner
+    QVERIFY(gameLogic->makeMove(0, 0));
+    QVERIFY(gameLogic->makeMove(1, 1));
+    QVERIFY(gameLogic->makeMove(2, 2));
+    hints = gameLogic->getMoveHints(12);
+    QCOMPARE(hints.size(), 6);
+    for (const RootScore& hint : hints) {
+        bool corner = (hint.cell == 2 || hint.cell == 6);
+        QCOMPARE(hint.score < 0 && SearchEngine::isWinScore(hint.score), corner);
+        QVERIFY(corner || hint.score == 0);
+    }
+
+    // Ultimate hints cover exactly the board the mover was sent to
+    gameLogic->newGame(false, GameVariant::Ultimate);
+    QVERIFY(gameLogic->makeMove(0, 0));
+    hints = gameLogic->getMoveHints(12);
+    QCOMPARE(hints.size(), 8);
+    for (const RootScore& hint : hints) {
+        QVERIFY(hint.cell / 9 < 3 && hint.cell % 9 < 3);
+    }
+
+    // Requested hints arrive through the signal, a position seen before at once
+    gameLogic->newGame(false);
+    QVERIFY(gameLogic->makeMove(0, 0));
+    QVector<QVector<RootScore>> answers;
+    connect(gameLogic, &GameLogic::moveHintsReady, this, [&answers](const QVector<RootScore>& ready) {
+        answers.append(ready);
+    });
+    gameLogic->requestMoveHints(200);
+    QTRY_COMPARE(answers.size(), 1);
+    QCOMPARE(answers[0].size(), 8);
+    gameLogic->requestMoveHints(200);
+    QCOMPARE(answers.size(), 2);
+    QCOMPARE(answers[1].size(), 8);
+
+    // An answer for a position already left is not delivered
+    QVERIFY(gameLogic->makeMove(1, 1));
+    gameLogic->requestMoveHints(20);
+    QVERIFY(gameLogic->makeMove(2, 2));
+    QTest::qWait(200);
+    QCOMPARE(answers.size(), 2);
+}
+
+void TestGameLogic::testPondering()
+{
+    // Every reply that leaves the game open is searched and cached
+    BoardState position(3, 3);
+    position.play(0);
+    position.play(4);
+    SearchLimits limits;
+    limits.timeBudgetMs = 200;
+    Ponderer ponderer;
+    ponderer.start(position, limits);
+    ponderer.waitForFinished();
+    QCOMPARE(ponderer.cachedReplies(), 7);
+
+    // The cached answer is the one a fresh search gives
+    BoardState reply = position;
+    reply.play(8);
+    SearchResult cached;
+    QVERIFY(ponderer.take(reply, &cached));
+    SearchEngine engine;
+    SearchResult fresh = engine.search(reply, limits);
+    QCOMPARE(cached.score, fresh.score);
+    QCOMPARE(ponderer.cachedReplies(), 0);
+
+    ponderer.start(position, limits);
+    ponderer.stop();
+    QVERIFY(!ponderer.isRunning());
+
+    // The human's move is answered from the pondered search
+    gameLogic->setDifficulty(AIDifficulty::Unbeatable);
+    gameLogic->setPonderingEnabled(true);
+    gameLogic->newGame(true);
+    QTRY_VERIFY_WITH_TIMEOUT(!gameLogic->isPonderRunning(), 10000);
+    QVERIFY(gameLogic->makeMove(0, 0));
+    QVERIFY(gameLogic->getLastDecision().pondered);
+    QCOMPARE(gameLogic->getLastDecision().cell, 4);
+    QVERIFY(gameLogic->getLastDecision().searchMs <= gameLogic->getLastDecision().wallMs);
+    QCOMPARE(gameLogic->getLastDecision().toJson()["ponderMs"].toInteger(), gameLogic->getLastDecision().ponderMs);
+
+    // Nothing runs in the background while paused
+    gameLogic->setPonderingPaused(true);
+    QVERIFY(!gameLogic->isPonderRunning());
+    QVERIFY(gameLogic->makeMove(2, 2));
+    QVERIFY(!gameLogic->getLastDecision().pondered);
+    QCOMPARE(gameLogic->getLastDecision().ponderMs, qint64(0));
+}
+
+void TestGameLogic::testBoardChangeCoalescing()
+{
+    QSignalSpy spy(gameLogic, &GameLogic::boardChanged);
+    gameLogic->newGame(true);
+    QTRY_COMPARE(spy.count(), 1);
+    QVERIFY(spy.at(0).at(0).value<BoardChange>().reset);
+    spy.clear();
+
+    // The move and the AI's reply reach listeners as one change, after the event loop runs
+    QVERIFY(gameLogic->makeMove(0, 0));
+    QCOMPARE(spy.count(), 0);
+    QTRY_COMPARE(spy.count(), 1);
+    QTest::qWait(20);
+    QCOMPARE(spy.count(), 1);
+
+    BoardChange change = spy.at(0).at(0).value<BoardChange>();
+    QVERIFY(!change.reset);
+    QCOMPARE(change.cells.size(), 2);
+    QVERIFY(change.cells.contains(0));
+    Move reply = gameLogic->getMoves().last();
+    QVERIFY(change.cells.contains(reply.row * 3 + reply.col));
+    QVERIFY(!change.playerChanged); // X to move again
+    QVERIFY(!change.resultChanged);
+}
+
+void TestGameLogic::testLatencyTracker()
+{
+    // Samples land in power-of-two buckets; 16 ms is a bucket edge so the budget count is exact
+    LatencyHistogram histogram;
+    histogram.add(200000);    // 0.2 ms
+    histogram.add(3000000);   // 3 ms
+    histogram.add(16000000);  // 16 ms, still inside the budget
+    histogram.add(40000000);  // 40 ms
+    QCOMPARE(histogram.count(), qint64(4));
+    QCOMPARE(histogram.countAbove(16.0), qint64(1));
+    QCOMPARE(histogram.percentileMs(0.25), 0.25);
+    QCOMPARE(histogram.percentileMs(0.5), 4.0);
+    QCOMPARE(histogram.percentileMs(1.0), 40.0); // Capped at the slowest sample
+
+    // Stages must come in order, and a cancelled click files nothing
+    LatencyTracker tracker;
+    tracker.begin("Hard");
+    tracker.mark(LatencyTracker::Painted);
+    QVERIFY(tracker.isPending());
+    tracker.cancel();
+    QVERIFY(tracker.categories().isEmpty());
+
+    tracker.begin("Hard");
+    tracker.mark(LatencyTracker::MoveApplied);
+    tracker.mark(LatencyTracker::BoardNotified);
+    tracker.mark(LatencyTracker::Painted);
+    QVERIFY(!tracker.isPending());
+    QCOMPARE(tracker.categories(), QStringList{"Hard"});
+    for (int stage = LatencyTracker::Input; stage < LatencyTracker::StageCount; ++stage) {
+        QCOMPARE(tracker.histogram("Hard", static_cast<LatencyTracker::Stage>(stage))->count(), qint64(1));
+    }
+    QVERIFY(tracker.histogram("Easy", LatencyTracker::Input) == nullptr);
+
+    QTemporaryDir dir;
+    QVERIFY(tracker.exportTo(dir.path() + "/latency.json"));
+    QFile file(dir.path() + "/latency.json");
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+    QCOMPARE(json["categories"].toObject()["Hard"].toObject()["total"].toObject()["count"].toInt(), 1);
+}
+
+void TestGameLogic::testHistoryIndex()
+{
+    HistoryFilter filter = HistoryFilter::parse("  Won HARD 2024-05 ");
+    QCOMPARE(filter.result, QString("X wins"));
+    QCOMPARE(filter.difficulty, QString("Hard"));
+    QCOMPARE(filter.vsAI, 1);
+    QCOMPARE(filter.from, QDateTime(QDate(2024, 5, 1), QTime(0, 0)));
+    QCOMPARE(filter.to, QDateTime(QDate(2024, 6, 1), QTime(0, 0)));
+    QVERIFY(HistoryFilter::parse("2024-0").isEmpty()); // Half-typed dates are ignored
+
+    auto game = [](const QString& date, const QString& result, bool vsAI, const QString& difficulty) {
+        QJsonObject record;
+        record["date"] = date;
+        record["result"] = result;
+        record["vsAI"] = vsAI;
+        if (vsAI) {
+            record["difficulty"] = difficulty;
+        }
+        return record;
+    };
+    QJsonArray history;
+    history.append(game("2024-01-10T10:00:00", "X wins", true, "Easy"));
+    history.append(game("2024-05-02T12:00:00", "X wins", true, "Hard"));
+    history.append(game("2024-05-20T08:00:00", "O wins", false, ""));
+    history.append(game("2023-12-31T23:59:00", "Tie", true, "Hard"));
+    history.append(game("not a date", "X wins", true, "Hard"));
+
+    HistoryIndex index;
+    index.rebuild(history);
+    QCOMPARE(index.size(), 5);
+    QCOMPARE(index.query(HistoryFilter()), (QVector<int>{0, 1, 2, 3, 4}));
+    QCOMPARE(index.query(filter), QVector<int>{1});
+    QCOMPARE(index.query(HistoryFilter::parse("pvp")), QVector<int>{2});
+    QCOMPARE(index.query(HistoryFilter::parse("hard")), (QVector<int>{1, 3, 4}));
+    QCOMPARE(index.query(HistoryFilter::parse("2024")), (QVector<int>{0, 1, 2}));
+    QCOMPARE(index.query(HistoryFilter::parse("..2024-01")), (QVector<int>{0, 3}));
+    QCOMPARE(index.query(HistoryFilter::parse("2024-05-03..")), QVector<int>{2});
+    QVERIFY(index.query(HistoryFilter::parse("incomplete")).isEmpty());
+
+    // Appending keeps every index current, including out-of-order dates
+    index.append(game("2024-05-01T09:00:00", "X wins", true, "Hard"));
+    QCOMPARE(index.query(filter), (QVector<int>{1, 5}));
+
+    // A long history filters to exactly the matching games
+    HistoryIndex large;
+    QDateTime start(QDate(2020, 1, 1), QTime(0, 0));
+    const char* results[] = {"X wins", "O wins", "Tie"};
+    for (int i = 0; i < 100000; ++i) {
+        large.append(game(start.addSecs(i * 600).toString(Qt::ISODate), results[i % 3], i % 2 == 0, "Hard"));
+    }
+    QVector<int> matches = large.query(HistoryFilter::parse("win hard 2020-06..2020-12"));
+    QVERIFY(!matches.isEmpty());
+    for (int match : std::as_const(matches)) {
+        QVERIFY(match % 6 == 0);
+    }
+}
+
+void TestGameLogic::testTracing()
+{
+    // Nothing is kept while tracing is off
+    Tracer::setEnabled(false);
+    Tracer::clear();
+    GameLogic logic;
+    logic.newGame(false);
+    logic.makeMove(0, 0);
+    QCOMPARE(Tracer::eventCount(), 0);
+
+    Tracer::setEnabled(true);
+    logic.makeMove(1, 1);
+    QThread* worker = QThread::create([]() { TRACE_SCOPE("worker"); });
+    worker->setObjectName("Tracing worker");
+    worker->start();
+    QVERIFY(worker->wait(5000));
+    delete worker;
+    Tracer::setEnabled(false);
+    QCOMPARE(Tracer::eventCount(), 2);
+
+    // Complete events on their own thread tracks, named by metadata events
+    QTemporaryDir dir;
+    QVERIFY(Tracer::writeChromeTrace(dir.path() + "/trace.json"));
+    QFile file(dir.path() + "/trace.json");
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QJsonArray events = QJsonDocument::fromJson(file.readAll()).object()["traceEvents"].toArray();
+    QMap<QString, int> spanThreads;
+    QMap<int, QString> threadNames;
+    for (const QJsonValue& value : events) {
+        QJsonObject event = value.toObject();
+        if (event["ph"].toString() == "X") {
+            QVERIFY(event["dur"].toDouble() >= 0);
+            spanThreads[event["name"].toString()] = event["tid"].toInt();
+        } else if (event["ph"].toString() == "M") {
+            threadNames[event["tid"].toInt()] = event["args"].toObject()["name"].toString();
+        }
+    }
+    QCOMPARE(spanThreads.keys(), (QList<QString>{"GameLogic::makeMove", "worker"}));
+    QCOMPARE(threadNames[spanThreads["worker"]], QString("Tracing worker"));
+    QVERIFY(spanThreads["worker"] != spanThreads["GameLogic::makeMove"]);
+
+    Tracer::clear();
+    QCOMPARE(Tracer::eventCount(), 0);
+
+    // Threads that come and go take over the buffers of those that ended
+    Tracer::setEnabled(true);
+    int buffers = Tracer::threadBufferCount();
+    for (int i = 0; i < 8; ++i) {
+        std::thread shortLived([]() { TRACE_SCOPE("short-lived"); });
+        shortLived.join(); // Its thread-local buffer is retired by then
+        Tracer::toChromeTrace();
+    }
+    Tracer::setEnabled(false);
+    QVERIFY(Tracer::threadBufferCount() <= buffers + 1);
+    Tracer::clear();
+}
+
+void TestGameLogic::testMetrics()
+{
+    // Updates are dropped while metrics are off
+    Metrics::setEnabled(false);
+    Metrics::reset();
+    Counter counter("test_events_total", "Events.", "kind=\"a\"");
+    Histogram histogram("test_wait_seconds", "Waits.");
+    counter.add();
+    histogram.observeNs(1000000);
+    QCOMPARE(counter.value(), qint64(0));
+    QCOMPARE(histogram.count(), qint64(0));
+
+    // Shards from several threads add up
+    Metrics::setEnabled(true);
+    QVector<QThread*> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.append(QThread::create([&counter]() {
+            for (int i = 0; i < 1000; ++i) {
+                counter.add();
+            }
+        }));
+        threads.last()->start();
+    }
+    for (QThread* thread : std::as_const(threads)) {
+        QVERIFY(thread->wait(5000));
+        delete thread;
+    }
+    QCOMPARE(counter.value(), qint64(4000));
+
+    histogram.observeNs(300000);    // 0.3 ms
+    histogram.observeNs(20000000);  // 20 ms
+    histogram.observeNs(60000000000LL); // Past the last bound
+    QCOMPARE(histogram.count(), qint64(3));
+
+    GameLogic logic;
+    logic.newGame(false);
+    logic.makeMove(0, 0);
+    logic.makeMove(1, 0);
+    logic.makeMove(0, 1);
+    logic.makeMove(1, 1);
+    logic.makeMove(0, 2);
+    QCOMPARE(AppMetrics::gamesFinished[0].value(), qint64(1));
+    Metrics::setEnabled(false);
+
+    QString text = Metrics::prometheusText();
+    QVERIFY(text.contains("# TYPE test_events_total counter\ntest_events_total{kind=\"a\"} 4000\n"));
+    QVERIFY(text.contains("test_wait_seconds_bucket{le=\"0.0005\"} 1\n"));
+    QVERIFY(text.contains("test_wait_seconds_bucket{le=\"0.025\"} 2\n"));
+    QVERIFY(text.contains("test_wait_seconds_bucket{le=\"+Inf\"} 3\n"));
+    QVERIFY(text.contains("test_wait_seconds_count 3\n"));
+    QVERIFY(text.contains("tictactoe_games_finished_total{result=\"x_wins\"} 1\n"));
+    QString type = "# TYPE tictactoe_games_finished_total";
+    QCOMPARE(text.indexOf(type), text.lastIndexOf(type)); // One family, three series
+
+    QTemporaryDir dir;
+    QVERIFY(Metrics::writePrometheus(dir.path() + "/metrics.prom"));
+    QFile file(dir.path() + "/metrics.prom");
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(QString::fromUtf8(file.readAll()), text);
+    Metrics::reset();
+}
+
+void TestGameLogic::testGameTreeEnumeration()
+{
+    // The known totals for 3x3, with every position agreeing with the reference
+    GameTreeEnumerator enumerator;
+    EnumerationReport report = enumerator.run();
+    QVERIFY2(report.passed(), qPrintable(report.issues.join('\n')));
+    QCOMPARE(report.games, qint64(255168));
+    QCOMPARE(report.xWins, qint64(131184));
+    QCOMPARE(report.oWins, qint64(77904));
+    QCOMPARE(report.draws, qint64(46080));
+    QCOMPARE(report.nodes, qint64(549946));
+    QCOMPARE(report.aiPositions, qint64(4520)); // Distinct positions where the game goes on
+
+    // A depth limit cuts games short; 4x4 is only walked a few plies in
+    enumerator.setBoard(4, 3);
+    enumerator.setMaxDepth(3);
+    enumerator.setAIMaxEmpty(-1);
+    report = enumerator.run();
+    QVERIFY(report.passed());
+    QCOMPARE(report.games, qint64(16 * 15 * 14));
+    QCOMPARE(report.cutOff, report.games);
+}
+
+void TestGameLogic::testUndoRedo()
+{
+    // Two players: one move at a time
+    gameLogic->newGame(false);
+    QVERIFY(!gameLogic->canUndo());
+    for (int cell : { 0, 3, 1, 4 }) {
+        QVERIFY(gameLogic->makeMove(cell / 3, cell % 3));
+    }
+    quint64 hash = gameLogic->toBoardState().hash();
+
+    QVERIFY(gameLogic->undo());
+    QCOMPARE(gameLogic->getCell(1, 1), Player::None);
+    QCOMPARE(gameLogic->getCurrentPlayer(), Player::O);
+    QCOMPARE(gameLogic->getMoves().size(), 3);
+    QCOMPARE(gameLogic->toBoardState().moveCount(), 3);
+
+    QVERIFY(gameLogic->redo());
+    QVERIFY(!gameLogic->canRedo());
+    QCOMPARE(gameLogic->getCurrentPlayer(), Player::X);
+    QCOMPARE(gameLogic->toBoardState().hash(), hash);
+
+    // A finished game ends once, so it cannot be saved or rated twice
+    QSignalSpy ended(gameLogic, &GameLogic::gameEnded);
+    QVERIFY(gameLogic->makeMove(0, 2));
+    QCOMPARE(gameLogic->getWinner(), Player::X);
+    QCOMPARE(ended.count(), 1);
+    QVERIFY(!gameLogic->canUndo());
+    QVERIFY(!gameLogic->undo());
+    QVERIFY(!gameLogic->redo());
+    QVERIFY(gameLogic->isGameOver());
+    QCOMPARE(ended.count(), 1);
+
+    // A new move after an undo drops what could have been redone
+    gameLogic->newGame(false);
+    for (int cell : { 0, 3, 1 }) {
+        QVERIFY(gameLogic->makeMove(cell / 3, cell % 3));
+    }
+    QVERIFY(gameLogic->undo());
+    QVERIFY(gameLogic->undo());
+    QVERIFY(gameLogic->canRedo());
+    QVERIFY(gameLogic->makeMove(2, 2));
+    QVERIFY(!gameLogic->canRedo());
+    QVERIFY(!gameLogic->redo());
+
+    // Against the AI the reply goes with the move, and comes back unsearched
+    gameLogic->setDifficulty(AIDifficulty::Unbeatable);
+    gameLogic->setAITimeBudget(50);
+    gameLogic->newGame(true);
+    QVERIFY(gameLogic->makeMove(1, 1));
+    QCOMPARE(gameLogic->getMoves().size(), 2);
+    Move reply = gameLogic->getMoves().last();
+    QVERIFY(gameLogic->undo());
+    QVERIFY(gameLogic->getMoves().isEmpty());
+    QCOMPARE(gameLogic->getCurrentPlayer(), Player::X);
+    QCOMPARE(gameLogic->toBoardState().hash(), BoardState(3, 3).hash());
+    QVERIFY(!gameLogic->canUndo());
+
+    QVERIFY(gameLogic->redo());
+    QCOMPARE(gameLogic->getMoves().size(), 2);
+    QCOMPARE(gameLogic->getCell(reply.row, reply.col), Player::O);
+    QCOMPARE(gameLogic->getCurrentPlayer(), Player::X);
+}
+
+void TestGameLogic::testGameAnalysis()
+{
+    // O fails to block the top row, then X misses the win and loses to O's middle row
+    auto game = [](const QVector<int>& cells) {
+        QJsonArray movesArray;
+        for (int i = 0; i < cells.size(); ++i) {
+            QJsonObject moveObj;
+            moveObj["row"] = cells[i] / 3;
+            moveObj["col"] = cells[i] % 3;
+            moveObj["player"] = (i % 2 == 0) ? "X" : "O";
+            movesArray.append(moveObj);
+        }
+        QJsonObject record;
+        record["vsAI"] = false;
+        record["moves"] = movesArray;
+        return record;
+    };
+    QJsonObject blunders = game({ 0, 4, 1, 3, 8, 5 });
+    QVector<MoveAnalysis> details;
+    GameAnalysis analysis = GameAnalyzer::analyzeGame(blunders, GameAnalyzer::DefaultSearchDepth, &details);
+    QVERIFY(analysis.valid);
+    QCOMPARE(details.size(), 6);
+    QVERIFY(details[3].blunder);
+    QCOMPARE(details[3].bestCell, 2);
+    QVERIFY(details[4].missedWin);
+    QCOMPARE(details[4].bestCell, 2);
+    QVERIFY(details[5].accurate);
+    QCOMPARE(analysis.accuracy(Player::X), 66);
+    QCOMPARE(analysis.accuracy(Player::O), 66);
+    QCOMPARE(analysis.blunders[1], 1);
+    QCOMPARE(analysis.missedWins[0], 1);
+
+    // Copies of a game are analyzed once, and the summaries survive in the cache file
+    QTemporaryDir dir;
+    QString cacheFile = dir.filePath("analysis.json");
+    QVector<QJsonObject> history = { blunders, game({ 4, 0, 8, 2, 1, 7, 6, 3, 5 }), blunders };
+    {
+        GameAnalyzer analyzer;
+        analyzer.setCacheFile(cacheFile);
+        QSignalSpy finished(&analyzer, &GameAnalyzer::finished);
+        analyzer.analyze(history);
+        QTRY_COMPARE(finished.count(), 1);
+        QCOMPARE(finished.at(0).at(0).toBool(), false);
+        QCOMPARE(analyzer.analyzedGames(), qint64(2));
+        QCOMPARE(analyzer.cachedGames(), 2);
+        QCOMPARE(analyzer.analysis(GameAnalyzer::gameKey(blunders)).missedWins[0], 1);
+    }
+
+    GameAnalyzer reloaded;
+    reloaded.setCacheFile(cacheFile);
+    QVERIFY(reloaded.contains(GameAnalyzer::gameKey(history[1])));
+    QSignalSpy finished(&reloaded, &GameAnalyzer::finished);
+    reloaded.analyze(history);
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(reloaded.analyzedGames(), qint64(0));
+
+    // Cancelling reports at once and leaves nothing running
+    reloaded.setSearchDepth(2);
+    QCOMPARE(reloaded.cachedGames(), 0);
+    reloaded.analyze(history);
+    QVERIFY(reloaded.isRunning());
+    reloaded.cancel();
+    QVERIFY(!reloaded.isRunning());
+    QCOMPARE(finished.count(), 2);
+    QCOMPARE(finished.at(1).at(0).toBool(), true);
+    reloaded.waitForFinished();
+}
+
 // Register the test class
 QTEST_MAIN(TestGameLogic)
-
@@ -4,6 +4,16 @@
 #include <QTest>
 #include <QObject>
 #include "gamelogic.h"
+#include "matchmaker.h"
+#include "leaderboard.h"
+#include "gamerecord.h"
+#include "tablebasegenerator.h"
+#include "latencytracker.h"
+#include "historyindex.h"
+#include "tracing.h"
+#include "metrics.h"
+#include "gametreeenumerator.h"
+#include "gameanalyzer.h"
 
 class TestGameLogic : public QObject
 {
@@ -27,6 +37,27 @@ private slots:
     void testReplay();
     void testJsonSerialization();
     void testDifficulty();
+    void testMatchmakerConcurrentEnqueue();
+    void testMatchmakerAIFallback();
+    void testLeaderboardRankAndTopK();
+    void testRecordValidation();
+    void testSearchTimeBudget();
+    void testMoveOrderingReducesNodes();
+    void testLargerBoards();
+    void testMonteCarloEngine();
+    void testAIDecisionStats();
+    void testTablebase();
+    void testUltimateVariant();
+    void testMoveHints();
+    void testPondering();
+    void testBoardChangeCoalescing();
+    void testLatencyTracker();
+    void testHistoryIndex();
+    void testTracing();
+    void testMetrics();
+    void testGameTreeEnumeration();
+    void testUndoRedo();
+    void testGameAnalysis();
 
 private:
     GameLogic *gameLogic;